@@ -0,0 +1,79 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <chrono>
+#include <ostream>
+#include <streambuf>
+#include <string>
+
+#include "bench_memory.hpp"
+#include "factory.hpp"
+#include "simulation.hpp"
+#include "topology_generator.hpp"
+
+namespace {
+    class DiscardBuffer : public std::streambuf {
+    protected:
+        std::streamsize xsputn(const char *, std::streamsize n) override { return n; }
+
+        int_type overflow(int_type c) override { return traits_type::not_eof(c); }
+    };
+
+    /**
+     * Mierzy fazę: czas ściany do licznika `<name>_ms` i szczytowe RSS w trakcie fazy do `<name>_peak_rss_mib`
+     */
+    template<class Phase>
+    void measure(benchmark::State &state, const char *name, bool &rss_per_phase, Phase phase) {
+        rss_per_phase = bench::reset_peak_rss() && rss_per_phase;
+        const auto start = std::chrono::steady_clock::now();
+        phase();
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+        state.counters[std::string(name) + "_ms"] = std::chrono::duration<double, std::milli>(elapsed).count();
+        state.counters[std::string(name) + "_peak_rss_mib"] = static_cast<double>(bench::peak_rss_kib()) / 1024;
+    }
+}
+
+/**
+ * Pełny przebieg dla wygenerowanej struktury o zadanej liczbie węzłów: generowanie tekstu, wczytanie,
+ * sprawdzenie spójności, 100 tur symulacji i zapis struktury. Po 5% węzłów to rampy i magazyny, reszta to
+ * robotnicy w (co najwyżej) 10 warstwach, fan-out 2, 5% połączeń wstecznych.
+ * Bez resetu szczytowego RSS (brak /proc/self/clear_refs) liczniki RSS są narastające - patrz etykieta.
+ */
+static void BM_EndToEnd(benchmark::State &state) {
+    const auto nodes = static_cast<std::size_t>(state.range(0));
+    TopologyOptions options;
+    options.ramps = std::max<std::size_t>(1, nodes / 20);
+    options.storehouses = std::max<std::size_t>(1, nodes / 20);
+    options.workers = nodes - options.ramps - options.storehouses;
+    options.depth = std::min<std::size_t>(options.workers, 10);
+    options.fan_out = 2;
+    options.back_edge_probability = 0.05;
+    options.lifo_probability = 0.5;
+    options.delivery_interval = parse_time_distribution("uniform:1-3");
+    options.processing_time = parse_time_distribution("uniform:1-4");
+
+    bool rss_per_phase = true;
+    for (auto _: state) {
+        std::string text;
+        measure(state, "generate", rss_per_phase, [&] { text = generate_factory_structure(options); });
+        Factory factory;
+        measure(state, "load", rss_per_phase, [&] { factory = load_factory_structure(std::string_view(text)); });
+        text = std::string();
+        measure(state, "check", rss_per_phase, [&] {
+            if (!factory.is_consistent()) {
+                state.SkipWithError("generated structure is inconsistent");
+            }
+        });
+        factory.set_routing_seed(1);
+        measure(state, "simulate", rss_per_phase, [&] { simulate(factory, 100, [](Factory &, Time) {}); });
+        measure(state, "save", rss_per_phase, [&] {
+            DiscardBuffer buffer;
+            std::ostream os(&buffer);
+            save_factory_structure(factory, os);
+        });
+    }
+    state.counters["nodes"] = static_cast<double>(nodes);
+    state.SetLabel(rss_per_phase ? "rss per phase" : "rss cumulative");
+}
+
+BENCHMARK(BM_EndToEnd)->RangeMultiplier(10)->Range(10, 1000000)->Iterations(1)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,673 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "factory.hpp"
+#include "factory_binary.hpp"
+#include "simulation.hpp"
+
+namespace {
+    /**
+     * Warstwowa fabryka: `width` ramp -> `layers` warstw po `width` robotników -> `width` magazynów.
+     * Każdy węzeł ma dwóch odbiorców w następnej warstwie.
+     */
+    Factory make_layered_factory(int width, int layers, TimeOffset di = 2, TimeOffset pd = 1) {
+        Factory factory;
+        for (int i = 1; i <= width; ++i) {
+            factory.add_ramp(Ramp(i, di));
+            factory.add_storehouse(Storehouse(i));
+        }
+        for (int layer = 0; layer < layers; ++layer) {
+            for (int i = 1; i <= width; ++i) {
+                auto type = layer % 2 == 0 ? PackageQueueType::FIFO : PackageQueueType::LIFO;
+                factory.add_worker(Worker(layer * width + i, pd, std::make_unique<PackageQueue>(type)));
+            }
+        }
+        auto next_of = [&factory, width, layers](int layer, int i) -> IPackageReceiver * {
+            int index = i % width + 1;
+            if (layer == layers) {
+                return &(*factory.find_storehouse_by_id(index));
+            }
+            return &(*factory.find_worker_by_id(layer * width + index));
+        };
+        for (int i = 1; i <= width; ++i) {
+            auto &prefs = factory.find_ramp_by_id(i)->receiver_preferences_;
+            prefs.add_receiver(next_of(0, i - 1));
+            prefs.add_receiver(next_of(0, i));
+        }
+        for (int layer = 0; layer < layers; ++layer) {
+            for (int i = 1; i <= width; ++i) {
+                auto &prefs = factory.find_worker_by_id(layer * width + i)->receiver_preferences_;
+                prefs.add_receiver(next_of(layer + 1, i - 1));
+                prefs.add_receiver(next_of(layer + 1, i));
+            }
+        }
+        return factory;
+    }
+
+    /**
+     * Tekstowy opis łańcucha: rampa -> `workers` robotników -> magazyn, każdy robotnik linkuje do następnego
+     * oraz do robotnika o połowę indeksu niżej (połowa linków wskazuje daleko w kolekcji).
+     */
+    std::string make_chain_structure(int workers) {
+        std::ostringstream oss;
+        oss << "LOADING_RAMP id=1 delivery-interval=1\n";
+        for (int i = 1; i <= workers; ++i) {
+            oss << "WORKER id=" << i << " processing-time=1 queue-type=FIFO\n";
+        }
+        oss << "STOREHOUSE id=1\n";
+        oss << "LINK src=ramp-1 dest=worker-1\n";
+        for (int i = 1; i <= workers; ++i) {
+            if (i < workers) {
+                oss << "LINK src=worker-" << i << " dest=worker-" << i + 1 << "\n";
+            } else {
+                oss << "LINK src=worker-" << i << " dest=store-1\n";
+            }
+            oss << "LINK src=worker-" << i << " dest=worker-" << i / 2 + 1 << "\n";
+        }
+        return oss.str();
+    }
+
+    /**
+     * Poprzedni loader (getline + parse_line + std::stoi), zachowany jako punkt odniesienia.
+     */
+    Factory load_factory_structure_legacy(std::istream &is) {
+        Factory factory;
+        std::string line;
+        auto split_ref = [](const std::string &ref) {
+            std::istringstream iss(ref);
+            std::string type;
+            std::string id;
+            std::getline(iss, type, '-');
+            std::getline(iss, id, '-');
+            return std::make_pair(type, static_cast<ElementID>(std::stoi(id)));
+        };
+        while (std::getline(is, line)) {
+            if (line.empty() || line[0] == ';') {
+                continue;
+            }
+            ParsedLineData data = parse_line(line);
+            switch (data.type) {
+                case ElementType::RAMP:
+                    factory.add_ramp(Ramp(std::stoi(data.data.at("id")), std::stoi(data.data.at("delivery-interval"))));
+                    break;
+                case ElementType::WORKER:
+                    factory.add_worker(Worker(std::stoi(data.data.at("id")), std::stoi(data.data.at("processing-time")),
+                                              std::make_unique<PackageQueue>(QUEUE_TYPE_NAMES.at(data.data.at("queue-type")))));
+                    break;
+                case ElementType::STOREHOUSE:
+                    factory.add_storehouse(Storehouse(std::stoi(data.data.at("id"))));
+                    break;
+                case ElementType::LINK: {
+                    auto src = split_ref(data.data.at("src"));
+                    auto dest = split_ref(data.data.at("dest"));
+                    IPackageReceiver *receiver = dest.first == "worker"
+                                                 ? static_cast<IPackageReceiver *>(&*factory.find_worker_by_id(dest.second))
+                                                 : &*factory.find_storehouse_by_id(dest.second);
+                    if (src.first == "ramp") {
+                        factory.find_ramp_by_id(src.second)->receiver_preferences_.add_receiver(receiver);
+                    } else {
+                        factory.find_worker_by_id(src.second)->receiver_preferences_.add_receiver(receiver);
+                    }
+                    break;
+                }
+            }
+        }
+        return factory;
+    }
+
+    /**
+     * Poprzedni zapis struktury (ostringstream na każdą linię, sortowanie napisów), jako punkt odniesienia.
+     */
+    void save_factory_structure_legacy(const Factory &factory, std::ostream &os) {
+        std::vector<std::string> links;
+        auto add_links = [&links](const std::string &src, const PackageSender &sender) {
+            for (const auto &receiver: sender.receiver_preferences_) {
+                std::ostringstream oss;
+                oss << "LINK src=" << src << " dest=" << RECEIVER_TYPE_NAMES_IO.at(receiver.first->get_receiver_type())
+                    << "-" << receiver.first->get_id() << "\n";
+                links.push_back(oss.str());
+            }
+        };
+        auto write_sorted = [&os](std::vector<std::string> &lines) {
+            std::sort(lines.begin(), lines.end());
+            for (const auto &line: lines) {
+                os << line;
+            }
+        };
+
+        os << "\n; == LOADING RAMPS ==\n\n";
+        std::vector<std::string> lines;
+        for (auto it = factory.ramp_cbegin(); it != factory.ramp_cend(); ++it) {
+            std::ostringstream oss;
+            oss << "LOADING_RAMP id=" << it->get_id() << " delivery-interval=" << it->get_delivery_interval() << "\n";
+            lines.push_back(oss.str());
+            add_links("ramp-" + std::to_string(it->get_id()), *it);
+        }
+        write_sorted(lines);
+
+        os << "\n; == WORKERS ==\n\n";
+        lines.clear();
+        for (auto it = factory.worker_cbegin(); it != factory.worker_cend(); ++it) {
+            std::ostringstream oss;
+            oss << "WORKER id=" << it->get_id() << " processing-time=" << it->get_processing_duration()
+                << " queue-type=" << (it->get_queue()->get_queue_type() == PackageQueueType::FIFO ? "FIFO" : "LIFO")
+                << "\n";
+            lines.push_back(oss.str());
+            add_links("worker-" + std::to_string(it->get_id()), *it);
+        }
+        write_sorted(lines);
+
+        os << "\n; == STOREHOUSES ==\n\n";
+        lines.clear();
+        for (auto it = factory.storehouse_cbegin(); it != factory.storehouse_cend(); ++it) {
+            std::ostringstream oss;
+            oss << "STOREHOUSE id=" << it->get_id() << "\n";
+            lines.push_back(oss.str());
+        }
+        write_sorted(lines);
+
+        os << "\n; == LINKS ==\n";
+        write_sorted(links);
+        os.flush();
+    }
+
+    /**
+     * Strumień, który tylko zlicza zapisane bajty.
+     */
+    class CountingBuffer : public std::streambuf {
+    public:
+        std::size_t count = 0;
+
+    protected:
+        int_type overflow(int_type c) override {
+            ++count;
+            return traits_type::not_eof(c);
+        }
+
+        std::streamsize xsputn(const char *, std::streamsize n) override {
+            count += static_cast<std::size_t>(n);
+            return n;
+        }
+    };
+}
+
+/**
+ * Pełny przebieg symulacji (dostawy, przekazywanie, praca) przez 1000 tur; argument: szerokość warstwy.
+ */
+static void BM_Factory_Run(benchmark::State &state) {
+    const int width = static_cast<int>(state.range(0));
+    const Time turns = 1000;
+    for (auto _: state) {
+        state.PauseTiming();
+        Factory factory = make_layered_factory(width, 8);
+        state.ResumeTiming();
+        for (Time t = 1; t <= turns; ++t) {
+            factory.do_deliveries(t);
+            factory.do_package_passing();
+            factory.do_work(t);
+        }
+        state.PauseTiming();
+        factory = Factory();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * turns);
+}
+
+BENCHMARK(BM_Factory_Run)->Arg(16)->Arg(128)->Arg(1024)->Unit(benchmark::kMillisecond);
+
+/**
+ * Jak BM_Factory_Run, ale ze śledzeniem cyklu życia paczek - różnica czasu to koszt znaczników i histogramów.
+ * Liczniki: percentyle czasu od dostawy do magazynu (z ostatniej iteracji) i liczba paczek w histogramie.
+ */
+static void BM_Factory_RunLatencyTracking(benchmark::State &state) {
+    const int width = static_cast<int>(state.range(0));
+    const Time turns = 1000;
+    LatencyHistogram end_to_end;
+    for (auto _: state) {
+        state.PauseTiming();
+        Factory factory = make_layered_factory(width, 8);
+        factory.set_latency_tracking(true);
+        state.ResumeTiming();
+        for (Time t = 1; t <= turns; ++t) {
+            factory.do_deliveries(t);
+            factory.do_package_passing();
+            factory.do_work(t);
+        }
+        state.PauseTiming();
+        end_to_end = LatencyHistogram();
+        for (auto it = factory.storehouse_cbegin(); it != factory.storehouse_cend(); ++it) {
+            end_to_end.merge(it->get_latency()->end_to_end);
+        }
+        factory = Factory();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * turns);
+    state.counters["stored"] = static_cast<double>(end_to_end.count());
+    state.counters["p50"] = static_cast<double>(end_to_end.percentile(0.5));
+    state.counters["p99"] = static_cast<double>(end_to_end.percentile(0.99));
+    state.counters["p999"] = static_cast<double>(end_to_end.percentile(0.999));
+}
+
+BENCHMARK(BM_Factory_RunLatencyTracking)->Arg(16)->Arg(128)->Arg(1024)->Unit(benchmark::kMillisecond);
+
+/**
+ * Tury fabryki z 8 warstwami robotników wykonywane na puli wątków; argumenty: szerokość warstwy, liczba wątków.
+ * Licznik `workers` pozwala zestawić skalowanie względem liczby wątków dla różnych rozmiarów fabryki.
+ */
+static void BM_Factory_RunThreads(benchmark::State &state) {
+    const int width = static_cast<int>(state.range(0));
+    const auto threads = static_cast<std::size_t>(state.range(1));
+    const Time turns = 50;
+    for (auto _: state) {
+        state.PauseTiming();
+        Factory factory = make_layered_factory(width, 8);
+        factory.set_thread_count(threads);
+        state.ResumeTiming();
+        for (Time t = 1; t <= turns; ++t) {
+            factory.do_deliveries(t);
+            factory.do_package_passing();
+            factory.do_work(t);
+        }
+        state.PauseTiming();
+        factory = Factory();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * turns);
+    state.counters["workers"] = static_cast<double>(8 * width);
+    state.counters["threads"] = static_cast<double>(threads);
+}
+
+BENCHMARK(BM_Factory_RunThreads)->ArgsProduct({{1250, 12500}, {1, 2, 4, 8, 16}})->ArgNames({"width", "threads"})
+        ->UseRealTime()->Unit(benchmark::kMillisecond);
+
+/**
+ * Rzadka fabryka (dostawy co 50 tur, pd = 7): przez większość tur większość węzłów nic nie robi.
+ * Argumenty: szerokość warstwy, silnik symulacji.
+ */
+static void BM_Simulate_Sparse(benchmark::State &state) {
+    const int width = static_cast<int>(state.range(0));
+    const auto engine = static_cast<SimulationEngine>(state.range(1));
+    const TimeOffset turns = 1000;
+    for (auto _: state) {
+        state.PauseTiming();
+        Factory factory = make_layered_factory(width, 8, 50, 7);
+        state.ResumeTiming();
+        simulate(factory, turns, {}, engine);
+        state.PauseTiming();
+        factory = Factory();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * turns);
+}
+
+BENCHMARK(BM_Simulate_Sparse)
+        ->ArgsProduct({{16, 128, 1024}, {static_cast<int>(SimulationEngine::TURN_BASED),
+                                          static_cast<int>(SimulationEngine::EVENT_DRIVEN)}})
+        ->Unit(benchmark::kMillisecond);
+
+/**
+ * Wczytanie struktury łańcucha robotników (ok. 3 linie na robotnika, 333333 robotników to ok. 1M linii).
+ * Mierzone jest samo wczytanie - niszczenie fabryki odbywa się z zatrzymanym pomiarem.
+ */
+template<class Load>
+void load_structure(benchmark::State &state, Load load) {
+    const std::string structure = make_chain_structure(static_cast<int>(state.range(0)));
+    for (auto _: state) {
+        std::optional<Factory> factory(load(structure));
+        benchmark::DoNotOptimize(*factory);
+        state.PauseTiming();
+        factory.reset();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+static void BM_LoadFactoryStructure(benchmark::State &state) {
+    load_structure(state, [](const std::string &structure) {
+        std::istringstream iss(structure);
+        return load_factory_structure(iss);
+    });
+}
+
+BENCHMARK(BM_LoadFactoryStructure)->RangeMultiplier(4)->Range(256, 16384)->Arg(333333)->Unit(benchmark::kMillisecond);
+
+static void BM_LoadFactoryStructure_View(benchmark::State &state) {
+    load_structure(state, [](const std::string &structure) {
+        return load_factory_structure(std::string_view(structure));
+    });
+}
+
+BENCHMARK(BM_LoadFactoryStructure_View)->RangeMultiplier(4)->Range(256, 16384)->Arg(333333)->Unit(benchmark::kMillisecond);
+
+/**
+ * Poprzedni loader (getline + parse_line + std::stoi).
+ */
+static void BM_LoadFactoryStructure_Legacy(benchmark::State &state) {
+    load_structure(state, [](const std::string &structure) {
+        std::istringstream iss(structure);
+        return load_factory_structure_legacy(iss);
+    });
+}
+
+BENCHMARK(BM_LoadFactoryStructure_Legacy)->RangeMultiplier(4)->Range(256, 16384)->Arg(333333)->Unit(benchmark::kMillisecond);
+
+/**
+ * Wczytanie z pliku: tekstowego (jeden odczyt + parsowanie) i binarnego (mmap, bez parsowania pól).
+ */
+template<bool Binary>
+void load_structure_file(benchmark::State &state) {
+    const std::string path = (std::filesystem::temp_directory_path() /
+                              (Binary ? "netsim_bench_structure.bin" : "netsim_bench_structure.txt")).string();
+    {
+        std::ofstream file(path, std::ios::binary);
+        if (Binary) {
+            save_factory_structure_binary(load_factory_structure(std::string_view(
+                    make_chain_structure(static_cast<int>(state.range(0))))), file);
+        } else {
+            file << make_chain_structure(static_cast<int>(state.range(0)));
+        }
+    }
+    for (auto _: state) {
+        std::optional<Factory> factory(Binary ? load_factory_structure_binary_file(path)
+                                              : load_factory_structure_file(path));
+        benchmark::DoNotOptimize(*factory);
+        state.PauseTiming();
+        factory.reset();
+        state.ResumeTiming();
+    }
+    std::filesystem::remove(path);
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+static void BM_LoadFactoryStructure_TextFile(benchmark::State &state) { load_structure_file<false>(state); }
+
+BENCHMARK(BM_LoadFactoryStructure_TextFile)->RangeMultiplier(16)->Range(256, 65536)->Arg(333333)
+        ->Unit(benchmark::kMillisecond);
+
+static void BM_LoadFactoryStructure_BinaryFile(benchmark::State &state) { load_structure_file<true>(state); }
+
+BENCHMARK(BM_LoadFactoryStructure_BinaryFile)->RangeMultiplier(16)->Range(256, 65536)->Arg(333333)
+        ->Unit(benchmark::kMillisecond);
+
+/**
+ * Zapis struktury łańcucha robotników do strumienia zliczającego bajty; 333333 robotników to ok. 1M linii.
+ */
+template<class Save>
+void save_structure(benchmark::State &state, Save save) {
+    const Factory factory = load_factory_structure(std::string_view(make_chain_structure(static_cast<int>(state.range(0)))));
+    for (auto _: state) {
+        CountingBuffer buffer;
+        std::ostream os(&buffer);
+        save(factory, os);
+        benchmark::DoNotOptimize(buffer.count);
+        state.SetBytesProcessed(state.bytes_processed() + static_cast<int64_t>(buffer.count));
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+static void BM_SaveFactoryStructure(benchmark::State &state) {
+    save_structure(state, [](const Factory &factory, std::ostream &os) { save_factory_structure(factory, os); });
+}
+
+BENCHMARK(BM_SaveFactoryStructure)->RangeMultiplier(16)->Range(256, 65536)->Arg(333333)->Unit(benchmark::kMillisecond);
+
+static void BM_SaveFactoryStructure_Legacy(benchmark::State &state) {
+    save_structure(state, [](const Factory &factory, std::ostream &os) { save_factory_structure_legacy(factory, os); });
+}
+
+BENCHMARK(BM_SaveFactoryStructure_Legacy)->RangeMultiplier(16)->Range(256, 65536)->Arg(333333)
+        ->Unit(benchmark::kMillisecond);
+
+/**
+ * Pełne sprawdzenie spójności łańcucha robotników (każdy ma też krawędź wstecz); argument: liczba robotników.
+ * Przy 1M robotników trwa setki milisekund (Release: 239 ms; połowa to przejście po std::list i std::map
+ * preferencji), nie pojedyncze milisekundy - tani jest dopiero przyrostowy is_consistent() po edycji.
+ */
+static void BM_Factory_FindInconsistentNodes(benchmark::State &state) {
+    const Factory factory = load_factory_structure(std::string_view(make_chain_structure(static_cast<int>(state.range(0)))));
+    for (auto _: state) {
+        benchmark::DoNotOptimize(factory.find_inconsistent_nodes());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(BM_Factory_FindInconsistentNodes)->RangeMultiplier(16)->Range(256, 1 << 20)->Unit(benchmark::kMillisecond);
+
+/**
+ * Edycja w edytorze: odpięcie i ponowne podpięcie jednego linku ze środka łańcucha, po każdej zmianie
+ * is_consistent() (status przyrostowy). Argument: liczba robotników.
+ */
+static void BM_Factory_EditThenIsConsistent(benchmark::State &state) {
+    const int workers = static_cast<int>(state.range(0));
+    Factory factory = load_factory_structure(std::string_view(make_chain_structure(workers)));
+    Worker &sender = *factory.find_worker_by_id(workers / 2);
+    IPackageReceiver *receiver = &*factory.find_worker_by_id(workers / 2 + 1);
+    for (auto _: state) {
+        sender.receiver_preferences_.remove_receiver(receiver);
+        benchmark::DoNotOptimize(factory.is_consistent());
+        sender.receiver_preferences_.add_receiver(receiver);
+        benchmark::DoNotOptimize(factory.is_consistent());
+    }
+    state.SetItemsProcessed(state.iterations() * 2);
+}
+
+BENCHMARK(BM_Factory_EditThenIsConsistent)->RangeMultiplier(16)->Range(256, 1 << 20);
+
+/**
+ * Jak wyżej, ale obok spójnej części rampa -> magazyn leży osobny łańcuch robotników bez rampy powyżej,
+ * którego ostatni robotnik nie ma odbiorców. Edytowany jest link rampy niezwiązany z łańcuchem - werdykt
+ * ostatniego robotnika jest zapamiętany, więc koszt nie może rosnąć z długością łańcucha (argument).
+ */
+static void BM_Factory_EditThenIsConsistent_Dangling(benchmark::State &state) {
+    const auto workers = static_cast<ElementID>(state.range(0));
+    Factory factory;
+    factory.add_ramp(Ramp(1, 1));
+    factory.add_storehouse(Storehouse(1));
+    factory.add_storehouse(Storehouse(2));
+    factory.reserve(1, static_cast<std::size_t>(workers), 2);
+    for (ElementID id = 1; id <= workers; ++id) {
+        factory.add_worker(Worker(id, 1, std::make_unique<PackageQueue>(PackageQueueType::FIFO)));
+    }
+    for (ElementID id = 1; id < workers; ++id) {
+        factory.find_worker_by_id(id)->receiver_preferences_.add_receiver(&*factory.find_worker_by_id(id + 1));
+    }
+    Ramp &ramp = *factory.find_ramp_by_id(1);
+    ramp.receiver_preferences_.add_receiver(&*factory.find_storehouse_by_id(1));
+    IPackageReceiver *receiver = &*factory.find_storehouse_by_id(2);
+    benchmark::DoNotOptimize(factory.is_consistent());
+    for (auto _: state) {
+        ramp.receiver_preferences_.add_receiver(receiver);
+        benchmark::DoNotOptimize(factory.is_consistent());
+        ramp.receiver_preferences_.remove_receiver(receiver);
+        benchmark::DoNotOptimize(factory.is_consistent());
+    }
+    state.SetItemsProcessed(state.iterations() * 2);
+}
+
+BENCHMARK(BM_Factory_EditThenIsConsistent_Dangling)->RangeMultiplier(16)->Range(256, 1 << 20);
+
+/**
+ * Edycja na żywo: usunięcie robotnika ze środka warstwowej fabryki i dodanie go ponownie z tymi samymi linkami.
+ * Argumenty: szerokość warstwy (8 warstw), czy w fabryce jest dodatkowy robotnik z powtórzonym (innym) ID -
+ * powtórzenie innego ID nie może spowalniać usuwania.
+ */
+static void BM_Factory_RemoveAndReaddWorker(benchmark::State &state) {
+    const int width = static_cast<int>(state.range(0));
+    const int layer = 4;
+    Factory factory = make_layered_factory(width, 8);
+    if (state.range(1) != 0) {
+        factory.add_worker(Worker(1, 1, std::make_unique<PackageQueue>(PackageQueueType::FIFO)));
+    }
+    const ElementID id = layer * width + 1;
+    const ElementID senders[] = {(layer - 1) * width + 1, (layer - 1) * width + width};
+    const ElementID receivers[] = {(layer + 1) * width + 1, (layer + 1) * width + 2};
+    for (auto _: state) {
+        factory.remove_worker(id);
+        factory.add_worker(Worker(id, 1, std::make_unique<PackageQueue>(PackageQueueType::FIFO)));
+        Worker &worker = *factory.find_worker_by_id(id);
+        for (ElementID sender: senders) {
+            factory.find_worker_by_id(sender)->receiver_preferences_.add_receiver(&worker);
+        }
+        for (ElementID receiver: receivers) {
+            worker.receiver_preferences_.add_receiver(&(*factory.find_worker_by_id(receiver)));
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_Factory_RemoveAndReaddWorker)->ArgsProduct({benchmark::CreateRange(16, 8192, 8), {0, 1}});
+
+/**
+ * Punkt kontrolny warstwowej fabryki po 200 turach (paczki w kolejkach, buforach i magazynach).
+ * Argument: szerokość warstwy (8 warstw).
+ */
+static Factory make_warm_factory(int width) {
+    Factory factory = make_layered_factory(width, 8);
+    factory.set_routing_seed(1);
+    simulate(factory, 200, [](Factory &, Time) {});
+    return factory;
+}
+
+static void BM_Factory_SaveCheckpoint(benchmark::State &state) {
+    const Factory factory = make_warm_factory(static_cast<int>(state.range(0)));
+    for (auto _: state) {
+        CountingBuffer buffer;
+        std::ostream os(&buffer);
+        factory.save_checkpoint(os);
+        benchmark::DoNotOptimize(buffer.count);
+        state.SetBytesProcessed(state.bytes_processed() + static_cast<int64_t>(buffer.count));
+    }
+    state.counters["packages"] = static_cast<double>(factory.get_package_id_allocator().assigned_count());
+}
+
+BENCHMARK(BM_Factory_SaveCheckpoint)->Arg(16)->Arg(128)->Arg(1024)->Unit(benchmark::kMicrosecond);
+
+static void BM_Factory_RestoreCheckpoint(benchmark::State &state) {
+    Factory factory = make_warm_factory(static_cast<int>(state.range(0)));
+    std::ostringstream oss(std::ios::binary);
+    factory.save_checkpoint(oss);
+    const std::string saved = oss.str();
+    for (auto _: state) {
+        factory.restore_checkpoint(saved.data(), saved.size());
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(saved.size()));
+}
+
+BENCHMARK(BM_Factory_RestoreCheckpoint)->Arg(16)->Arg(128)->Arg(1024)->Unit(benchmark::kMicrosecond);
+
+/**
+ * Osiem gałęzi "co by było gdyby" z rozgrzanej fabryki: fork() (kolejki i magazyny współdzielone do pierwszej
+ * zmiany) wobec klonu struktury i odtworzenia punktu kontrolnego w każdej gałęzi.
+ */
+static void BM_Factory_Fork(benchmark::State &state) {
+    const Factory factory = make_warm_factory(static_cast<int>(state.range(0)));
+    for (auto _: state) {
+        std::vector<Factory> branches = factory.fork(8);
+        benchmark::DoNotOptimize(branches.data());
+    }
+}
+
+BENCHMARK(BM_Factory_Fork)->Arg(16)->Arg(128)->Arg(1024)->Unit(benchmark::kMicrosecond);
+
+static void BM_Factory_ForkByCheckpoint(benchmark::State &state) {
+    const Factory factory = make_warm_factory(static_cast<int>(state.range(0)));
+    for (auto _: state) {
+        std::ostringstream oss(std::ios::binary);
+        factory.save_checkpoint(oss);
+        const std::string saved = oss.str();
+        std::vector<Factory> branches;
+        branches.reserve(8);
+        for (int i = 0; i < 8; ++i) {
+            branches.push_back(clone_factory_structure(factory));
+            branches.back().restore_checkpoint(saved.data(), saved.size());
+        }
+        benchmark::DoNotOptimize(branches.data());
+    }
+}
+
+BENCHMARK(BM_Factory_ForkByCheckpoint)->Arg(16)->Arg(128)->Arg(1024)->Unit(benchmark::kMicrosecond);
+
+/**
+ * Wyszukiwanie węzła po ID w kolekcji `count` magazynów: kolejne zapytania trafiają w rozrzucone ID,
+ * drugi argument = 1 - szukane ID nie istnieje.
+ */
+static void BM_NodeCollection_FindById(benchmark::State &state) {
+    const auto count = static_cast<ElementID>(state.range(0));
+    const bool miss = state.range(1) != 0;
+    NodeCollection<Storehouse> storehouses;
+    storehouses.reserve(static_cast<std::size_t>(count));
+    for (ElementID id = 1; id <= count; ++id) {
+        storehouses.add(Storehouse(id));
+    }
+    ElementID id = 1;
+    for (auto _: state) {
+        const ElementID wanted = miss ? count + id : id;
+        benchmark::DoNotOptimize(storehouses.find_by_id(wanted));
+        id = static_cast<ElementID>((static_cast<std::int64_t>(id) * 7919) % count + 1);
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetLabel(miss ? "miss" : "hit");
+}
+
+BENCHMARK(BM_NodeCollection_FindById)->ArgsProduct({{16, 1024, 65536, 1 << 20}, {0, 1}});
+
+namespace {
+    const char *const kParseLines[] = {
+            "LOADING_RAMP id=12 delivery-interval=3",
+            "WORKER id=1024 processing-time=2 queue-type=LIFO",
+            "STOREHOUSE id=7",
+            "LINK src=worker-1024 dest=store-7"
+    };
+}
+
+/**
+ * Starszy parser parse_line() (mapa pól) dla linii każdego typu (argument: indeks linii w kParseLines).
+ * load_factory_structure() go nie używa - parser rekordów mierzy BM_LoadRecord.
+ */
+static void BM_ParseLine(benchmark::State &state) {
+    const std::string line = kParseLines[state.range(0)];
+    for (auto _: state) {
+        ParsedLineData data = parse_line(line);
+        benchmark::DoNotOptimize(data.data.size());
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(line.size()));
+    state.SetLabel(line.substr(0, line.find(' ')));
+}
+
+BENCHMARK(BM_ParseLine)->DenseRange(0, 3);
+
+/**
+ * Parser rekordów load_factory_structure(std::string_view) dla linii każdego typu (argument: indeks linii
+ * w kParseLines). Linia LINK jest wczytywana razem z liniami swoich węzłów (WORKER i STOREHOUSE), a argument 4
+ * (pusta struktura) daje stały koszt utworzenia i zniszczenia fabryki - koszt rekordu to różnica względem niego.
+ * Niszczenie fabryki jest mierzone, bo zatrzymanie pomiaru kosztuje więcej niż pojedynczy rekord.
+ */
+static void BM_LoadRecord(benchmark::State &state) {
+    const auto index = static_cast<std::size_t>(state.range(0));
+    const std::string_view line = index < 4 ? kParseLines[index] : "(empty)";
+    std::string structure;
+    if (index == 3) {
+        structure = std::string(kParseLines[1]) + "\n" + kParseLines[2] + "\n";
+    }
+    if (index < 4) {
+        structure += line;
+    }
+    for (auto _: state) {
+        Factory factory = load_factory_structure(std::string_view(structure));
+        benchmark::DoNotOptimize(factory);
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(structure.size()));
+    state.SetLabel(std::string(line.substr(0, line.find(' '))));
+}
+
+BENCHMARK(BM_LoadRecord)->DenseRange(0, 4);
@@ -0,0 +1,47 @@
+#ifndef NETSIM_BENCH_MEMORY_HPP
+#define NETSIM_BENCH_MEMORY_HPP
+
+/**
+ * plik nagłówkowy "bench_memory.hpp" zawierający pomiar szczytowego RSS procesu na potrzeby benchmarków
+*/
+
+#include <fstream>
+#include <string>
+
+namespace bench {
+    /**
+     * Pole `key` (np. "VmHWM:") z /proc/self/status w KiB; 0, gdy niedostępne
+     */
+    inline long status_kib(const std::string &key) {
+        std::ifstream status("/proc/self/status");
+        std::string line;
+        while (std::getline(status, line)) {
+            if (line.compare(0, key.size(), key) == 0) {
+                return std::stol(line.substr(key.size()));
+            }
+        }
+        return 0;
+    }
+
+    /**
+     * Szczytowe RSS procesu w KiB (VmHWM)
+     */
+    inline long peak_rss_kib() { return status_kib("VmHWM:"); }
+
+    /**
+     * Bieżące RSS procesu w KiB (VmRSS)
+     */
+    inline long rss_kib() { return status_kib("VmRSS:"); }
+
+    /**
+     * @brief Zeruje szczytowe RSS procesu (Linux >= 4.0), dzięki czemu VmHWM po fazie dotyczy tylko tej fazy
+     */
+    inline bool reset_peak_rss() {
+        std::ofstream clear_refs("/proc/self/clear_refs");
+        clear_refs << "5";
+        clear_refs.flush();
+        return static_cast<bool>(clear_refs);
+    }
+}
+
+#endif //NETSIM_BENCH_MEMORY_HPP
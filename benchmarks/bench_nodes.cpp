@@ -0,0 +1,47 @@
+#include <benchmark/benchmark.h>
+
+#include <memory>
+#include <vector>
+
+#include "nodes.hpp"
+
+/**
+ * Wybór odbiorcy przy zadanej liczbie odbiorców (fan-out).
+ */
+static void BM_ReceiverPreferences_Choose(benchmark::State &state) {
+    const auto fan_out = static_cast<ElementID>(state.range(0));
+    std::vector<std::unique_ptr<Storehouse>> receivers;
+    ReceiverPreferences preferences;
+    for (ElementID id = 1; id <= fan_out; ++id) {
+        receivers.push_back(std::make_unique<Storehouse>(id));
+        preferences.add_receiver(receivers.back().get());
+    }
+    for (auto _: state) {
+        benchmark::DoNotOptimize(preferences.choose_receiver());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_ReceiverPreferences_Choose)->RangeMultiplier(4)->Range(2, 512);
+
+/**
+ * Wybór odbiorcy ze strumienia licznikowego (Philox) zamiast wspólnego mt19937.
+ */
+static void BM_ReceiverPreferences_ChooseSeeded(benchmark::State &state) {
+    const auto fan_out = static_cast<ElementID>(state.range(0));
+    std::vector<std::unique_ptr<Storehouse>> receivers;
+    Time turn = 1;
+    RoutingRandomSource source(42, &turn);
+    ReceiverPreferences preferences;
+    preferences.set_random_source(&source, 1);
+    for (ElementID id = 1; id <= fan_out; ++id) {
+        receivers.push_back(std::make_unique<Storehouse>(id));
+        preferences.add_receiver(receivers.back().get());
+    }
+    for (auto _: state) {
+        benchmark::DoNotOptimize(preferences.choose_receiver());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_ReceiverPreferences_ChooseSeeded)->RangeMultiplier(4)->Range(2, 512);
@@ -0,0 +1,104 @@
+#include <benchmark/benchmark.h>
+
+#include <set>
+#include <vector>
+
+#include "package.hpp"
+#include "package_id_allocator.hpp"
+
+namespace {
+    /**
+     * Poprzednia implementacja przydzielania ID (dwa std::set), zachowana jako punkt odniesienia.
+     */
+    class SetBasedIDs {
+    public:
+        ElementID allocate() {
+            ElementID id;
+            if (freed_IDs.empty()) {
+                id = assigned_IDs.empty() ? 1 : *assigned_IDs.rbegin() + 1;
+            } else {
+                id = *freed_IDs.begin();
+                freed_IDs.erase(freed_IDs.begin());
+            }
+            assigned_IDs.insert(id);
+            return id;
+        }
+
+        void release(ElementID id) {
+            freed_IDs.insert(id);
+            assigned_IDs.erase(id);
+        }
+
+    private:
+        std::set<ElementID> freed_IDs;
+        std::set<ElementID> assigned_IDs;
+    };
+
+    /**
+     * Stan ustalony: `live` paczek w obiegu, w każdej iteracji zwalniana jest paczka z rotującej pozycji
+     * i przydzielana nowa (tak jak rampa i magazyn w długiej symulacji).
+     */
+    template<class Allocator>
+    void churn_ids(benchmark::State &state) {
+        const auto live = static_cast<std::size_t>(state.range(0));
+        Allocator allocator;
+        std::vector<ElementID> ids;
+        ids.reserve(live);
+        for (std::size_t i = 0; i < live; ++i) {
+            ids.push_back(allocator.allocate());
+        }
+        std::size_t slot = 0;
+        for (auto _: state) {
+            allocator.release(ids[slot]);
+            ids[slot] = allocator.allocate();
+            benchmark::DoNotOptimize(ids[slot]);
+            slot = (slot * 7 + 13) % live;
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+}
+
+static void BM_PackageIDs_SetBased(benchmark::State &state) { churn_ids<SetBasedIDs>(state); }
+
+BENCHMARK(BM_PackageIDs_SetBased)->RangeMultiplier(32)->Range(1 << 5, 1 << 20);
+
+static void BM_PackageIDs_Bitmap(benchmark::State &state) { churn_ids<PackageIDAllocator>(state); }
+
+BENCHMARK(BM_PackageIDs_Bitmap)->RangeMultiplier(32)->Range(1 << 5, 1 << 20);
+
+/**
+ * Utworzenie i zniszczenie paczki w domenie z `live` paczkami w obiegu (przydział i zwolnienie ID).
+ */
+static void BM_Package_CreateDestroy(benchmark::State &state) {
+    const auto live = static_cast<std::size_t>(state.range(0));
+    PackageIDAllocator allocator;
+    std::vector<Package> packages;
+    packages.reserve(live);
+    for (std::size_t i = 0; i < live; ++i) {
+        packages.emplace_back(allocator);
+    }
+    for (auto _: state) {
+        Package package(allocator);
+        benchmark::DoNotOptimize(package.get_id());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_Package_CreateDestroy)->Arg(0)->Arg(1 << 10)->Arg(1 << 20);
+
+/**
+ * Przeniesienie paczki tam i z powrotem (tak jak między buforem nadawcy a kolejką odbiorcy).
+ */
+static void BM_Package_Move(benchmark::State &state) {
+    PackageIDAllocator allocator;
+    Package first(allocator);
+    Package second(1);
+    for (auto _: state) {
+        second = std::move(first);
+        first = std::move(second);
+        benchmark::DoNotOptimize(first.get_id());
+    }
+    state.SetItemsProcessed(2 * state.iterations());
+}
+
+BENCHMARK(BM_Package_Move);
@@ -0,0 +1,125 @@
+#include <benchmark/benchmark.h>
+
+#include <fstream>
+
+#include "bench_memory.hpp"
+#include "factory.hpp"
+#include "reports.hpp"
+#include "simulation.hpp"
+
+namespace {
+    /**
+     * Łańcuchy ramp -> `depth` robotników -> magazyn, `width` łańcuchów obok siebie.
+     */
+    Factory make_chains_factory(int width, int depth) {
+        Factory factory;
+        for (int i = 1; i <= width; ++i) {
+            factory.add_ramp(Ramp(i, 1));
+            factory.add_storehouse(Storehouse(i));
+            for (int d = 0; d < depth; ++d) {
+                factory.add_worker(Worker(i * depth + d, 2, std::make_unique<PackageQueue>(PackageQueueType::FIFO)));
+            }
+        }
+        for (int i = 1; i <= width; ++i) {
+            factory.find_ramp_by_id(i)->receiver_preferences_.add_receiver(&*factory.find_worker_by_id(i * depth));
+            for (int d = 0; d < depth; ++d) {
+                IPackageReceiver *next = d + 1 < depth ? static_cast<IPackageReceiver *>(&*factory.find_worker_by_id(i * depth + d + 1))
+                                                       : static_cast<IPackageReceiver *>(&*factory.find_storehouse_by_id(i));
+                factory.find_worker_by_id(i * depth + d)->receiver_preferences_.add_receiver(next);
+            }
+        }
+        return factory;
+    }
+}
+
+/**
+ * Symulacja z raportem każdej tury pisanym synchronicznie do pliku; argument: liczba łańcuchów (po 8 robotników).
+ */
+static void BM_TurnReports_Synchronous(benchmark::State &state) {
+    const int width = static_cast<int>(state.range(0));
+    const TimeOffset turns = 200;
+    std::ofstream sink("/dev/null");
+    for (auto _: state) {
+        state.PauseTiming();
+        Factory factory = make_chains_factory(width, 8);
+        state.ResumeTiming();
+        simulate(factory, turns, [&sink](Factory &f, Time t) { generate_simulation_turn_report(f, sink, t); });
+    }
+    state.SetItemsProcessed(state.iterations() * turns);
+}
+
+BENCHMARK(BM_TurnReports_Synchronous)->Arg(16)->Arg(256)->Unit(benchmark::kMillisecond);
+
+/**
+ * To samo z AsyncTurnReportWriter (mierzony jest czas wątku symulacji do zamknięcia writera włącznie).
+ */
+static void BM_TurnReports_Async(benchmark::State &state) {
+    const int width = static_cast<int>(state.range(0));
+    const TimeOffset turns = 200;
+    std::ofstream sink("/dev/null");
+    for (auto _: state) {
+        state.PauseTiming();
+        Factory factory = make_chains_factory(width, 8);
+        state.ResumeTiming();
+        AsyncTurnReportWriter writer(factory, sink, 4);
+        simulate(factory, turns, writer.reporter());
+        writer.close();
+    }
+    state.SetItemsProcessed(state.iterations() * turns);
+}
+
+BENCHMARK(BM_TurnReports_Async)->Arg(16)->Arg(256)->Unit(benchmark::kMillisecond);
+
+/**
+ * Sama symulacja bez raportów - punkt odniesienia.
+ */
+static void BM_TurnReports_None(benchmark::State &state) {
+    const int width = static_cast<int>(state.range(0));
+    const TimeOffset turns = 200;
+    for (auto _: state) {
+        state.PauseTiming();
+        Factory factory = make_chains_factory(width, 8);
+        state.ResumeTiming();
+        simulate(factory, turns, {});
+    }
+    state.SetItemsProcessed(state.iterations() * turns);
+}
+
+BENCHMARK(BM_TurnReports_None)->Arg(16)->Arg(256)->Unit(benchmark::kMillisecond);
+
+/**
+ * Pamięć długiego przebiegu: 64 łańcuchy po 2 robotników, magazyny przechowują paczki; argumenty: liczba tur
+ * i raportowanie przez AsyncTurnReportWriter (0/1). Licznik rss_growth_mib to przyrost szczytowego RSS ponad RSS
+ * sprzed zbudowania fabryki - różnica między wariantami to pamięć writera (kopia ID zgromadzonych paczek w wątku
+ * zapisu, 8 B na paczkę, i sloty zrzutów), a jej wzrost z liczbą tur - koszt O(paczek w magazynach).
+ */
+static void BM_TurnReports_AsyncMemory(benchmark::State &state) {
+    const auto turns = static_cast<TimeOffset>(state.range(0));
+    const bool reports = state.range(1) != 0;
+    std::ofstream sink("/dev/null");
+    bool rss_reset = true;
+    long growth_kib = 0;
+    std::size_t stored = 0;
+    for (auto _: state) {
+        rss_reset = bench::reset_peak_rss() && rss_reset;
+        const long start_kib = bench::rss_kib();
+        Factory factory = make_chains_factory(64, 2);
+        if (reports) {
+            AsyncTurnReportWriter writer(factory, sink, 4);
+            simulate(factory, turns, writer.reporter());
+            writer.close();
+        } else {
+            simulate(factory, turns, {});
+        }
+        growth_kib = bench::peak_rss_kib() - start_kib;
+        stored = 0;
+        for (auto it = factory.storehouse_cbegin(); it != factory.storehouse_cend(); ++it) {
+            stored += it->get_stored_count();
+        }
+    }
+    state.counters["rss_growth_mib"] = static_cast<double>(growth_kib) / 1024;
+    state.counters["stored_packages"] = static_cast<double>(stored);
+    state.SetLabel(rss_reset ? "rss per run" : "rss cumulative");
+}
+
+BENCHMARK(BM_TurnReports_AsyncMemory)->ArgsProduct({{500, 2000}, {0, 1}})->Iterations(1)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,102 @@
+#include <benchmark/benchmark.h>
+
+#include <memory>
+
+#include "storage_types.hpp"
+
+/**
+ * Napełnienie kolejki do zadanej głębokości i opróżnienie jej (argumenty: typ kolejki, głębokość).
+ * Paczki mają jawne ID, więc mierzony jest wyłącznie koszt kontenera.
+ */
+static void BM_PackageQueue_PushPop(benchmark::State &state) {
+    PackageQueue queue(static_cast<PackageQueueType>(state.range(0)));
+    const auto depth = static_cast<ElementID>(state.range(1));
+    for (auto _: state) {
+        for (ElementID id = 1; id <= depth; ++id) {
+            queue.push(Package(id));
+        }
+        for (ElementID i = 0; i < depth; ++i) {
+            benchmark::DoNotOptimize(queue.pop());
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * depth);
+    state.SetLabel(state.range(0) == static_cast<int64_t>(PackageQueueType::FIFO) ? "FIFO" : "LIFO");
+}
+
+BENCHMARK(BM_PackageQueue_PushPop)->ArgsProduct({
+    {static_cast<int64_t>(PackageQueueType::FIFO), static_cast<int64_t>(PackageQueueType::LIFO)},
+    {16, 1024, 65536}
+});
+
+/**
+ * Iteracja po zawartości kolejki (tak jak robią to raporty).
+ */
+static void BM_PackageQueue_Iterate(benchmark::State &state) {
+    PackageQueue queue(PackageQueueType::FIFO);
+    const auto depth = static_cast<ElementID>(state.range(0));
+    for (ElementID id = 1; id <= depth; ++id) {
+        queue.push(Package(id));
+    }
+    for (auto _: state) {
+        ElementID sum = 0;
+        for (const auto &package: queue) {
+            sum += package.get_id();
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * depth);
+}
+
+BENCHMARK(BM_PackageQueue_Iterate)->Arg(1024)->Arg(65536);
+
+/**
+ * Magazyn przez cały przebieg tylko przyjmuje paczki: porównanie LIFO PackageQueue i PackageLog.
+ */
+template<class Stockpile>
+static void store_packages(benchmark::State &state, Stockpile make) {
+    const auto count = static_cast<ElementID>(state.range(0));
+    for (auto _: state) {
+        auto stockpile = make();
+        for (ElementID id = 1; id <= count; ++id) {
+            stockpile->push_at(Package(id), id / 16);
+        }
+        benchmark::DoNotOptimize(stockpile->size());
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+
+static void BM_Storehouse_Append_LifoQueue(benchmark::State &state) {
+    store_packages(state, [] { return std::make_unique<PackageQueue>(PackageQueueType::LIFO); });
+}
+
+BENCHMARK(BM_Storehouse_Append_LifoQueue)->Arg(1 << 20);
+
+static void BM_Storehouse_Append_PackageLog(benchmark::State &state) {
+    store_packages(state, [] { return std::make_unique<PackageLog>(); });
+}
+
+BENCHMARK(BM_Storehouse_Append_PackageLog)->Arg(1 << 20);
+
+/**
+ * Stan ustalony kolejki robotnika: jedna paczka wchodzi i jedna wychodzi przy stałej głębokości
+ * (argumenty: typ kolejki, głębokość).
+ */
+static void BM_PackageQueue_SteadyState(benchmark::State &state) {
+    PackageQueue queue(static_cast<PackageQueueType>(state.range(0)));
+    const auto depth = static_cast<ElementID>(state.range(1));
+    for (ElementID id = 1; id <= depth; ++id) {
+        queue.push(Package(id));
+    }
+    ElementID next = depth + 1;
+    for (auto _: state) {
+        queue.push(Package(next++));
+        benchmark::DoNotOptimize(queue.pop());
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetLabel(state.range(0) == static_cast<int64_t>(PackageQueueType::FIFO) ? "FIFO" : "LIFO");
+}
+
+BENCHMARK(BM_PackageQueue_SteadyState)->ArgsProduct({
+    {static_cast<int64_t>(PackageQueueType::FIFO), static_cast<int64_t>(PackageQueueType::LIFO)},
+    {0, 64, 65536}
+});
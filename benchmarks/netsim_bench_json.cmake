@@ -0,0 +1,28 @@
+# Skrypt celu netsim_bench_json (cmake -P): uruchamia netsim_bench z zapisem wyników w JSON.
+# Wersja w kontekście wyników jest wyznaczana przy każdym uruchomieniu (git describe), a nie przy konfiguracji,
+# więc wyniki kolejnych commitów nie dziedziczą wersji z pierwszego `cmake`. Niepusta NETSIM_BENCH_VERSION
+# nadpisuje wersję z gita.
+#
+# Wymagane zmienne: NETSIM_BENCH, NETSIM_SOURCE_DIR, NETSIM_BENCH_OUT, NETSIM_BENCH_FILTER, NETSIM_BUILD_TYPE.
+
+if (NOT NETSIM_BENCH_VERSION)
+    execute_process(COMMAND git describe --always --dirty
+            WORKING_DIRECTORY ${NETSIM_SOURCE_DIR}
+            OUTPUT_VARIABLE NETSIM_BENCH_VERSION
+            OUTPUT_STRIP_TRAILING_WHITESPACE
+            ERROR_QUIET)
+    if (NOT NETSIM_BENCH_VERSION)
+        set(NETSIM_BENCH_VERSION unknown)
+    endif ()
+endif ()
+
+execute_process(COMMAND ${NETSIM_BENCH}
+        --benchmark_filter=${NETSIM_BENCH_FILTER}
+        --benchmark_out=${NETSIM_BENCH_OUT}
+        --benchmark_out_format=json
+        --benchmark_context=netsim_version=${NETSIM_BENCH_VERSION}
+        --benchmark_context=build_type=${NETSIM_BUILD_TYPE}
+        RESULT_VARIABLE result)
+if (NOT result EQUAL 0)
+    message(FATAL_ERROR "netsim_bench failed: ${result}")
+endif ()
@@ -0,0 +1,75 @@
+#ifndef TEST_STRUCTURES_HPP_
+#define TEST_STRUCTURES_HPP_
+
+// Struktury fabryk wspólne dla testów
+
+#include <memory>
+#include <sstream>
+#include <string>
+
+#include "factory.hpp"
+
+/**
+ * Dwie rampy, trzech robotników (FIFO i LIFO) i dwa magazyny; linki rampy 2 mają podane prawdopodobieństwa
+ */
+inline constexpr const char *kStructure =
+        "LOADING_RAMP id=1 delivery-interval=1\n"
+        "LOADING_RAMP id=2 delivery-interval=2\n"
+        "WORKER id=1 processing-time=3 queue-type=FIFO\n"
+        "WORKER id=2 processing-time=2 queue-type=LIFO\n"
+        "WORKER id=3 processing-time=1 queue-type=FIFO\n"
+        "STOREHOUSE id=1\n"
+        "STOREHOUSE id=2\n"
+        "LINK src=ramp-1 dest=worker-1\n"
+        "LINK src=ramp-1 dest=worker-2\n"
+        "LINK src=ramp-2 dest=worker-2 p=0.25\n"
+        "LINK src=ramp-2 dest=worker-3 p=0.75\n"
+        "LINK src=worker-1 dest=worker-2\n"
+        "LINK src=worker-1 dest=store-1\n"
+        "LINK src=worker-2 dest=worker-3\n"
+        "LINK src=worker-2 dest=store-2\n"
+        "LINK src=worker-3 dest=store-1\n"
+        "LINK src=worker-3 dest=store-2\n";
+
+/**
+ * Dwie rampy, dwóch robotników i dwa magazyny; część linków ma podane prawdopodobieństwa (w tym robotnik 1
+ * z równym podziałem bez p=)
+ */
+inline constexpr const char *kProbabilityStructure =
+        "LOADING_RAMP id=1 delivery-interval=3\n"
+        "LOADING_RAMP id=2 delivery-interval=2\n"
+        "WORKER id=1 processing-time=2 queue-type=FIFO\n"
+        "WORKER id=2 processing-time=1 queue-type=LIFO\n"
+        "STOREHOUSE id=1\n"
+        "STOREHOUSE id=2\n"
+        "LINK src=ramp-1 dest=worker-1\n"
+        "LINK src=ramp-2 dest=worker-1 p=0.25\n"
+        "LINK src=ramp-2 dest=worker-2 p=0.75\n"
+        "LINK src=worker-1 dest=worker-2\n"
+        "LINK src=worker-1 dest=store-1\n"
+        "LINK src=worker-2 dest=store-1 p=0.1\n"
+        "LINK src=worker-2 dest=store-2 p=0.9\n";
+
+/**
+ * Struktura fabryki w formacie tekstowym (save_factory_structure())
+ */
+inline std::string to_text(const Factory &factory) {
+    std::ostringstream oss;
+    save_factory_structure(factory, oss);
+    return oss.str();
+}
+
+/**
+ * Łańcuch: rampa (co di tur) -> robotnik (pd tur, FIFO) -> magazyn
+ */
+inline Factory make_chain(TimeOffset di, TimeOffset pd) {
+    Factory factory;
+    factory.add_ramp(Ramp(1, di));
+    factory.add_worker(Worker(1, pd, std::make_unique<PackageQueue>(PackageQueueType::FIFO)));
+    factory.add_storehouse(Storehouse(1));
+    factory.find_ramp_by_id(1)->receiver_preferences_.add_receiver(&*factory.find_worker_by_id(1));
+    factory.find_worker_by_id(1)->receiver_preferences_.add_receiver(&*factory.find_storehouse_by_id(1));
+    return factory;
+}
+
+#endif /* TEST_STRUCTURES_HPP_ */
@@ -6,6 +6,7 @@
 
 // DEBUG
 #include <iostream>
+#include <random>
 
 using ::std::cout;
 using ::std::endl;
@@ -68,6 +69,241 @@ TEST(FactoryTest, IsConsistentMissingLink2) {
     EXPECT_FALSE(factory.is_consistent());
 }
 
+TEST(FactoryTest, FindInconsistentNodesReportsEveryFailure) {
+    // R1 (bez odbiorców)
+    // R2 -> W1 -> W2 -> W2, W1 -> W3 -> S
+    // W4 (nieosiągalny, bez odbiorców)
+
+    Factory factory;
+    factory.add_ramp(Ramp(1, 1));
+    factory.add_ramp(Ramp(2, 1));
+    for (ElementID id = 1; id <= 4; ++id) {
+        factory.add_worker(Worker(id, 1, std::make_unique<PackageQueue>(PackageQueueType::FIFO)));
+    }
+    factory.add_storehouse(Storehouse(1));
+    auto worker = [&factory](ElementID id) { return &*factory.find_worker_by_id(id); };
+
+    factory.find_ramp_by_id(2)->receiver_preferences_.add_receiver(worker(1));
+    worker(1)->receiver_preferences_.add_receiver(worker(2));
+    worker(1)->receiver_preferences_.add_receiver(worker(3));
+    worker(2)->receiver_preferences_.add_receiver(worker(2));
+    worker(3)->receiver_preferences_.add_receiver(&*factory.find_storehouse_by_id(1));
+
+    EXPECT_FALSE(factory.is_consistent());
+    std::vector<InconsistentNode> expected = {
+            {ElementType::RAMP, 1, InconsistentNode::Reason::NO_RECEIVERS},
+            {ElementType::WORKER, 2, InconsistentNode::Reason::SELF_LINK_ONLY},
+    };
+    EXPECT_EQ(factory.find_inconsistent_nodes(), expected);
+
+    factory.remove_ramp(1);
+    worker(2)->receiver_preferences_.add_receiver(worker(3));
+    EXPECT_TRUE(factory.is_consistent());
+    EXPECT_TRUE(factory.find_inconsistent_nodes().empty());
+}
+
+TEST(FactoryTest, IsConsistentHandlesDeepChains) {
+    // R -> W1 -> W2 -> ... -> Wn -> S; rekurencyjne przejście przepełniłoby stos.
+    const ElementID n = 200000;
+    Factory factory;
+    factory.add_ramp(Ramp(1, 1));
+    for (ElementID id = 1; id <= n; ++id) {
+        factory.add_worker(Worker(id, 1, std::make_unique<PackageQueue>(PackageQueueType::FIFO)));
+    }
+    factory.add_storehouse(Storehouse(1));
+    factory.find_ramp_by_id(1)->receiver_preferences_.add_receiver(&*factory.find_worker_by_id(1));
+    for (ElementID id = 1; id < n; ++id) {
+        factory.find_worker_by_id(id)->receiver_preferences_.add_receiver(&*factory.find_worker_by_id(id + 1));
+    }
+    factory.find_worker_by_id(n)->receiver_preferences_.add_receiver(&*factory.find_storehouse_by_id(1));
+    EXPECT_TRUE(factory.is_consistent());
+
+    factory.remove_storehouse(1);
+    std::vector<InconsistentNode> expected = {{ElementType::WORKER, n, InconsistentNode::Reason::NO_RECEIVERS}};
+    EXPECT_EQ(factory.find_inconsistent_nodes(), expected);
+}
+
+TEST(FactoryTest, IncrementalConsistencyMatchesFullCheck) {
+    // Losowe edycje węzłów i linków; po każdej status przyrostowy musi zgadzać się z pełnym przejściem.
+    int consistent_steps = 0;
+    int inconsistent_steps = 0;
+    for (unsigned seed = 1; seed <= 20; ++seed) {
+        std::mt19937 rng(seed);
+        auto pick = [&rng](int n) { return std::uniform_int_distribution<int>(1, n)(rng); };
+        Factory factory;
+
+        auto random_sender = [&]() -> PackageSender * {
+            if (pick(3) == 1) {
+                auto ramp = factory.find_ramp_by_id(pick(3));
+                return ramp == factory.ramp_end() ? nullptr : &*ramp;
+            }
+            auto worker = factory.find_worker_by_id(pick(8));
+            return worker == factory.worker_end() ? nullptr : &*worker;
+        };
+        auto random_receiver = [&]() -> IPackageReceiver * {
+            if (pick(4) == 1) {
+                auto storehouse = factory.find_storehouse_by_id(pick(2));
+                return storehouse == factory.storehouse_end() ? nullptr : &*storehouse;
+            }
+            auto worker = factory.find_worker_by_id(pick(8));
+            return worker == factory.worker_end() ? nullptr : &*worker;
+        };
+
+        for (int step = 0; step < 400; ++step) {
+            switch (pick(8)) {
+                case 1:
+                    if (factory.find_ramp_by_id(pick(3)) == factory.ramp_end()) {
+                        factory.add_ramp(Ramp(pick(3), 1));
+                    }
+                    break;
+                case 2: {
+                    ElementID id = pick(8);
+                    if (factory.find_worker_by_id(id) == factory.worker_end()) {
+                        factory.add_worker(Worker(id, 1, std::make_unique<PackageQueue>(PackageQueueType::FIFO)));
+                    }
+                    break;
+                }
+                case 3: {
+                    ElementID id = pick(2);
+                    if (factory.find_storehouse_by_id(id) == factory.storehouse_end()) {
+                        factory.add_storehouse(Storehouse(id));
+                    }
+                    break;
+                }
+                case 4: {
+                    int kind = pick(3);
+                    if (kind == 1) {
+                        factory.remove_ramp(pick(3));
+                    } else if (kind == 2) {
+                        factory.remove_worker(pick(8));
+                    } else {
+                        factory.remove_storehouse(pick(2));
+                    }
+                    break;
+                }
+                case 5:
+                case 6: {
+                    PackageSender *sender = random_sender();
+                    IPackageReceiver *receiver = random_receiver();
+                    if (sender != nullptr && receiver != nullptr) {
+                        sender->receiver_preferences_.add_receiver(receiver);
+                    }
+                    break;
+                }
+                case 7: {
+                    PackageSender *sender = random_sender();
+                    IPackageReceiver *receiver = random_receiver();
+                    if (sender != nullptr && receiver != nullptr) {
+                        sender->receiver_preferences_.remove_receiver(receiver);
+                    }
+                    break;
+                }
+                default: {
+                    PackageSender *sender = random_sender();
+                    if (sender != nullptr) {
+                        ReceiverPreferences::preferences_t preferences;
+                        for (int i = pick(3) - 1; i > 0; --i) {
+                            if (IPackageReceiver *receiver = random_receiver()) {
+                                preferences[receiver] = 0.5;
+                            }
+                        }
+                        sender->receiver_preferences_.set_preferences(preferences);
+                    }
+                    break;
+                }
+            }
+            ASSERT_EQ(factory.is_consistent(), factory.find_inconsistent_nodes().empty())
+                                << "seed " << seed << ", step " << step;
+            ++(factory.is_consistent() ? consistent_steps : inconsistent_steps);
+        }
+    }
+    // Obie odpowiedzi muszą wystąpić wielokrotnie, inaczej test niczego nie porównuje.
+    EXPECT_GT(consistent_steps, 100);
+    EXPECT_GT(inconsistent_steps, 100);
+}
+
+TEST(FactoryTest, IncrementalConsistencyWithDanglingRegions) {
+    // Spójna część z rampami i osobne łańcuchy robotników bez rampy powyżej, zakończone nadawcą bez odbiorców.
+    // Losowe edycje (kilka między pytaniami) podpinają rampy i robotników do łańcuchów i odpinają ich;
+    // zapamiętane werdykty nadawców bez odbiorców muszą zgadzać się z pełnym przejściem.
+    const ElementID chains = 4;
+    const ElementID chain_length = 30;
+    int consistent_steps = 0;
+    int inconsistent_steps = 0;
+    for (unsigned seed = 1; seed <= 10; ++seed) {
+        std::mt19937 rng(seed);
+        auto pick = [&rng](int n) { return std::uniform_int_distribution<int>(1, n)(rng); };
+        Factory factory;
+        factory.add_storehouse(Storehouse(1));
+        IPackageReceiver *storehouse = &*factory.find_storehouse_by_id(1);
+        for (ElementID id = 1; id <= 3; ++id) {
+            factory.add_ramp(Ramp(id, 1));
+            factory.find_ramp_by_id(id)->receiver_preferences_.add_receiver(storehouse);
+        }
+        const ElementID workers = chains * chain_length;
+        for (ElementID id = 1; id <= workers; ++id) {
+            factory.add_worker(Worker(id, 1, std::make_unique<PackageQueue>(PackageQueueType::FIFO)));
+        }
+        auto link_chain_worker = [&factory](ElementID id) {
+            if (id % chain_length != 0) {
+                factory.find_worker_by_id(id)->receiver_preferences_.add_receiver(&*factory.find_worker_by_id(id + 1));
+            }
+        };
+        for (ElementID id = 1; id <= workers; ++id) {
+            link_chain_worker(id);
+        }
+        ASSERT_TRUE(factory.is_consistent());
+
+        auto random_sender = [&]() -> PackageSender * {
+            if (pick(8) == 1) {
+                auto ramp = factory.find_ramp_by_id(pick(3));
+                return ramp == factory.ramp_end() ? nullptr : &*ramp;
+            }
+            auto worker = factory.find_worker_by_id(pick(workers));
+            return worker == factory.worker_end() ? nullptr : &*worker;
+        };
+        auto random_receiver = [&]() -> IPackageReceiver * {
+            if (pick(4) == 1) {
+                return storehouse;
+            }
+            auto worker = factory.find_worker_by_id(pick(workers));
+            return worker == factory.worker_end() ? nullptr : &*worker;
+        };
+
+        for (int step = 0; step < 300; ++step) {
+            for (int edit = pick(3); edit > 0; --edit) {
+                PackageSender *sender = random_sender();
+                IPackageReceiver *receiver = random_receiver();
+                switch (pick(6)) {
+                    case 1: {
+                        ElementID id = pick(workers);
+                        factory.remove_worker(id);
+                        factory.add_worker(Worker(id, 1, std::make_unique<PackageQueue>(PackageQueueType::FIFO)));
+                        link_chain_worker(id);
+                        break;
+                    }
+                    case 2:
+                    case 3:
+                        if (sender != nullptr && receiver != nullptr) {
+                            sender->receiver_preferences_.add_receiver(receiver);
+                        }
+                        break;
+                    default:
+                        if (sender != nullptr && receiver != nullptr) {
+                            sender->receiver_preferences_.remove_receiver(receiver);
+                        }
+                        break;
+                }
+            }
+            ASSERT_EQ(factory.is_consistent(), factory.find_inconsistent_nodes().empty())
+                                << "seed " << seed << ", step " << step;
+            ++(factory.is_consistent() ? consistent_steps : inconsistent_steps);
+        }
+    }
+    EXPECT_GT(consistent_steps, 100);
+    EXPECT_GT(inconsistent_steps, 100);
+}
+
 TEST(FactoryTest, RemoveWorkerNoSuchReceiver) {
     /* Próba usunięcia nieistniejącego odbiorcy - dopuszczalne. */
 
@@ -140,3 +376,357 @@ TEST(FactoryTest, RemoveWorkerTwoRemainingReceivers) {
     ASSERT_NE(it, prefs.end());
     EXPECT_DOUBLE_EQ(it->second, 1.0 / 2.0);
 }
+
+TEST(FactoryTest, FactoriesHaveIndependentPackageIdDomains) {
+    Factory f1;
+    Factory f2;
+    for (Factory* f : {&f1, &f2}) {
+        f->add_ramp(Ramp(1, 1));
+        f->add_storehouse(Storehouse(1));
+        f->find_ramp_by_id(1)->receiver_preferences_.add_receiver(&(*f->find_storehouse_by_id(1)));
+    }
+
+    f1.do_deliveries(1);
+    f1.do_package_passing();
+    f1.do_deliveries(2);
+    f2.do_deliveries(1);
+
+    // Każda fabryka numeruje paczki od 1, niezależnie od drugiej i od domyślnej domeny procesu.
+    EXPECT_EQ(f1.find_storehouse_by_id(1)->cbegin()->get_id(), 1);
+    EXPECT_EQ(f1.find_ramp_by_id(1)->get_sending_buffer()->get_id(), 2);
+    EXPECT_EQ(f2.find_ramp_by_id(1)->get_sending_buffer()->get_id(), 1);
+    EXPECT_EQ(f1.get_package_id_allocator().assigned_count(), 2U);
+    EXPECT_EQ(f2.get_package_id_allocator().assigned_count(), 1U);
+}
+
+TEST(FactoryTest, MoveAssignmentKeepsPackageIdDomain) {
+    Factory factory;
+    {
+        Factory loaded;
+        loaded.add_ramp(Ramp(1, 1));
+        loaded.do_deliveries(1);
+        factory = std::move(loaded);
+    }
+
+    EXPECT_EQ(factory.get_package_id_allocator().assigned_count(), 1U);
+    // Nowa dostawa nadpisuje bufor - stara paczka zwraca ID do domeny przeniesionej razem z węzłami.
+    factory.do_deliveries(2);
+    EXPECT_EQ(factory.find_ramp_by_id(1)->get_sending_buffer()->get_id(), 2);
+    EXPECT_EQ(factory.get_package_id_allocator().assigned_count(), 1U);
+}
+
+TEST(FactoryTest, MovedFromFactoryIsEmptyAndUsable) {
+    auto make_loaded = [] {
+        Factory factory;
+        factory.add_ramp(Ramp(1, 1));
+        factory.add_storehouse(Storehouse(1));
+        factory.find_ramp_by_id(1)->receiver_preferences_.add_receiver(&*factory.find_storehouse_by_id(1));
+        factory.set_time(5);
+        factory.do_deliveries(5);
+        return factory;
+    };
+    auto expect_empty_and_usable = [](Factory &factory) {
+        EXPECT_EQ(factory.get_time(), 0);
+        EXPECT_TRUE(factory.is_consistent());
+        EXPECT_EQ(factory.get_package_id_allocator().assigned_count(), 0U);
+        EXPECT_EQ(factory.find_ramp_by_id(1), factory.ramp_cend());
+        EXPECT_EQ(factory.find_storehouse_by_id(1), factory.storehouse_cend());
+
+        factory.add_ramp(Ramp(1, 1));
+        factory.add_worker(Worker(1, 1, std::make_unique<PackageQueue>(PackageQueueType::FIFO)));
+        factory.find_ramp_by_id(1)->receiver_preferences_.add_receiver(&*factory.find_worker_by_id(1));
+        EXPECT_FALSE(factory.is_consistent());
+        factory.do_deliveries(1);
+        EXPECT_EQ(factory.find_ramp_by_id(1)->get_sending_buffer()->get_id(), 1);
+    };
+
+    Factory source = make_loaded();
+    Factory constructed(std::move(source));
+    expect_empty_and_usable(source);
+
+    Factory assigned_from = make_loaded();
+    Factory assigned;
+    assigned = std::move(assigned_from);
+    expect_empty_and_usable(assigned_from);
+
+    // Fabryki docelowe zachowują stan źródeł.
+    for (Factory *factory: {&constructed, &assigned}) {
+        EXPECT_EQ(factory->get_time(), 5);
+        EXPECT_TRUE(factory->is_consistent());
+        EXPECT_EQ(factory->get_package_id_allocator().assigned_count(), 1U);
+    }
+}
+
+TEST(FactoryTest, StorehouseLogRecordsArrivalTurns) {
+    Factory factory;
+    factory.add_ramp(Ramp(1, 2));
+    factory.add_storehouse(Storehouse(1, std::make_unique<PackageLog>()));
+    factory.find_ramp_by_id(1)->receiver_preferences_.add_receiver(&(*factory.find_storehouse_by_id(1)));
+
+    for (Time t = 1; t <= 6; ++t) {
+        factory.do_deliveries(t);
+        factory.do_package_passing();
+        factory.do_work(t);
+    }
+
+    const auto& log = dynamic_cast<const PackageLog&>(*factory.find_storehouse_by_id(1)->get_stockpile());
+    ASSERT_EQ(log.size(), 3U);
+    EXPECT_EQ(log.arrival_time(0), 1);
+    EXPECT_EQ(log.arrival_time(1), 3);
+    EXPECT_EQ(log.arrival_time(2), 5);
+    EXPECT_EQ(log.arrivals_between(2, 5).size(), 2U);
+}
+
+TEST(FactoryTest, FindByIdAfterRemovalsKeepsNodeAddresses) {
+    Factory factory;
+    for (ElementID id = 1; id <= 100; ++id) {
+        factory.add_worker(Worker(id, 1, std::make_unique<PackageQueue>(PackageQueueType::FIFO)));
+    }
+    Worker* w50 = &(*factory.find_worker_by_id(50));
+
+    for (ElementID id = 1; id <= 100; id += 2) {
+        factory.remove_worker(id);
+    }
+
+    EXPECT_EQ(factory.find_worker_by_id(1), factory.worker_cend());
+    EXPECT_EQ(factory.find_worker_by_id(99), factory.worker_cend());
+    ASSERT_NE(factory.find_worker_by_id(50), factory.worker_cend());
+    EXPECT_EQ(&(*factory.find_worker_by_id(50)), w50);
+    EXPECT_EQ(factory.find_worker_by_id(100)->get_id(), 100);
+}
+
+TEST(FactoryTest, FindByIdWithDuplicatedIds) {
+    // Przy powtórzonym ID zwracany jest pierwszy dodany węzeł, a po jego usunięciu - kolejny.
+    Factory factory;
+    factory.add_ramp(Ramp(1, 1));
+    factory.add_ramp(Ramp(1, 2));
+
+    EXPECT_EQ(factory.find_ramp_by_id(1)->get_delivery_interval(), 1);
+    factory.remove_ramp(1);
+    ASSERT_NE(factory.find_ramp_by_id(1), factory.ramp_cend());
+    EXPECT_EQ(factory.find_ramp_by_id(1)->get_delivery_interval(), 2);
+    factory.remove_ramp(1);
+    EXPECT_EQ(factory.find_ramp_by_id(1), factory.ramp_cend());
+
+    // Powtórzenia jednego ID nie wpływają na usuwanie innych; każde powtórzenie przejmuje wpis po kolei.
+    for (TimeOffset di = 1; di <= 3; ++di) {
+        factory.add_ramp(Ramp(7, di));
+        factory.add_ramp(Ramp(100 + di, di));
+    }
+    factory.remove_ramp(102);
+    EXPECT_EQ(factory.find_ramp_by_id(102), factory.ramp_cend());
+    EXPECT_EQ(factory.find_ramp_by_id(7)->get_delivery_interval(), 1);
+    for (TimeOffset di = 2; di <= 3; ++di) {
+        factory.remove_ramp(7);
+        ASSERT_NE(factory.find_ramp_by_id(7), factory.ramp_cend());
+        EXPECT_EQ(factory.find_ramp_by_id(7)->get_delivery_interval(), di);
+    }
+    factory.remove_ramp(7);
+    EXPECT_EQ(factory.find_ramp_by_id(7), factory.ramp_cend());
+    factory.add_ramp(Ramp(7, 5));
+    EXPECT_EQ(factory.find_ramp_by_id(7)->get_delivery_interval(), 5);
+    factory.remove_ramp(7);
+    EXPECT_EQ(factory.find_ramp_by_id(7), factory.ramp_cend());
+    EXPECT_NE(factory.find_ramp_by_id(101), factory.ramp_cend());
+    EXPECT_NE(factory.find_ramp_by_id(103), factory.ramp_cend());
+}
+
+TEST(FactoryTest, ReverseLinkIndexTracksPreferenceChanges) {
+    Factory factory;
+    factory.add_storehouse(Storehouse(1));
+    IPackageReceiver* s = &(*factory.find_storehouse_by_id(1));
+
+    // Link dodany przed umieszczeniem rampy w fabryce też trafia do indeksu.
+    Ramp ramp(1, 1);
+    ramp.receiver_preferences_.add_receiver(s);
+    factory.add_ramp(std::move(ramp));
+    factory.add_worker(Worker(1, 1, std::make_unique<PackageQueue>(PackageQueueType::FIFO)));
+    factory.add_worker(Worker(2, 1, std::make_unique<PackageQueue>(PackageQueueType::FIFO)));
+    Worker& w1 = *factory.find_worker_by_id(1);
+    Worker& w2 = *factory.find_worker_by_id(2);
+    w1.receiver_preferences_.add_receiver(&w1);
+    w1.receiver_preferences_.add_receiver(&w2);
+    w2.receiver_preferences_.set_preferences({{s, 1.0}});
+
+    EXPECT_EQ(factory.get_senders_of(s).size(), 2U);
+    EXPECT_EQ(factory.get_senders_of(&w1).size(), 1U);
+
+    factory.remove_worker(1);
+    EXPECT_TRUE(factory.get_senders_of(&w2).empty());
+
+    w2.receiver_preferences_.set_preferences({});
+    ASSERT_EQ(factory.get_senders_of(s).size(), 1U);
+    EXPECT_EQ(factory.get_senders_of(s).front(), static_cast<PackageSender*>(&(*factory.find_ramp_by_id(1))));
+
+    factory.remove_storehouse(1);
+    EXPECT_TRUE(factory.find_ramp_by_id(1)->receiver_preferences_.get_preferences().empty());
+
+    factory.remove_ramp(1);
+    factory.remove_ramp(2);
+    EXPECT_EQ(factory.find_ramp_by_id(1), factory.ramp_cend());
+}
+
+namespace {
+    /**
+     * Trzy warstwy robotników zbiegające się do dwóch magazynów (dziennik i zbiorczy); każdy nadawca ma
+     * jednego odbiorcę, więc przebieg nie zależy od losowania.
+     */
+    Factory make_converging_factory() {
+        Factory factory;
+        for (ElementID i = 1; i <= 8; ++i) {
+            factory.add_ramp(Ramp(i, i % 3 + 1));
+        }
+        for (ElementID i = 1; i <= 14; ++i) {
+            auto type = i % 2 == 0 ? PackageQueueType::FIFO : PackageQueueType::LIFO;
+            factory.add_worker(Worker(i, i % 4 + 1, std::make_unique<PackageQueue>(type)));
+        }
+        factory.add_storehouse(Storehouse(1, std::make_unique<PackageLog>()));
+        factory.add_storehouse(Storehouse(2, std::make_unique<AggregateStockpile>(5)));
+
+        auto worker = [&factory](ElementID id) { return &*factory.find_worker_by_id(id); };
+        // Rampy 1..8 -> robotnicy 1..8 (parami na krzyż), robotnicy 1..8 -> 9..12, 9..12 -> 13..14, 13 -> dziennik, 14 -> zbiorczy.
+        for (ElementID i = 1; i <= 8; ++i) {
+            factory.find_ramp_by_id(i)->receiver_preferences_.add_receiver(worker((i + 1) / 2 * 2 - 1 + i % 2));
+            worker(i)->receiver_preferences_.add_receiver(worker(9 + (i - 1) / 2));
+        }
+        for (ElementID i = 9; i <= 12; ++i) {
+            worker(i)->receiver_preferences_.add_receiver(worker(13 + (i - 9) / 2));
+        }
+        worker(13)->receiver_preferences_.add_receiver(&*factory.find_storehouse_by_id(1));
+        worker(14)->receiver_preferences_.add_receiver(&*factory.find_storehouse_by_id(2));
+        return factory;
+    }
+
+    void run_turns(Factory &factory, Time turns) {
+        for (Time t = 1; t <= turns; ++t) {
+            factory.do_deliveries(t);
+            factory.do_package_passing();
+            factory.do_work(t);
+        }
+    }
+}
+
+TEST(FactoryTest, ParallelTurnsMatchSerialRun) {
+    Factory serial = make_converging_factory();
+    run_turns(serial, 80);
+    const auto &serial_log = dynamic_cast<const PackageLog &>(*serial.find_storehouse_by_id(1)->get_stockpile());
+    const auto &serial_aggregate = dynamic_cast<const AggregateStockpile &>(*serial.find_storehouse_by_id(2)->get_stockpile());
+    ASSERT_GT(serial_log.size(), 0U);
+
+    for (std::size_t threads: {2U, 3U, 5U}) {
+        Factory parallel = make_converging_factory();
+        parallel.set_thread_count(threads);
+        ASSERT_EQ(parallel.get_thread_count(), threads);
+        run_turns(parallel, 80);
+
+        const auto &log = dynamic_cast<const PackageLog &>(*parallel.find_storehouse_by_id(1)->get_stockpile());
+        ASSERT_EQ(log.size(), serial_log.size()) << threads << " threads";
+        for (std::size_t i = 0; i < log.size(); ++i) {
+            EXPECT_EQ(log.at(i).get_id(), serial_log.at(i).get_id()) << threads << " threads, entry " << i;
+            EXPECT_EQ(log.arrival_time(i), serial_log.arrival_time(i)) << threads << " threads, entry " << i;
+        }
+        const auto &aggregate = dynamic_cast<const AggregateStockpile &>(*parallel.find_storehouse_by_id(2)->get_stockpile());
+        EXPECT_EQ(aggregate.get_arrival_count(), serial_aggregate.get_arrival_count());
+        EXPECT_EQ(aggregate.get_histogram(), serial_aggregate.get_histogram());
+        EXPECT_EQ(parallel.get_package_id_allocator().assigned_count(), serial.get_package_id_allocator().assigned_count());
+    }
+}
+
+TEST(FactoryTest, ParallelTurnsFollowStructureChanges) {
+    Factory serial = make_converging_factory();
+    Factory parallel = make_converging_factory();
+    parallel.set_thread_count(4);
+    run_turns(serial, 10);
+    run_turns(parallel, 10);
+
+    // Usunięcie robotnika po rozpoczęciu symulacji - wektory węzłów trybu równoległego muszą zostać odświeżone.
+    serial.remove_worker(3);
+    parallel.remove_worker(3);
+    serial.find_ramp_by_id(4)->receiver_preferences_.add_receiver(&*serial.find_worker_by_id(4));
+    parallel.find_ramp_by_id(4)->receiver_preferences_.add_receiver(&*parallel.find_worker_by_id(4));
+    for (Time t = 11; t <= 40; ++t) {
+        for (Factory *factory: {&serial, &parallel}) {
+            factory->do_deliveries(t);
+            factory->do_package_passing();
+            factory->do_work(t);
+        }
+    }
+
+    const auto &serial_log = dynamic_cast<const PackageLog &>(*serial.find_storehouse_by_id(1)->get_stockpile());
+    const auto &log = dynamic_cast<const PackageLog &>(*parallel.find_storehouse_by_id(1)->get_stockpile());
+    ASSERT_EQ(log.size(), serial_log.size());
+    for (std::size_t i = 0; i < log.size(); ++i) {
+        EXPECT_EQ(log.at(i).get_id(), serial_log.at(i).get_id());
+    }
+
+    parallel.set_thread_count(1);
+    EXPECT_EQ(parallel.get_thread_count(), 1U);
+}
+
+TEST(FactoryTest, SeededRoutingIsIndependentOfThreadCount) {
+    // Sieć z rozgałęzieniami: przebieg zależy od losowania, więc zgodność wymaga strumieni licznikowych.
+    auto make_branching_factory = []() {
+        Factory factory = make_converging_factory();
+        auto worker = [&factory](ElementID id) { return &*factory.find_worker_by_id(id); };
+        for (ElementID i = 1; i <= 8; ++i) {
+            factory.find_ramp_by_id(i)->receiver_preferences_.add_receiver(worker(9 - i));
+            worker(i)->receiver_preferences_.add_receiver(worker(9 + i % 4));
+        }
+        worker(9)->receiver_preferences_.add_receiver(&*factory.find_storehouse_by_id(1));
+        worker(13)->receiver_preferences_.add_receiver(&*factory.find_storehouse_by_id(2));
+        factory.set_routing_seed(123456789);
+        return factory;
+    };
+
+    Factory serial = make_branching_factory();
+    ASSERT_EQ(serial.get_routing_seed(), std::optional<std::uint64_t>(123456789));
+    run_turns(serial, 80);
+    const auto &serial_log = dynamic_cast<const PackageLog &>(*serial.find_storehouse_by_id(1)->get_stockpile());
+    ASSERT_GT(serial_log.size(), 0U);
+
+    for (std::size_t threads: {1U, 2U, 4U}) {
+        Factory parallel = make_branching_factory();
+        parallel.set_thread_count(threads);
+        run_turns(parallel, 80);
+
+        const auto &log = dynamic_cast<const PackageLog &>(*parallel.find_storehouse_by_id(1)->get_stockpile());
+        ASSERT_EQ(log.size(), serial_log.size()) << threads << " threads";
+        for (std::size_t i = 0; i < log.size(); ++i) {
+            EXPECT_EQ(log.at(i).get_id(), serial_log.at(i).get_id()) << threads << " threads, entry " << i;
+            EXPECT_EQ(log.arrival_time(i), serial_log.arrival_time(i)) << threads << " threads, entry " << i;
+        }
+        EXPECT_EQ(parallel.find_storehouse_by_id(2)->get_stored_count(), serial.find_storehouse_by_id(2)->get_stored_count());
+    }
+}
+
+TEST(FactoryTest, UnseededFactoryHasNoRoutingSeed) {
+    Factory factory;
+    EXPECT_FALSE(factory.get_routing_seed().has_value());
+    factory.set_routing_seed(1);
+    factory.set_routing_seed(2);
+    EXPECT_EQ(factory.get_routing_seed(), std::optional<std::uint64_t>(2));
+}
+
+TEST(FactoryTest, CloneStructureCopiesNodesLinksAndStorageModes) {
+    Factory original = make_converging_factory();
+    original.find_ramp_by_id(1)->receiver_preferences_.set_preferences(
+            {{&*original.find_worker_by_id(2), 0.25}, {&*original.find_worker_by_id(5), 0.75}});
+    run_turns(original, 5);
+
+    Factory clone = clone_factory_structure(original);
+
+    EXPECT_TRUE(clone.is_consistent());
+    EXPECT_EQ(std::distance(clone.worker_cbegin(), clone.worker_cend()), 14);
+    const auto &prefs = clone.find_ramp_by_id(1)->receiver_preferences_.get_preferences();
+    ASSERT_EQ(prefs.size(), 2U);
+    EXPECT_EQ(prefs.at(&*clone.find_worker_by_id(2)), 0.25);
+    EXPECT_EQ(prefs.at(&*clone.find_worker_by_id(5)), 0.75);
+    EXPECT_EQ(clone.find_worker_by_id(2)->get_queue()->get_queue_type(), PackageQueueType::FIFO);
+    EXPECT_EQ(clone.find_worker_by_id(3)->get_processing_duration(), 4);
+    EXPECT_NE(dynamic_cast<const PackageLog *>(clone.find_storehouse_by_id(1)->get_stockpile()), nullptr);
+    EXPECT_TRUE(clone.find_storehouse_by_id(2)->is_aggregate());
+    // Klon nie ma paczek ani połączeń do węzłów oryginału.
+    EXPECT_EQ(clone.get_package_id_allocator().assigned_count(), 0U);
+    EXPECT_EQ(clone.get_senders_of(&*original.find_worker_by_id(2)).size(), 0U);
+    EXPECT_EQ(clone.get_senders_of(&*clone.find_worker_by_id(5)).size(), 2U);
+}
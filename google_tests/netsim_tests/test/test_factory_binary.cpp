@@ -0,0 +1,160 @@
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include "factory.hpp"
+#include "factory_binary.hpp"
+#include "test_structures.hpp"
+
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+namespace {
+    std::string to_binary(const Factory &factory) {
+        std::ostringstream oss(std::ios::binary);
+        save_factory_structure_binary(factory, oss);
+        return oss.str();
+    }
+
+    std::string load_error(std::string bytes) {
+        try {
+            load_factory_structure_binary(bytes.data(), bytes.size());
+        } catch (const std::logic_error &e) {
+            return e.what();
+        }
+        return "";
+    }
+
+    /**
+     * Nadpisuje pole `field` (offsetof w LinkRecord) linku `from_end` licząc od końca pliku (1 = ostatni link)
+     */
+    template<class T>
+    void patch_link(std::string &bytes, std::size_t from_end, std::size_t field, T value) {
+        std::memcpy(&bytes[bytes.size() - from_end * sizeof(factory_binary::LinkRecord) + field], &value, sizeof(value));
+    }
+}
+
+TEST(FactoryBinaryTest, RoundTripMatchesTextFormat) {
+    Factory text_factory = load_factory_structure(std::string_view(kProbabilityStructure));
+    const std::string bytes = to_binary(text_factory);
+    ASSERT_TRUE(factory_binary::is_binary_structure(bytes.data(), bytes.size()));
+
+    Factory binary_factory = load_factory_structure_binary(bytes.data(), bytes.size());
+    EXPECT_EQ(to_text(binary_factory), to_text(text_factory));
+    EXPECT_EQ(to_binary(binary_factory), bytes);
+    EXPECT_TRUE(binary_factory.is_consistent());
+}
+
+TEST(FactoryBinaryTest, ProbabilitiesAndNodeOrderArePreserved) {
+    Factory factory = load_factory_structure(std::string_view(kProbabilityStructure));
+    const std::string bytes = to_binary(factory);
+    Factory loaded = load_factory_structure_binary(bytes.data(), bytes.size());
+
+    ASSERT_EQ(loaded.ramp_cbegin()->get_id(), 1);
+    const auto &prefs = loaded.find_ramp_by_id(2)->receiver_preferences_.get_preferences();
+    ASSERT_EQ(prefs.size(), 2U);
+    EXPECT_EQ(prefs.at(&*loaded.find_worker_by_id(1)), 0.25);
+    EXPECT_EQ(prefs.at(&*loaded.find_worker_by_id(2)), 0.75);
+    EXPECT_EQ(loaded.find_worker_by_id(2)->get_queue()->get_queue_type(), PackageQueueType::LIFO);
+    EXPECT_EQ(loaded.get_senders_of(&*loaded.find_storehouse_by_id(1)).size(), 2U);
+}
+
+TEST(FactoryBinaryTest, LoadsFromMappedFile) {
+    Factory factory = load_factory_structure(std::string_view(kProbabilityStructure));
+    std::string path = ::testing::TempDir() + "factory_binary_load.bin";
+    {
+        std::ofstream file(path, std::ios::binary);
+        save_factory_structure_binary(factory, file);
+    }
+    Factory loaded = load_factory_structure_binary_file(path);
+    std::remove(path.c_str());
+
+    EXPECT_EQ(to_text(loaded), to_text(factory));
+    EXPECT_THROW(load_factory_structure_binary_file(path), std::runtime_error);
+}
+
+TEST(FactoryBinaryTest, UnalignedBufferIsAccepted) {
+    Factory factory = load_factory_structure(std::string_view(kProbabilityStructure));
+    const std::string bytes = to_binary(factory);
+    std::string shifted = " " + bytes;
+
+    Factory loaded = load_factory_structure_binary(shifted.data() + 1, bytes.size());
+    EXPECT_EQ(to_text(loaded), to_text(factory));
+}
+
+TEST(FactoryBinaryTest, MalformedInputIsRejected) {
+    Factory factory = load_factory_structure(std::string_view(kProbabilityStructure));
+    const std::string bytes = to_binary(factory);
+
+    EXPECT_EQ(load_error("WORKER id=1"), "binary structure: missing header");
+    EXPECT_EQ(load_error(bytes.substr(0, bytes.size() - 1)), "binary structure: truncated file");
+    EXPECT_EQ(load_error(bytes + '\0'), "binary structure: trailing bytes after link table");
+
+    std::string other_version = bytes;
+    const std::uint32_t version = factory_binary::kVersion + 1;
+    std::memcpy(&other_version[offsetof(factory_binary::Header, version)], &version, sizeof(version));
+    EXPECT_EQ(load_error(other_version), "binary structure: unsupported version 2");
+
+    // Ostatni link (worker-2 -> store-2) wskazuje poza tablicę magazynów.
+    std::string bad_link = bytes;
+    const std::uint32_t index = 7;
+    std::memcpy(&bad_link[bad_link.size() - sizeof(factory_binary::LinkRecord) +
+                          offsetof(factory_binary::LinkRecord, receiver_index)], &index, sizeof(index));
+    EXPECT_EQ(load_error(bad_link), "binary structure: receiver index out of range in link 6");
+}
+
+TEST(FactoryBinaryTest, InvalidProbabilitiesAreRejected) {
+    Factory factory = load_factory_structure(std::string_view(kProbabilityStructure));
+    const std::string bytes = to_binary(factory);
+    const std::size_t probability = offsetof(factory_binary::LinkRecord, probability);
+
+    // Dwa ostatnie linki to linki worker-2 (do magazynów).
+    std::string not_a_number = bytes;
+    patch_link(not_a_number, 1, probability, std::numeric_limits<double>::quiet_NaN());
+    EXPECT_EQ(load_error(not_a_number), "binary structure: invalid probability in link 6");
+
+    std::string infinite = bytes;
+    patch_link(infinite, 1, probability, std::numeric_limits<double>::infinity());
+    EXPECT_EQ(load_error(infinite), "binary structure: invalid probability in link 6");
+
+    std::string negative = bytes;
+    patch_link(negative, 2, probability, -0.5);
+    EXPECT_EQ(load_error(negative), "binary structure: invalid probability in link 5");
+
+    std::string bad_sum = bytes;
+    patch_link(bad_sum, 1, probability, 0.6);
+    patch_link(bad_sum, 2, probability, 0.6);
+    EXPECT_EQ(load_error(bad_sum), "binary structure: probabilities of links from worker-2 sum to 1.2");
+    // Format tekstowy zgłasza ten sam komunikat (poprzedzony numerem linii).
+    std::string text_bad_sum = kProbabilityStructure;
+    text_bad_sum.replace(text_bad_sum.find("p=0.1"), 5, "p=0.6");
+    text_bad_sum.replace(text_bad_sum.find("p=0.9"), 5, "p=0.6");
+    std::string text_error;
+    try {
+        load_factory_structure(std::string_view(text_bad_sum));
+    } catch (const std::logic_error &e) {
+        text_error = e.what();
+    }
+    EXPECT_EQ(text_error, "line 12: probabilities of links from worker-2 sum to 1.2");
+
+    // Odchylenie w granicach tolerancji (jak p= zapisane w zaokrągleniu) jest przyjmowane.
+    std::string rounded = bytes;
+    patch_link(rounded, 1, probability, 0.5);
+    patch_link(rounded, 2, probability, 0.49999);
+    EXPECT_NO_THROW(load_factory_structure_binary(rounded.data(), rounded.size()));
+}
+
+TEST(FactoryBinaryTest, DuplicateReceiversAreRejected) {
+    Factory factory = load_factory_structure(std::string_view(kProbabilityStructure));
+    std::string bytes = to_binary(factory);
+
+    // Oba linki worker-2 wskazują ten sam magazyn.
+    const std::size_t receiver_index = offsetof(factory_binary::LinkRecord, receiver_index);
+    patch_link(bytes, 1, receiver_index, std::uint32_t(0));
+    patch_link(bytes, 2, receiver_index, std::uint32_t(0));
+    EXPECT_EQ(load_error(bytes), "binary structure: duplicate receiver in link 6");
+}
@@ -0,0 +1,186 @@
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include "factory.hpp"
+#include "factory_checkpoint.hpp"
+#include "reports.hpp"
+#include "simulation.hpp"
+#include "test_structures.hpp"
+
+#include <memory>
+#include <sstream>
+#include <string>
+
+namespace {
+    Factory load_structure() {
+        return load_factory_structure(std::string_view(kStructure));
+    }
+
+    /**
+     * Fabryka z magazynami wszystkich rodzajów: kolejka (domyślny), dziennik przybyć i tryb zbiorczy
+     */
+    Factory build_mixed_factory() {
+        Factory factory;
+        factory.add_ramp(Ramp(1, 1));
+        factory.add_worker(Worker(1, 2, std::make_unique<PackageQueue>(PackageQueueType::FIFO)));
+        factory.add_worker(Worker(2, 1, std::make_unique<PackageQueue>(PackageQueueType::LIFO)));
+        factory.add_storehouse(Storehouse(1));
+        factory.add_storehouse(Storehouse(2, std::make_unique<PackageLog>()));
+        factory.add_storehouse(Storehouse(3, std::make_unique<AggregateStockpile>(1, 4)));
+        Worker &w1 = *factory.find_worker_by_id(1);
+        Worker &w2 = *factory.find_worker_by_id(2);
+        factory.find_ramp_by_id(1)->receiver_preferences_.add_receiver(&w1);
+        factory.find_ramp_by_id(1)->receiver_preferences_.add_receiver(&w2);
+        for (Worker *worker: {&w1, &w2}) {
+            for (auto it = factory.storehouse_begin(); it != factory.storehouse_end(); ++it) {
+                worker->receiver_preferences_.add_receiver(&*it);
+            }
+        }
+        return factory;
+    }
+
+    std::string checkpoint(const Factory &factory) {
+        std::ostringstream oss(std::ios::binary);
+        factory.save_checkpoint(oss);
+        return oss.str();
+    }
+
+    /**
+     * Raporty kolejnych tur sklejone w jeden tekst (zawierają ID paczek w kolejkach i buforach)
+     */
+    std::string resume_with_reports(Factory &factory, TimeOffset d, SimulationEngine engine) {
+        std::ostringstream reports;
+        resume_simulation(factory, d, [&reports](Factory &f, Time t) {
+            generate_simulation_turn_report(f, reports, t);
+        }, engine);
+        return reports.str();
+    }
+
+    void replace_all(std::string &text, const std::string &from, const std::string &to) {
+        for (auto pos = text.find(from); pos != std::string::npos; pos = text.find(from, pos + to.size())) {
+            text.replace(pos, from.size(), to);
+        }
+    }
+
+    std::string restore_error(Factory &factory, const std::string &bytes) {
+        try {
+            factory.restore_checkpoint(bytes.data(), bytes.size());
+        } catch (const std::logic_error &e) {
+            return e.what();
+        }
+        return "";
+    }
+}
+
+class FactoryCheckpointEngineTest : public ::testing::TestWithParam<SimulationEngine> {
+};
+
+TEST_P(FactoryCheckpointEngineTest, RestoredRunContinuesIdentically) {
+    Factory uninterrupted = load_structure();
+    uninterrupted.set_routing_seed(7);
+    simulate(uninterrupted, 25, [](Factory &, Time) {}, GetParam());
+    const std::string expected = resume_with_reports(uninterrupted, 35, GetParam());
+
+    Factory interrupted = load_structure();
+    interrupted.set_routing_seed(7);
+    simulate(interrupted, 25, [](Factory &, Time) {}, GetParam());
+    const std::string saved = checkpoint(interrupted);
+    ASSERT_TRUE(factory_checkpoint::is_checkpoint(saved.data(), saved.size()));
+
+    // Świeżo wczytana struktura bez ziarna - ziarno, tura i rejestr ID pochodzą z punktu kontrolnego.
+    Factory restored = load_structure();
+    restored.restore_checkpoint(saved.data(), saved.size());
+    EXPECT_EQ(restored.get_time(), 25);
+    EXPECT_EQ(restored.get_routing_seed(), std::optional<std::uint64_t>(7));
+    EXPECT_EQ(checkpoint(restored), saved);
+
+    EXPECT_EQ(resume_with_reports(restored, 35, GetParam()), expected);
+    EXPECT_EQ(checkpoint(restored), checkpoint(uninterrupted));
+    EXPECT_EQ(restored.get_package_id_allocator().assigned_count(),
+              uninterrupted.get_package_id_allocator().assigned_count());
+}
+
+TEST_P(FactoryCheckpointEngineTest, RollbackOfRunningFactory) {
+    Factory factory = load_structure();
+    factory.set_routing_seed(11);
+    simulate(factory, 20, [](Factory &, Time) {}, GetParam());
+    std::istringstream saved(checkpoint(factory));
+    const std::string expected = resume_with_reports(factory, 30, GetParam());
+
+    factory.restore_checkpoint(saved);
+    EXPECT_EQ(factory.get_time(), 20);
+    EXPECT_EQ(resume_with_reports(factory, 30, GetParam()), expected);
+}
+
+INSTANTIATE_TEST_SUITE_P(Engines, FactoryCheckpointEngineTest,
+                         ::testing::Values(SimulationEngine::TURN_BASED, SimulationEngine::EVENT_DRIVEN));
+
+TEST(FactoryCheckpointTest, SharedGeneratorStateIsRestored) {
+    Factory factory = load_structure();
+    simulate(factory, 15, [](Factory &, Time) {});
+    const std::string saved = checkpoint(factory);
+    const std::string expected = resume_with_reports(factory, 20, SimulationEngine::TURN_BASED);
+
+    // Bez ziarna wybór zależy od adresów odbiorców, więc kontynuacja jest dokładna w tej samej fabryce.
+    factory.restore_checkpoint(saved.data(), saved.size());
+    EXPECT_FALSE(factory.get_routing_seed().has_value());
+    EXPECT_EQ(resume_with_reports(factory, 20, SimulationEngine::TURN_BASED), expected);
+}
+
+TEST(FactoryCheckpointTest, AllStockpileKindsAreRestored) {
+    Factory uninterrupted = build_mixed_factory();
+    uninterrupted.set_routing_seed(3);
+    simulate(uninterrupted, 40, [](Factory &, Time) {});
+
+    Factory interrupted = build_mixed_factory();
+    interrupted.set_routing_seed(3);
+    simulate(interrupted, 17, [](Factory &, Time) {});
+    const std::string saved = checkpoint(interrupted);
+
+    Factory restored = build_mixed_factory();
+    restored.restore_checkpoint(saved.data(), saved.size());
+    resume_simulation(restored, 23, [](Factory &, Time) {});
+    EXPECT_EQ(checkpoint(restored), checkpoint(uninterrupted));
+
+    const auto &log = dynamic_cast<const PackageLog &>(*restored.find_storehouse_by_id(2)->get_stockpile());
+    const auto &reference = dynamic_cast<const PackageLog &>(*uninterrupted.find_storehouse_by_id(2)->get_stockpile());
+    ASSERT_EQ(log.size(), reference.size());
+    ASSERT_GT(log.size(), 0U);
+    EXPECT_EQ(log.arrival_time(log.size() - 1), reference.arrival_time(reference.size() - 1));
+    const auto &aggregate = dynamic_cast<const AggregateStockpile &>(
+            *restored.find_storehouse_by_id(3)->get_stockpile());
+    EXPECT_GT(aggregate.get_interval(), 1);
+    EXPECT_EQ(restored.find_storehouse_by_id(3)->get_stored_count(),
+              uninterrupted.find_storehouse_by_id(3)->get_stored_count());
+}
+
+TEST(FactoryCheckpointTest, MismatchedOrMalformedCheckpointIsRejected) {
+    Factory factory = load_structure();
+    factory.set_routing_seed(5);
+    simulate(factory, 10, [](Factory &, Time) {});
+    const std::string saved = checkpoint(factory);
+
+    Factory other = build_mixed_factory();
+    simulate(other, 5, [](Factory &, Time) {});
+    const std::string before = checkpoint(other);
+    EXPECT_EQ(restore_error(other, saved), "checkpoint: node counts do not match the factory");
+    EXPECT_EQ(checkpoint(other), before);
+
+    Factory target = load_structure();
+    EXPECT_EQ(restore_error(target, "WORKER id=1"), "checkpoint: missing header");
+    EXPECT_EQ(restore_error(target, saved.substr(0, saved.size() - 1)), "checkpoint: truncated data");
+    EXPECT_EQ(restore_error(target, saved + '\0'), "checkpoint: trailing bytes after generator state");
+
+    std::string renumbered_text = kStructure;
+    replace_all(renumbered_text, "WORKER id=3", "WORKER id=4");
+    replace_all(renumbered_text, "worker-3", "worker-4");
+    Factory renumbered = load_factory_structure(std::string_view(renumbered_text));
+    EXPECT_EQ(restore_error(renumbered, saved), "checkpoint: worker 2 does not match the factory");
+
+    Factory seeded = load_structure();
+    seeded.set_routing_seed(1);
+    Factory unseeded = load_structure();
+    simulate(unseeded, 3, [](Factory &, Time) {});
+    EXPECT_EQ(restore_error(seeded, checkpoint(unseeded)),
+              "checkpoint: taken without a routing seed, but the factory has one");
+}
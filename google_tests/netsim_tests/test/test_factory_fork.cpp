@@ -0,0 +1,188 @@
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include "factory.hpp"
+#include "helpers.hpp"
+#include "reports.hpp"
+#include "simulation.hpp"
+#include "test_structures.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+    Factory warm_factory(Time turns, std::uint64_t seed = 7) {
+        Factory factory = load_factory_structure(std::string_view(kStructure));
+        factory.set_routing_seed(seed);
+        simulate(factory, turns, [](Factory &, Time) {});
+        return factory;
+    }
+
+    std::string resume_with_reports(Factory &factory, TimeOffset d) {
+        std::ostringstream reports;
+        resume_simulation(factory, d, [&reports](Factory &f, Time t) {
+            generate_simulation_turn_report(f, reports, t);
+        });
+        return reports.str();
+    }
+
+    std::string checkpoint(const Factory &factory) {
+        std::ostringstream oss(std::ios::binary);
+        factory.save_checkpoint(oss);
+        return oss.str();
+    }
+
+    const Package *first_stored(const Factory &factory, ElementID storehouse) {
+        const auto &stockpile = *factory.find_storehouse_by_id(storehouse)->get_stockpile();
+        return stockpile.begin() == stockpile.end() ? nullptr : &*stockpile.begin();
+    }
+}
+
+TEST(FactoryForkTest, BranchesContinueLikeTheOriginal) {
+    Factory original = warm_factory(30);
+    const std::string state = checkpoint(original);
+    std::vector<Factory> branches = original.fork(3);
+    ASSERT_EQ(branches.size(), 3U);
+    EXPECT_EQ(checkpoint(original), state);
+
+    for (const Factory &branch: branches) {
+        EXPECT_EQ(branch.get_time(), 30);
+        EXPECT_EQ(branch.get_routing_seed(), std::optional<std::uint64_t>(7));
+        EXPECT_TRUE(branch.is_consistent());
+        EXPECT_EQ(checkpoint(branch), state);
+        // Preferencje wskazują węzły gałęzi, nie oryginału.
+        EXPECT_EQ(branch.get_senders_of(&*original.find_worker_by_id(2)).size(), 0U);
+        EXPECT_EQ(branch.get_senders_of(&*branch.find_worker_by_id(2)).size(), 3U);
+    }
+
+    const std::string expected = resume_with_reports(original, 40);
+    for (Factory &branch: branches) {
+        EXPECT_EQ(resume_with_reports(branch, 40), expected);
+        EXPECT_EQ(checkpoint(branch), checkpoint(original));
+    }
+}
+
+TEST(FactoryForkTest, BranchesShareUnchangedContents) {
+    Factory original = warm_factory(30);
+    std::vector<Factory> branches = original.fork(2);
+    ASSERT_NE(first_stored(branches[0], 1), nullptr);
+    // Te same paczki pod tym samym adresem - zawartość magazynu nie została skopiowana dla każdej gałęzi.
+    EXPECT_EQ(first_stored(branches[0], 1), first_stored(branches[1], 1));
+    EXPECT_NE(first_stored(branches[0], 1), first_stored(original, 1));
+
+    // Rozgałęzienie niezmienionej gałęzi dalej współdzieli tę samą kopię.
+    std::vector<Factory> nested = branches[1].fork(1);
+    EXPECT_EQ(first_stored(nested[0], 1), first_stored(branches[1], 1));
+
+    const std::string untouched = checkpoint(branches[1]);
+    resume_simulation(branches[0], 20, [](Factory &, Time) {});
+    EXPECT_EQ(checkpoint(branches[1]), untouched);
+    EXPECT_EQ(checkpoint(nested[0]), untouched);
+}
+
+TEST(FactoryForkTest, BranchesHaveIndependentIdRegistries) {
+    Factory original = warm_factory(30);
+    const std::size_t assigned = original.get_package_id_allocator().assigned_count();
+    ASSERT_GT(assigned, 0U);
+    {
+        std::vector<Factory> branches = original.fork(2);
+        EXPECT_EQ(branches[0].get_package_id_allocator().assigned_count(), assigned);
+
+        // Usunięcie robotnika zwalnia ID jego paczek (także tych ze współdzielonej kopii) tylko w tej gałęzi.
+        const std::size_t queued = branches[0].find_worker_by_id(2)->get_queue()->size();
+        ASSERT_GT(queued, 0U);
+        branches[0].remove_worker(2);
+        EXPECT_LE(branches[0].get_package_id_allocator().assigned_count(), assigned - queued);
+        EXPECT_EQ(branches[1].get_package_id_allocator().assigned_count(), assigned);
+        EXPECT_EQ(original.get_package_id_allocator().assigned_count(), assigned);
+    }
+    EXPECT_EQ(original.get_package_id_allocator().assigned_count(), assigned);
+}
+
+TEST(FactoryForkTest, BranchesRunInParallelWithOwnSeeds) {
+    Factory original = warm_factory(25);
+    std::vector<Factory> branches = original.fork(4);
+    std::vector<Factory> reference = original.fork(4);
+    std::vector<std::string> results(branches.size());
+    std::vector<std::thread> threads;
+    for (std::size_t i = 0; i < branches.size(); ++i) {
+        threads.emplace_back([&branches, &results, i] {
+            branches[i].set_routing_seed(100 + i);
+            results[i] = resume_with_reports(branches[i], 50);
+        });
+    }
+    for (auto &thread: threads) {
+        thread.join();
+    }
+    for (std::size_t i = 0; i < reference.size(); ++i) {
+        reference[i].set_routing_seed(100 + i);
+        EXPECT_EQ(resume_with_reports(reference[i], 50), results[i]);
+    }
+    EXPECT_NE(results[0], results[1]);
+}
+
+TEST(FactoryForkTest, BranchesOfUnseededFactoryGetOwnSeeds) {
+    Factory original = load_factory_structure(std::string_view(kStructure));
+    simulate(original, 20, [](Factory &, Time) {});
+    ASSERT_FALSE(original.get_routing_seed().has_value());
+
+    // Ziarno gałęzi to dwa kolejne losowania rng: najpierw starsza, potem młodsza połowa.
+    std::mt19937 expected_rng = rng;
+    const std::uint64_t high = expected_rng();
+    const std::uint64_t low = expected_rng();
+    std::vector<Factory> branches = original.fork(3);
+    EXPECT_EQ(*branches[0].get_routing_seed(), (high << 32) | low);
+    for (const Factory &branch: branches) {
+        ASSERT_TRUE(branch.get_routing_seed().has_value());
+    }
+    EXPECT_NE(*branches[0].get_routing_seed(), *branches[1].get_routing_seed());
+    EXPECT_NE(*branches[1].get_routing_seed(), *branches[2].get_routing_seed());
+    EXPECT_FALSE(original.get_routing_seed().has_value());
+
+    // Gałęzie nie korzystają ze wspólnego rng, więc mogą działać równolegle bez wyścigu.
+    std::vector<std::thread> threads;
+    for (Factory &branch: branches) {
+        threads.emplace_back([&branch] { resume_simulation(branch, 30, [](Factory &, Time) {}); });
+    }
+    for (auto &thread: threads) {
+        thread.join();
+    }
+    for (const Factory &branch: branches) {
+        EXPECT_EQ(branch.get_time(), 50);
+    }
+}
+
+TEST(FactoryForkTest, LogAndAggregateStorehousesAreForked) {
+    auto build = [] {
+        Factory factory;
+        factory.add_ramp(Ramp(1, 1));
+        factory.add_worker(Worker(1, 2, std::make_unique<PackageQueue>(PackageQueueType::FIFO)));
+        factory.add_storehouse(Storehouse(1, std::make_unique<PackageLog>()));
+        factory.add_storehouse(Storehouse(2, std::make_unique<AggregateStockpile>(1, 4)));
+        Worker &worker = *factory.find_worker_by_id(1);
+        factory.find_ramp_by_id(1)->receiver_preferences_.add_receiver(&worker);
+        worker.receiver_preferences_.add_receiver(&*factory.find_storehouse_by_id(1));
+        worker.receiver_preferences_.add_receiver(&*factory.find_storehouse_by_id(2));
+        factory.set_routing_seed(9);
+        return factory;
+    };
+    Factory original = build();
+    simulate(original, 30, [](Factory &, Time) {});
+    Factory branch = std::move(original.fork(1).front());
+    resume_simulation(original, 30, [](Factory &, Time) {});
+    resume_simulation(branch, 30, [](Factory &, Time) {});
+    EXPECT_EQ(checkpoint(branch), checkpoint(original));
+
+    const auto &log = dynamic_cast<const PackageLog &>(*branch.find_storehouse_by_id(1)->get_stockpile());
+    const auto &reference = dynamic_cast<const PackageLog &>(*original.find_storehouse_by_id(1)->get_stockpile());
+    for (Time t: {1, 10, 29, 30, 31, 45, 60}) {
+        EXPECT_EQ(log.arrivals_between(t, t + 5).first, reference.arrivals_between(t, t + 5).first) << t;
+        EXPECT_EQ(log.arrivals_between(t, t + 5).last, reference.arrivals_between(t, t + 5).last) << t;
+    }
+    EXPECT_EQ(branch.find_storehouse_by_id(2)->get_stored_count(), original.find_storehouse_by_id(2)->get_stored_count());
+}
@@ -2,8 +2,13 @@
 #include "gtest/gtest.h"
 
 #include "factory.hpp"
+#include "test_structures.hpp"
 
+#include <cstdio>
+#include <fstream>
 #include <set>
+#include <sstream>
+#include <string>
 
 //using ::testing::Return;
 //using ::testing::_;
@@ -64,26 +69,26 @@ TEST(FactoryIOTest, ParseLinkOneReceiver) {
     EXPECT_DOUBLE_EQ(prefs[key], 1.0);
 }
 
-//TEST(FactoryIOTest, ParseLinkOneReceiverWithDefinedProbability) {
-//    std::ostringstream oss;
-//    oss << "LOADING_RAMP id=1 delivery-interval=3" << "\n"
-//        << "STOREHOUSE id=1" << "\n"
-//        << "LINK src=ramp-1 dest=store-1 p=1.0" << "\n";
-//    std::istringstream iss(oss.str());
-//    auto factory = load_factory_structure(iss);
-//
-//    ASSERT_EQ(std::next(factory.ramp_cbegin(), 1), factory.ramp_cend());
-//    const auto& r = *(factory.ramp_cbegin());
-//
-//    ASSERT_EQ(std::next(factory.storehouse_cbegin(), 1), factory.storehouse_cend());
-//    const auto& s = *(factory.storehouse_cbegin());
-//
-//    auto prefs = r.receiver_preferences_.get_preferences();
-//    ASSERT_EQ(1U, prefs.size());
-//    auto key = dynamic_cast<IPackageReceiver*>(const_cast<Storehouse*>(&s));
-//    ASSERT_NE(prefs.find(key), prefs.end());
-//    EXPECT_DOUBLE_EQ(prefs[key], 1.0);
-//}
+TEST(FactoryIOTest, ParseLinkOneReceiverWithDefinedProbability) {
+    std::ostringstream oss;
+    oss << "LOADING_RAMP id=1 delivery-interval=3" << "\n"
+        << "STOREHOUSE id=1" << "\n"
+        << "LINK src=ramp-1 dest=store-1 p=1.0" << "\n";
+    std::istringstream iss(oss.str());
+    auto factory = load_factory_structure(iss);
+
+    ASSERT_EQ(std::next(factory.ramp_cbegin(), 1), factory.ramp_cend());
+    const auto& r = *(factory.ramp_cbegin());
+
+    ASSERT_EQ(std::next(factory.storehouse_cbegin(), 1), factory.storehouse_cend());
+    const auto& s = *(factory.storehouse_cbegin());
+
+    auto prefs = r.receiver_preferences_.get_preferences();
+    ASSERT_EQ(1U, prefs.size());
+    auto key = dynamic_cast<IPackageReceiver*>(const_cast<Storehouse*>(&s));
+    ASSERT_NE(prefs.find(key), prefs.end());
+    EXPECT_DOUBLE_EQ(prefs[key], 1.0);
+}
 
 TEST(FactoryIOTest, ParseLinkMultipleReceivers) {
     std::ostringstream oss;
@@ -112,32 +117,32 @@ TEST(FactoryIOTest, ParseLinkMultipleReceivers) {
     EXPECT_DOUBLE_EQ(prefs[key2], 0.5);
 }
 
-//TEST(FactoryIOTest, ParseLinkMultipleReceiversWithDefinedProbabilities) {
-//    std::ostringstream oss;
-//    oss << "LOADING_RAMP id=1 delivery-interval=3" << "\n"
-//        << "STOREHOUSE id=1" << "\n"
-//        << "STOREHOUSE id=2" << "\n"
-//        << "LINK src=ramp-1 dest=store-1 p=0.3" << "\n"
-//        << "LINK src=ramp-1 dest=store-2 p=0.7" << "\n";
-//    std::istringstream iss(oss.str());
-//    auto factory = load_factory_structure(iss);
-//
-//    ASSERT_EQ(std::next(factory.ramp_cbegin(), 1), factory.ramp_cend());
-//    const auto& r = *(factory.ramp_cbegin());
-//
-//    ASSERT_EQ(std::next(factory.storehouse_cbegin(), 2), factory.storehouse_cend());
-//    const auto& s1 = *(factory.storehouse_cbegin());
-//    const auto& s2 = *(std::next(factory.storehouse_cbegin(), 1));
-//
-//    auto prefs = r.receiver_preferences_.get_preferences();
-//    ASSERT_EQ(2U, prefs.size());
-//    auto key1 = dynamic_cast<IPackageReceiver*>(const_cast<Storehouse*>(&s1));
-//    auto key2 = dynamic_cast<IPackageReceiver*>(const_cast<Storehouse*>(&s2));
-//    ASSERT_NE(prefs.find(key1), prefs.end());
-//    ASSERT_NE(prefs.find(key2), prefs.end());
-//    EXPECT_DOUBLE_EQ(prefs[key1], 0.3);
-//    EXPECT_DOUBLE_EQ(prefs[key2], 0.7);
-//}
+TEST(FactoryIOTest, ParseLinkMultipleReceiversWithDefinedProbabilities) {
+    std::ostringstream oss;
+    oss << "LOADING_RAMP id=1 delivery-interval=3" << "\n"
+        << "STOREHOUSE id=1" << "\n"
+        << "STOREHOUSE id=2" << "\n"
+        << "LINK src=ramp-1 dest=store-1 p=0.3" << "\n"
+        << "LINK src=ramp-1 dest=store-2 p=0.7" << "\n";
+    std::istringstream iss(oss.str());
+    auto factory = load_factory_structure(iss);
+
+    ASSERT_EQ(std::next(factory.ramp_cbegin(), 1), factory.ramp_cend());
+    const auto& r = *(factory.ramp_cbegin());
+
+    ASSERT_EQ(std::next(factory.storehouse_cbegin(), 2), factory.storehouse_cend());
+    const auto& s1 = *(factory.storehouse_cbegin());
+    const auto& s2 = *(std::next(factory.storehouse_cbegin(), 1));
+
+    auto prefs = r.receiver_preferences_.get_preferences();
+    ASSERT_EQ(2U, prefs.size());
+    auto key1 = dynamic_cast<IPackageReceiver*>(const_cast<Storehouse*>(&s1));
+    auto key2 = dynamic_cast<IPackageReceiver*>(const_cast<Storehouse*>(&s2));
+    ASSERT_NE(prefs.find(key1), prefs.end());
+    ASSERT_NE(prefs.find(key2), prefs.end());
+    EXPECT_DOUBLE_EQ(prefs[key1], 0.3);
+    EXPECT_DOUBLE_EQ(prefs[key2], 0.7);
+}
 
 TEST(FactoryIOTest, LoadAndSaveTest) {
     std::string r1 = "LOADING_RAMP id=1 delivery-interval=3";
@@ -243,3 +248,116 @@ TEST(FactoryIOTest, LoadAndSaveTest) {
     ASSERT_LT(first_worker_it, first_storehouse_it);
     ASSERT_LT(first_storehouse_it, first_link_it);
 }
+
+namespace {
+    std::string load_error(const std::string &text) {
+        try {
+            load_factory_structure(std::string_view(text));
+        } catch (const std::logic_error &e) {
+            return e.what();
+        }
+        return "";
+    }
+}
+
+TEST(FactoryIOTest, ErrorsReportLineNumber) {
+    EXPECT_EQ("line 3: unknown tag: CONVEYOR", load_error("WORKER id=1 processing-time=1 queue-type=FIFO\n\nCONVEYOR id=2\n"));
+    EXPECT_EQ("line 1: unknown key: speed", load_error("LOADING_RAMP id=1 delivery-interval=1 speed=2"));
+    EXPECT_EQ("line 1: missing key: delivery-interval", load_error("LOADING_RAMP id=1"));
+    EXPECT_EQ("line 1: invalid value of 'id': 1x", load_error("STOREHOUSE id=1x"));
+    EXPECT_EQ("line 1: unknown queue type: RANDOM", load_error("WORKER id=1 processing-time=1 queue-type=RANDOM"));
+    EXPECT_EQ("line 2: worker not found: 7", load_error("LOADING_RAMP id=1 delivery-interval=1\nLINK src=ramp-1 dest=worker-7"));
+    EXPECT_EQ("line 2: storehouse cannot be a link source", load_error("STOREHOUSE id=1\nLINK src=store-1 dest=store-1"));
+}
+
+TEST(FactoryIOTest, ProbabilitiesMustSumToOne) {
+    const std::string nodes = "LOADING_RAMP id=1 delivery-interval=1\nWORKER id=1 processing-time=1 queue-type=FIFO\n"
+                              "STOREHOUSE id=1\nSTOREHOUSE id=2\nSTOREHOUSE id=3\n";
+    EXPECT_EQ("line 7: probabilities of links from worker-1 sum to 0.8",
+              load_error(nodes + "LINK src=ramp-1 dest=worker-1\n"
+                                 "LINK src=worker-1 dest=store-1 p=0.3\nLINK src=worker-1 dest=store-2 p=0.5\n"));
+    // Link bez p= dostaje równy podział: 0.5 + 1/3 + 1/3.
+    EXPECT_EQ("line 6: probabilities of links from ramp-1 sum to 1.16667",
+              load_error(nodes + "LINK src=ramp-1 dest=store-1 p=0.5\nLINK src=ramp-1 dest=store-2\n"
+                                 "LINK src=ramp-1 dest=store-3\n"));
+    // Zaokrąglenie do 6 cyfr mieści się w tolerancji.
+    EXPECT_EQ("", load_error(nodes + "LINK src=ramp-1 dest=store-1 p=0.333333\nLINK src=ramp-1 dest=store-2 p=0.333333\n"
+                                     "LINK src=ramp-1 dest=store-3 p=0.333333\n"));
+    EXPECT_EQ("", load_error(nodes + "LINK src=ramp-1 dest=store-1 p=0.5\nLINK src=ramp-1 dest=store-2\n"));
+}
+
+TEST(FactoryIOTest, LoadFromStringViewAcceptsCrLfAndComments) {
+    auto factory = load_factory_structure(std::string_view(
+            "; == RAMPS ==\r\n"
+            "LOADING_RAMP id=1 delivery-interval=3\r\n"
+            "\r\n"
+            "STOREHOUSE  id=2\r\n"
+            "LINK\tsrc=ramp-1 dest=store-2\r\n"));
+
+    ASSERT_NE(factory.find_ramp_by_id(1), factory.ramp_cend());
+    ASSERT_NE(factory.find_storehouse_by_id(2), factory.storehouse_cend());
+    auto prefs = factory.find_ramp_by_id(1)->receiver_preferences_.get_preferences();
+    ASSERT_EQ(prefs.size(), 1U);
+    EXPECT_EQ(prefs.begin()->first->get_id(), 2);
+}
+
+TEST(FactoryIOTest, LoadFromFile) {
+    std::string path = ::testing::TempDir() + "factory_io_load.txt";
+    {
+        std::ofstream file(path);
+        file << "WORKER id=1 processing-time=2 queue-type=LIFO\nSTOREHOUSE id=1\nLINK src=worker-1 dest=store-1\n";
+    }
+    auto factory = load_factory_structure_file(path);
+    std::remove(path.c_str());
+
+    ASSERT_NE(factory.find_worker_by_id(1), factory.worker_cend());
+    EXPECT_EQ(factory.find_worker_by_id(1)->get_queue()->get_queue_type(), PackageQueueType::LIFO);
+    EXPECT_TRUE(factory.is_consistent());
+    EXPECT_THROW(load_factory_structure_file(path), std::runtime_error);
+}
+
+TEST(FactoryIOTest, SaveOrdersNodesAndLinksNumerically) {
+    auto factory = load_factory_structure(std::string_view(
+            "LOADING_RAMP id=10 delivery-interval=1\n"
+            "LOADING_RAMP id=2 delivery-interval=1\n"
+            "WORKER id=10 processing-time=1 queue-type=FIFO\n"
+            "WORKER id=9 processing-time=1 queue-type=LIFO\n"
+            "STOREHOUSE id=10\n"
+            "STOREHOUSE id=2\n"
+            "LINK src=ramp-10 dest=worker-10\n"
+            "LINK src=ramp-2 dest=worker-9\n"
+            "LINK src=worker-10 dest=worker-9\n"
+            "LINK src=worker-10 dest=store-10\n"
+            "LINK src=worker-10 dest=store-2\n"
+            "LINK src=worker-9 dest=store-10\n"));
+
+    std::ostringstream oss;
+    save_factory_structure(factory, oss);
+    EXPECT_EQ(oss.str(),
+              "\n; == LOADING RAMPS ==\n\n"
+              "LOADING_RAMP id=2 delivery-interval=1\n"
+              "LOADING_RAMP id=10 delivery-interval=1\n"
+              "\n; == WORKERS ==\n\n"
+              "WORKER id=9 processing-time=1 queue-type=LIFO\n"
+              "WORKER id=10 processing-time=1 queue-type=FIFO\n"
+              "\n; == STOREHOUSES ==\n\n"
+              "STOREHOUSE id=2\n"
+              "STOREHOUSE id=10\n"
+              "\n; == LINKS ==\n"
+              "LINK src=ramp-2 dest=worker-9\n"
+              "LINK src=ramp-10 dest=worker-10\n"
+              "LINK src=worker-9 dest=store-10\n"
+              "LINK src=worker-10 dest=store-2\n"
+              "LINK src=worker-10 dest=store-10\n"
+              "LINK src=worker-10 dest=worker-9\n");
+}
+
+TEST(FactoryIOTest, UniformProbabilitiesAreNotWritten) {
+    Factory factory = load_factory_structure(std::string_view(kProbabilityStructure));
+    const std::string text = to_text(factory);
+
+    EXPECT_THAT(text, ::testing::HasSubstr("LINK src=worker-1 dest=store-1\n"));
+    EXPECT_THAT(text, ::testing::HasSubstr("LINK src=ramp-2 dest=worker-1 p=0.25\n"));
+    EXPECT_THAT(text, ::testing::HasSubstr("LINK src=worker-2 dest=store-2 p=0.9\n"));
+    EXPECT_EQ(to_text(load_factory_structure(std::string_view(text))), text);
+}
@@ -0,0 +1,208 @@
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include "factory.hpp"
+#include "reports.hpp"
+#include "simulation.hpp"
+#include "test_structures.hpp"
+
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+    const NodeCounterRecord &find(const std::vector<NodeCounterRecord> &records, ElementType type, ElementID id) {
+        for (const auto &record: records) {
+            if (record.type == type && record.id == id) {
+                return record;
+            }
+        }
+        throw std::logic_error("no counters for node");
+    }
+
+    std::string counters_csv(const Factory &factory) {
+        std::ostringstream oss;
+        write_node_counters_csv(factory, oss);
+        return oss.str();
+    }
+}
+
+class NodeCountersTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        if (!kNodeCountersEnabled) {
+            GTEST_SKIP() << "node counters are compiled out";
+        }
+    }
+};
+
+TEST_F(NodeCountersTest, ChainIsCounted) {
+    Factory factory = make_chain(1, 2);
+    simulate(factory, 10, [](Factory &, Time) {});
+    const auto records = factory.get_node_counters();
+    ASSERT_EQ(records.size(), 3U);
+
+    const NodeCounters &ramp = find(records, ElementType::RAMP, 1).counters;
+    EXPECT_EQ(ramp.received, 10U);
+    EXPECT_EQ(ramp.sent, 10U);
+
+    // Robotnik kończy paczkę co dwie tury (t = 2, 4, ..., 10); ostatnia czeka w buforze nadawczym.
+    const NodeCounterRecord &worker = find(records, ElementType::WORKER, 1);
+    EXPECT_EQ(worker.counters.received, 10U);
+    EXPECT_EQ(worker.counters.sent, 4U);
+    EXPECT_EQ(worker.counters.busy_turns, 10U);
+    EXPECT_EQ(worker.idle_turns, 0U);
+    EXPECT_EQ(worker.counters.max_queue_depth, 5U);
+    EXPECT_EQ(worker.counters.blocked_turns, 0U);
+
+    EXPECT_EQ(find(records, ElementType::STOREHOUSE, 1).counters.received, 4U);
+}
+
+TEST_F(NodeCountersTest, IdleTurnsIncludeSkippedTurns) {
+    for (SimulationEngine engine: {SimulationEngine::TURN_BASED, SimulationEngine::EVENT_DRIVEN}) {
+        Factory factory = make_chain(3, 1);
+        simulate(factory, 9, [](Factory &, Time) {}, engine);
+        const auto records = factory.get_node_counters();
+        const NodeCounterRecord &worker = find(records, ElementType::WORKER, 1);
+        EXPECT_EQ(worker.counters.busy_turns, 3U);
+        EXPECT_EQ(worker.idle_turns, 6U);
+    }
+
+    // Trwające przetwarzanie jest liczone do bieżącej tury.
+    Factory factory = make_chain(10, 4);
+    simulate(factory, 2, [](Factory &, Time) {});
+    const auto records = factory.get_node_counters();
+    const NodeCounterRecord &worker = find(records, ElementType::WORKER, 1);
+    EXPECT_EQ(worker.counters.busy_turns, 2U);
+    EXPECT_EQ(worker.idle_turns, 0U);
+}
+
+TEST_F(NodeCountersTest, EnginesAndThreadsGiveTheSameCounters) {
+    auto run = [](SimulationEngine engine, std::size_t threads) {
+        Factory factory = load_factory_structure(std::string_view(kStructure));
+        factory.set_routing_seed(5);
+        factory.set_thread_count(threads);
+        simulate(factory, 60, [](Factory &, Time) {}, engine);
+        return counters_csv(factory);
+    };
+    const std::string expected = run(SimulationEngine::TURN_BASED, 1);
+    EXPECT_EQ(run(SimulationEngine::EVENT_DRIVEN, 1), expected);
+    EXPECT_EQ(run(SimulationEngine::TURN_BASED, 3), expected);
+
+    // Każda przekazana paczka jest raz wysłana i raz odebrana.
+    Factory factory = load_factory_structure(std::string_view(kStructure));
+    simulate(factory, 60, [](Factory &, Time) {});
+    std::uint64_t sent = 0;
+    std::uint64_t received = 0;
+    for (const auto &record: factory.get_node_counters()) {
+        sent += record.counters.sent;
+        received += record.type == ElementType::RAMP ? 0 : record.counters.received;
+    }
+    EXPECT_EQ(sent, received);
+}
+
+TEST_F(NodeCountersTest, PackageLeftInSendingBufferBlocks) {
+    Factory factory = make_chain(1, 1);
+    factory.do_deliveries(1);
+    factory.do_package_passing();
+    factory.do_work(1);
+    // Bez przekazania w turze 2 paczka robotnika i nowa paczka rampy nie opuszczają buforów.
+    factory.do_work(2);
+    factory.do_deliveries(2);
+    factory.do_deliveries(3);
+    const auto records = factory.get_node_counters();
+    EXPECT_EQ(find(records, ElementType::WORKER, 1).counters.blocked_turns, 1U);
+    EXPECT_EQ(find(records, ElementType::RAMP, 1).counters.blocked_turns, 1U);
+}
+
+TEST_F(NodeCountersTest, ResetRemoveAndGrowth) {
+    Factory factory = make_chain(1, 2);
+    simulate(factory, 10, [](Factory &, Time) {});
+    factory.reset_node_counters();
+    for (const auto &record: factory.get_node_counters()) {
+        EXPECT_EQ(record.counters.received, 0U);
+        EXPECT_EQ(record.counters.since, 10);
+    }
+
+    // Dużo nowych węzłów przenosi tablicę liczników - wskaźniki istniejących węzłów muszą zostać przepięte.
+    for (ElementID id = 2; id <= 200; ++id) {
+        factory.add_storehouse(Storehouse(id));
+    }
+    resume_simulation(factory, 4, [](Factory &, Time) {});
+    auto records = factory.get_node_counters();
+    EXPECT_EQ(records.size(), 202U);
+    EXPECT_EQ(find(records, ElementType::RAMP, 1).counters.received, 4U);
+    EXPECT_EQ(find(records, ElementType::STOREHOUSE, 1).counters.received, 2U);
+    EXPECT_EQ(find(records, ElementType::STOREHOUSE, 200).counters.since, 10);
+
+    // Wpis usuniętego węzła dostaje następny dodany węzeł - z wyzerowanymi licznikami.
+    factory.remove_storehouse(1);
+    factory.add_storehouse(Storehouse(1));
+    factory.find_worker_by_id(1)->receiver_preferences_.add_receiver(&*factory.find_storehouse_by_id(1));
+    records = factory.get_node_counters();
+    EXPECT_EQ(records.size(), 202U);
+    EXPECT_EQ(find(records, ElementType::STOREHOUSE, 1).counters.received, 0U);
+    EXPECT_EQ(find(records, ElementType::STOREHOUSE, 1).counters.since, 14);
+}
+
+TEST_F(NodeCountersTest, ForkAndRestoreCountFromTheNewTurn) {
+    Factory factory = make_chain(1, 2);
+    simulate(factory, 50, [](Factory &, Time) {});
+
+    // Gałąź nie ma za sobą tur oryginału - nie jest ani zajęta, ani bezczynna przed turą rozgałęzienia.
+    std::vector<Factory> branches = factory.fork(1);
+    auto records = branches[0].get_node_counters();
+    const NodeCounterRecord &forked = find(records, ElementType::WORKER, 1);
+    EXPECT_EQ(forked.counters.since, 50);
+    EXPECT_EQ(forked.counters.received, 0U);
+    EXPECT_EQ(forked.idle_turns, 0U);
+    resume_simulation(branches[0], 10, [](Factory &, Time) {});
+    records = branches[0].get_node_counters();
+    EXPECT_EQ(find(records, ElementType::RAMP, 1).counters.received, 10U);
+    EXPECT_EQ(find(records, ElementType::WORKER, 1).counters.busy_turns, 10U);
+    EXPECT_EQ(find(records, ElementType::WORKER, 1).idle_turns, 0U);
+
+    // Cofnięcie do punktu kontrolnego odrzuca sumy z tur, które zostaną powtórzone.
+    Factory rewound = make_chain(1, 2);
+    simulate(rewound, 5, [](Factory &, Time) {});
+    std::ostringstream checkpoint(std::ios::binary);
+    rewound.save_checkpoint(checkpoint);
+    resume_simulation(rewound, 10, [](Factory &, Time) {});
+    std::istringstream is(checkpoint.str(), std::ios::binary);
+    rewound.restore_checkpoint(is);
+    records = rewound.get_node_counters();
+    EXPECT_EQ(find(records, ElementType::WORKER, 1).counters.since, 5);
+    EXPECT_EQ(find(records, ElementType::WORKER, 1).counters.busy_turns, 0U);
+    EXPECT_EQ(find(records, ElementType::RAMP, 1).counters.received, 0U);
+    resume_simulation(rewound, 10, [](Factory &, Time) {});
+    records = rewound.get_node_counters();
+    EXPECT_EQ(find(records, ElementType::RAMP, 1).counters.received, 10U);
+    EXPECT_EQ(find(records, ElementType::WORKER, 1).counters.busy_turns, 10U);
+    EXPECT_EQ(find(records, ElementType::WORKER, 1).idle_turns, 0U);
+}
+
+TEST_F(NodeCountersTest, Exports) {
+    Factory factory = make_chain(1, 2);
+    simulate(factory, 10, [](Factory &, Time) {});
+
+    EXPECT_EQ(counters_csv(factory),
+              "type,id,received,sent,busy_turns,idle_turns,blocked_turns,max_queue_depth,since\n"
+              "ramp,1,10,10,0,0,0,0,0\n"
+              "worker,1,10,4,10,0,0,5,0\n"
+              "storehouse,1,4,0,0,0,0,0,0\n");
+
+    std::ostringstream json;
+    write_node_counters_json(factory, json);
+    EXPECT_THAT(json.str(), ::testing::StartsWith("{\"time\": 10, \"nodes\": [\n"));
+    EXPECT_THAT(json.str(), ::testing::HasSubstr(
+            "{\"type\": \"worker\", \"id\": 1, \"received\": 10, \"sent\": 4, \"busy_turns\": 10, \"idle_turns\": 0, "
+            "\"blocked_turns\": 0, \"max_queue_depth\": 5, \"since\": 0}"));
+
+    std::ostringstream metrics;
+    write_node_counters_openmetrics(factory, metrics);
+    EXPECT_THAT(metrics.str(), ::testing::HasSubstr("# TYPE netsim_node_packages_sent counter\n"));
+    EXPECT_THAT(metrics.str(), ::testing::HasSubstr("netsim_node_packages_sent_total{type=\"worker\",id=\"1\"} 4\n"));
+    EXPECT_THAT(metrics.str(), ::testing::HasSubstr("netsim_node_max_queue_depth{type=\"worker\",id=\"1\"} 5\n"));
+    EXPECT_THAT(metrics.str(), ::testing::EndsWith("# EOF\n"));
+}
@@ -1,6 +1,7 @@
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 
+#include "counter_rng.hpp"
 #include "nodes.hpp"
 #include "package.hpp"
 #include "storage_types.hpp"
@@ -9,7 +10,10 @@
 #include "nodes_mocks.hpp"
 #include "global_functions_mock.hpp"
 
+#include <array>
 #include <iostream>
+#include <memory>
+#include <vector>
 
 using ::std::cout;
 using ::std::endl;
@@ -34,6 +38,16 @@ TEST(WorkerTest, HasBuffer) {
     EXPECT_EQ(buffer.value().get_id(), 1);
 }
 
+TEST(WorkerTest, IdleWorkerDoesNotFinishNonexistentPackage) {
+    // Pusty robotnik z pd = 2: warunek zakończenia (start + pd == t + 1) jest spełniony w turze 1
+    // dla domyślnego czasu rozpoczęcia 0 - nie może to oznaczać zakończenia przetwarzania.
+    Worker w(1, 2, std::make_unique<PackageQueue>(PackageQueueType::FIFO));
+
+    EXPECT_NO_THROW(w.do_work(1));
+    EXPECT_FALSE(w.get_sending_buffer().has_value());
+    EXPECT_FALSE(w.get_processing_buffer().has_value());
+}
+
 // -----------------
 
 TEST(RampTest, IsDeliveryOnTime) {
@@ -115,6 +129,35 @@ TEST_F(ReceiverPreferencesChoosingTest, ChooseReceiver) {
     }
 }
 
+TEST(ReceiverPreferencesTest, ChooseReceiverFollowsNonUniformPreferences) {
+    // Równomiernie rozłożone wartości generatora muszą trafiać do odbiorców w proporcji ich preferencji.
+    const int n = 1000;
+    int draw = 0;
+    ReceiverPreferences rp([&draw]() { return (draw++ + 0.5) / n; });
+
+    MockReceiver r1, r2, r3;
+    rp.set_preferences({{&r1, 0.2}, {&r2, 0.5}, {&r3, 0.3}});
+
+    std::map<IPackageReceiver*, int> counts;
+    for (int i = 0; i < n; ++i) {
+        ++counts[rp.choose_receiver()];
+    }
+    EXPECT_EQ(counts[&r1], 200);
+    EXPECT_EQ(counts[&r2], 500);
+    EXPECT_EQ(counts[&r3], 300);
+
+    // Zmiana preferencji unieważnia tablicę aliasów.
+    rp.remove_receiver(&r2);
+    draw = 0;
+    counts.clear();
+    for (int i = 0; i < n; ++i) {
+        ++counts[rp.choose_receiver()];
+    }
+    EXPECT_EQ(counts[&r1], 500);
+    EXPECT_EQ(counts[&r3], 500);
+    EXPECT_EQ(counts.count(&r2), 0U);
+}
+
 // -----------------
 
 using ::testing::Return;
@@ -159,3 +202,111 @@ TEST(PackageSenderTest, SendPackage) {
     // Upewnij się, że proces wysyłania zachodzi tylko wówczas, gdy w bufor jest pełny.
     sender.send_package();
 }
+
+// -----------------
+
+TEST(PackageTransferTest, PackageCrossingNodesTouchesIdRegistryTwice) {
+    // R -> W1 -> ... -> WN -> S: przenoszenie paczki między węzłami nie może sięgać do rejestru ID.
+    const PackageIDAllocator& ids = Package::get_id_allocator();
+    const std::size_t allocations_before = ids.allocation_count();
+    const std::size_t releases_before = ids.release_count();
+    const int n_workers = 5;
+
+    {
+        Ramp r(1, 100);
+        Storehouse s(1);
+        std::vector<std::unique_ptr<Worker>> workers;
+        for (int i = 1; i <= n_workers; ++i) {
+            workers.push_back(std::make_unique<Worker>(i, 1, std::make_unique<PackageQueue>(PackageQueueType::FIFO)));
+        }
+        r.receiver_preferences_.add_receiver(workers.front().get());
+        for (int i = 0; i + 1 < n_workers; ++i) {
+            workers[i]->receiver_preferences_.add_receiver(workers[i + 1].get());
+        }
+        workers.back()->receiver_preferences_.add_receiver(&s);
+
+        for (Time t = 1; t <= n_workers + 2; ++t) {
+            r.deliver_goods(t);
+            r.send_package();
+            for (auto& w : workers) {
+                w->send_package();
+            }
+            for (auto& w : workers) {
+                w->do_work(t);
+            }
+        }
+
+        ASSERT_NE(s.cbegin(), s.cend());
+        EXPECT_EQ(ids.allocation_count() - allocations_before, 1U);
+        EXPECT_EQ(ids.release_count() - releases_before, 0U);
+    }
+
+    EXPECT_EQ(ids.allocation_count() - allocations_before, 1U);
+    EXPECT_EQ(ids.release_count() - releases_before, 1U);
+}
+
+// -----------------
+
+TEST(CounterRngTest, PhiloxMatchesReferenceVectors) {
+    // Wektory kontrolne z biblioteki Random123 (kat_vectors, philox4x32 10).
+    using Block = std::array<std::uint32_t, 4>;
+    EXPECT_EQ(philox4x32_10({0, 0, 0, 0}, {0, 0}), (Block{0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8}));
+    EXPECT_EQ(philox4x32_10({0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff}, {0xffffffff, 0xffffffff}),
+              (Block{0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd}));
+    EXPECT_EQ(philox4x32_10({0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344}, {0xa4093822, 0x299f31d0}),
+              (Block{0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1}));
+}
+
+TEST(CounterRngTest, DrawDependsOnlyOnSeedStreamTurnAndIndex) {
+    Time turn = 7;
+    RoutingRandomSource source(42, &turn);
+    RoutingRandomSource same_seed(42, &turn);
+    RoutingRandomSource other_seed(43, &turn);
+
+    double u = source.uniform(5, 0);
+    EXPECT_EQ(same_seed.uniform(5, 0), u);
+    EXPECT_NE(other_seed.uniform(5, 0), u);
+    EXPECT_NE(source.uniform(6, 0), u);
+    EXPECT_NE(source.uniform(5, 1), u);
+    turn = 8;
+    EXPECT_NE(source.uniform(5, 0), u);
+
+    double sum = 0;
+    const int n = 10000;
+    for (int i = 0; i < n; ++i) {
+        double v = source.uniform(static_cast<std::uint64_t>(i), 0);
+        ASSERT_GE(v, 0.0);
+        ASSERT_LT(v, 1.0);
+        sum += v;
+    }
+    EXPECT_NEAR(sum / n, 0.5, 0.02);
+}
+
+TEST(ReceiverPreferencesTest, RandomSourceChoicesDoNotDependOnReceiverAddresses) {
+    // Dwa zestawy magazynów o tych samych ID, utworzone w odwrotnej kolejności (inny porządek adresów).
+    std::vector<std::unique_ptr<Storehouse>> first;
+    std::vector<std::unique_ptr<Storehouse>> second(4);
+    for (ElementID id = 1; id <= 4; ++id) {
+        first.push_back(std::make_unique<Storehouse>(id));
+    }
+    for (ElementID id = 4; id >= 1; --id) {
+        second[id - 1] = std::make_unique<Storehouse>(id);
+    }
+
+    Time turn = 0;
+    RoutingRandomSource source(2024, &turn);
+    ReceiverPreferences a;
+    ReceiverPreferences b;
+    a.set_random_source(&source, 11);
+    b.set_random_source(&source, 11);
+    for (std::size_t i = 0; i < 4; ++i) {
+        a.add_receiver(first[i].get());
+        b.add_receiver(second[3 - i].get());
+    }
+
+    for (turn = 1; turn <= 20; ++turn) {
+        for (int draw = 0; draw < 3; ++draw) {
+            EXPECT_EQ(a.choose_receiver()->get_id(), b.choose_receiver()->get_id()) << "turn " << turn;
+        }
+    }
+}
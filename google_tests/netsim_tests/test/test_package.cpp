@@ -38,3 +38,72 @@ TEST(PackageTest, IsAssignmentOperatorCorrect) {
 
     EXPECT_EQ(p2.get_id(), 1);
 }
+
+TEST(PackageIDAllocatorTest, AllocatesLowestFreeId) {
+    PackageIDAllocator allocator;
+
+    EXPECT_EQ(allocator.allocate(), 1);
+    EXPECT_EQ(allocator.allocate(), 2);
+    EXPECT_EQ(allocator.allocate(), 3);
+
+    allocator.release(2);
+    allocator.release(1);
+    EXPECT_EQ(allocator.allocate(), 1);
+    EXPECT_EQ(allocator.allocate(), 2);
+    EXPECT_EQ(allocator.allocate(), 4);
+    EXPECT_EQ(allocator.assigned_count(), 4U);
+}
+
+TEST(PackageIDAllocatorTest, ReleaseOfUnassignedIdIsIgnored) {
+    PackageIDAllocator allocator;
+    allocator.allocate();
+
+    allocator.release(1);
+    allocator.release(1);
+    allocator.release(1000);
+
+    EXPECT_EQ(allocator.assigned_count(), 0U);
+    EXPECT_EQ(allocator.allocate(), 1);
+}
+
+TEST(PackageIDAllocatorTest, ReusesLowestIdAcrossSummaryLevels) {
+    // 10000 identyfikatorów wymaga trzech poziomów mapy bitowej.
+    PackageIDAllocator allocator;
+    for (int i = 1; i <= 10000; ++i) {
+        ASSERT_EQ(allocator.allocate(), i);
+    }
+
+    allocator.release(9000);
+    allocator.release(4097);
+    allocator.release(7777);
+    EXPECT_FALSE(allocator.is_assigned(4097));
+
+    EXPECT_EQ(allocator.allocate(), 4097);
+    EXPECT_EQ(allocator.allocate(), 7777);
+    EXPECT_EQ(allocator.allocate(), 9000);
+    EXPECT_EQ(allocator.allocate(), 10001);
+}
+
+TEST(PackageTest, MovedFromPackageDoesNotReleaseId) {
+    Package p1;
+    ElementID id = p1.get_id();
+    {
+        Package p2(std::move(p1));
+        EXPECT_EQ(p1.get_id(), Package::kNoID);
+    }
+    // p2 zwolnił identyfikator, p1 (pusty) nie może go zwolnić po raz drugi ani zająć ponownie.
+    Package p3;
+    EXPECT_EQ(p3.get_id(), id);
+    EXPECT_TRUE(Package::get_id_allocator().is_assigned(id));
+}
+
+TEST(PackageTest, MoveAssignmentReleasesOverwrittenId) {
+    Package p1;
+    Package p2;
+    ElementID overwritten = p1.get_id();
+
+    p1 = std::move(p2);
+
+    EXPECT_FALSE(Package::get_id_allocator().is_assigned(overwritten));
+    EXPECT_EQ(p2.get_id(), Package::kNoID);
+}
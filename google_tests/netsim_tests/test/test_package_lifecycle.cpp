@@ -0,0 +1,213 @@
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include "factory.hpp"
+#include "package_lifecycle.hpp"
+#include "reports.hpp"
+#include "simulation.hpp"
+#include "test_structures.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <sstream>
+#include <string>
+
+namespace {
+    std::string latency_csv(const Factory &factory) {
+        std::ostringstream oss;
+        write_latency_percentiles_csv(factory, oss);
+        return oss.str();
+    }
+}
+
+TEST(LatencyHistogramTest, SmallValuesAreExact) {
+    LatencyHistogram histogram;
+    EXPECT_EQ(histogram.percentile(0.5), 0U);
+    for (std::uint64_t v = 0; v < 32; ++v) {
+        histogram.add(v);
+    }
+    EXPECT_EQ(histogram.count(), 32U);
+    EXPECT_EQ(histogram.percentile(0.5), 15U);
+    EXPECT_EQ(histogram.percentile(1.0), 31U);
+    EXPECT_EQ(histogram.max(), 31U);
+    EXPECT_DOUBLE_EQ(histogram.mean(), 15.5);
+}
+
+TEST(LatencyHistogramTest, RelativeErrorIsBoundedAndMemoryIsFixed) {
+    LatencyHistogram histogram;
+    for (std::uint64_t v = 1; v <= 1000000; ++v) {
+        histogram.add(v);
+    }
+    for (double q: {0.5, 0.9, 0.99, 0.999}) {
+        const double exact = q * 1000000;
+        EXPECT_GE(static_cast<double>(histogram.percentile(q)), exact);
+        EXPECT_LE(static_cast<double>(histogram.percentile(q)), exact * (1 + 1.0 / 16));
+    }
+    EXPECT_EQ(histogram.percentile(1.0), 1000000U);
+
+    histogram.add(std::uint64_t(1) << 32);
+    EXPECT_LE(histogram.bucket_count(), LatencyHistogram::kMaxBuckets);
+    EXPECT_EQ(histogram.max(), std::uint64_t(1) << 32);
+}
+
+TEST(LatencyHistogramTest, MergeEqualsCombinedSamples) {
+    LatencyHistogram low;
+    LatencyHistogram high;
+    LatencyHistogram all;
+    for (std::uint64_t v = 0; v < 5000; ++v) {
+        (v % 3 == 0 ? low : high).add(v * 7);
+        all.add(v * 7);
+    }
+    low.merge(high);
+    EXPECT_EQ(low.count(), all.count());
+    EXPECT_EQ(low.max(), all.max());
+    EXPECT_DOUBLE_EQ(low.mean(), all.mean());
+    for (double q: {0.5, 0.99, 0.999}) {
+        EXPECT_EQ(low.percentile(q), all.percentile(q));
+    }
+}
+
+TEST(PackageLifecycleTest, ChainWithoutQueueing) {
+    Factory factory = make_chain(3, 2);
+    factory.set_latency_tracking(true);
+    simulate(factory, 9, [](Factory &, Time) {});
+
+    // Paczki z tur 1, 4, 7 są przetwarzane od razu (2 tury) i trafiają do magazynu w turze przekazania 3, 6, 9.
+    EXPECT_EQ(latency_csv(factory),
+              "type,id,metric,count,mean,p50,p99,p999,max\n"
+              "worker,1,wait,3,0,0,0,0,0\n"
+              "worker,1,sojourn,3,2,2,2,2,2\n"
+              "storehouse,1,end_to_end,3,2,2,2,2,2\n"
+              "plant,0,end_to_end,3,2,2,2,2,2\n");
+}
+
+TEST(PackageLifecycleTest, QueueingDelayGrows) {
+    Factory factory = make_chain(1, 2);
+    factory.set_latency_tracking(true);
+    simulate(factory, 10, [](Factory &, Time) {});
+
+    // Paczka k (dostawa w turze k) czeka k-1 tur, opuszcza robotnika w turze 2k i dociera do magazynu w turze 2k+1.
+    const WorkerLatency &worker = *factory.find_worker_by_id(1)->get_latency();
+    EXPECT_EQ(worker.wait.count(), 5U);
+    EXPECT_DOUBLE_EQ(worker.wait.mean(), 2.0);
+    EXPECT_EQ(worker.wait.percentile(0.5), 2U);
+    EXPECT_EQ(worker.wait.max(), 4U);
+    EXPECT_EQ(worker.sojourn.percentile(0.5), 4U);
+    EXPECT_EQ(worker.sojourn.max(), 6U);
+
+    const LatencyHistogram &end_to_end = factory.find_storehouse_by_id(1)->get_latency()->end_to_end;
+    EXPECT_EQ(end_to_end.count(), 4U);
+    EXPECT_DOUBLE_EQ(end_to_end.mean(), 3.5);
+    EXPECT_EQ(end_to_end.max(), 5U);
+}
+
+TEST(PackageLifecycleTest, EnablingMidRunAndDisabling) {
+    Factory factory = make_chain(1, 2);
+    EXPECT_FALSE(factory.is_latency_tracking_enabled());
+    EXPECT_EQ(latency_csv(factory), "type,id,metric,count,mean,p50,p99,p999,max\n");
+    EXPECT_EQ(factory.find_worker_by_id(1)->get_latency(), nullptr);
+
+    // Paczki dostarczone przed włączeniem nie dają próbek - pierwsza śledzona paczka pochodzi z tury 5.
+    simulate(factory, 4, [](Factory &, Time) {});
+    factory.set_latency_tracking(true);
+    resume_simulation(factory, 6, [](Factory &, Time) {});
+    const WorkerLatency &worker = *factory.find_worker_by_id(1)->get_latency();
+    EXPECT_EQ(worker.sojourn.count(), 1U);
+    EXPECT_EQ(worker.sojourn.max(), 6U);
+    EXPECT_EQ(factory.find_storehouse_by_id(1)->get_latency()->end_to_end.count(), 0U);
+
+    // Węzły dodane przy włączonym śledzeniu są śledzone od razu.
+    factory.add_storehouse(Storehouse(2));
+    EXPECT_NE(factory.find_storehouse_by_id(2)->get_latency(), nullptr);
+
+    factory.set_latency_tracking(false);
+    EXPECT_EQ(factory.find_worker_by_id(1)->get_latency(), nullptr);
+    EXPECT_EQ(factory.find_storehouse_by_id(2)->get_latency(), nullptr);
+    resume_simulation(factory, 2, [](Factory &, Time) {});
+}
+
+TEST(PackageLifecycleTest, RollbackStartsTrackingAnew) {
+    // rampa (co turę) -> robotnik 1 (2 tury) -> robotnik 2 (1 tura) -> magazyn
+    Factory factory;
+    factory.add_ramp(Ramp(1, 1));
+    factory.add_worker(Worker(1, 2, std::make_unique<PackageQueue>(PackageQueueType::FIFO)));
+    factory.add_worker(Worker(2, 1, std::make_unique<PackageQueue>(PackageQueueType::FIFO)));
+    factory.add_storehouse(Storehouse(1));
+    factory.find_ramp_by_id(1)->receiver_preferences_.add_receiver(&*factory.find_worker_by_id(1));
+    factory.find_worker_by_id(1)->receiver_preferences_.add_receiver(&*factory.find_worker_by_id(2));
+    factory.find_worker_by_id(2)->receiver_preferences_.add_receiver(&*factory.find_storehouse_by_id(1));
+    factory.set_latency_tracking(true);
+
+    std::ostringstream checkpoint(std::ios::binary);
+    simulate(factory, 30, [&checkpoint](Factory &f, Time t) {
+        if (t == 5) {
+            f.save_checkpoint(checkpoint);
+        }
+    });
+    std::istringstream is(checkpoint.str(), std::ios::binary);
+    factory.restore_checkpoint(is);
+    EXPECT_TRUE(factory.is_latency_tracking_enabled());
+    EXPECT_EQ(factory.find_worker_by_id(1)->get_latency()->wait.count(), 0U);
+    resume_simulation(factory, 10, [](Factory &, Time) {});
+
+    // Tylko paczki dostarczone po cofnięciu (tury 6..15) dają próbki - bez znaczników z tur 6..30 sprzed cofnięcia.
+    const WorkerLatency &worker = *factory.find_worker_by_id(1)->get_latency();
+    ASSERT_GT(worker.wait.count(), 0U);
+    EXPECT_LE(worker.wait.max(), 10U);
+    EXPECT_LE(worker.sojourn.max(), 10U);
+    EXPECT_LE(factory.find_storehouse_by_id(1)->get_latency()->end_to_end.max(), 10U);
+
+    // Nieaktualny wpis (znacznik z przyszłości) nie daje próbki.
+    Time clock = 20;
+    PackageLifecycleTracker tracker(&clock);
+    tracker.on_created(1, 20);
+    tracker.on_enqueued(1);
+    clock = 10;
+    WorkerLatency latency;
+    StorehouseLatency stored;
+    tracker.on_finished(1, 8, 10, latency);
+    tracker.on_stored(1, stored);
+    EXPECT_EQ(latency.wait.count(), 0U);
+    EXPECT_EQ(latency.sojourn.count(), 0U);
+    EXPECT_EQ(stored.end_to_end.count(), 0U);
+}
+
+TEST(PackageLifecycleTest, StoredPackagesLeaveTheTable) {
+    // Magazyn domyślny nie zwalnia ID, więc każda dostawa dostaje nowy ID; tablica zależy tylko od paczek w obiegu.
+    Time clock = 0;
+    PackageLifecycleTracker tracker(&clock);
+    StorehouseLatency stored;
+    for (ElementID id = 1; id <= 100000; ++id) {
+        clock = id;
+        tracker.on_created(id, clock);
+        tracker.on_enqueued(id);
+        if (id > 1000) {
+            tracker.on_stored(id - 1000, stored);
+        }
+    }
+    EXPECT_EQ(stored.end_to_end.count(), 99000U);
+    EXPECT_EQ(stored.end_to_end.max(), 1000U);
+    EXPECT_LE(tracker.table_size(), 4096U);
+
+    // ID zwolniony i przydzielony ponownie nadpisuje wpis poprzedniej paczki.
+    clock = 200000;
+    tracker.on_created(99999, clock);
+    tracker.on_stored(99999, stored);
+    EXPECT_EQ(stored.end_to_end.count(), 99001U);
+    EXPECT_EQ(stored.end_to_end.max(), 1000U);
+}
+
+TEST(PackageLifecycleTest, EnginesAndThreadsGiveTheSameHistograms) {
+    auto run = [](SimulationEngine engine, std::size_t threads) {
+        Factory factory = load_factory_structure(std::string_view(kStructure));
+        factory.set_routing_seed(5);
+        factory.set_thread_count(threads);
+        factory.set_latency_tracking(true);
+        simulate(factory, 200, [](Factory &, Time) {}, engine);
+        return latency_csv(factory);
+    };
+    const std::string expected = run(SimulationEngine::TURN_BASED, 1);
+    EXPECT_EQ(run(SimulationEngine::EVENT_DRIVEN, 1), expected);
+    EXPECT_EQ(run(SimulationEngine::TURN_BASED, 3), expected);
+    EXPECT_THAT(expected, ::testing::HasSubstr("\nplant,0,end_to_end,"));
+}
@@ -0,0 +1,106 @@
+#include "gtest/gtest.h"
+
+#include "factory.hpp"
+#include "replication.hpp"
+
+#include <cmath>
+#include <sstream>
+#include <vector>
+
+namespace {
+    Factory make_replicated_factory() {
+        std::istringstream iss(
+                "LOADING_RAMP id=1 delivery-interval=1\n"
+                "LOADING_RAMP id=2 delivery-interval=2\n"
+                "WORKER id=1 processing-time=2 queue-type=FIFO\n"
+                "WORKER id=2 processing-time=1 queue-type=LIFO\n"
+                "WORKER id=3 processing-time=3 queue-type=FIFO\n"
+                "STOREHOUSE id=1\n"
+                "STOREHOUSE id=2\n"
+                "LINK src=ramp-1 dest=worker-1\n"
+                "LINK src=ramp-1 dest=worker-2\n"
+                "LINK src=ramp-2 dest=worker-2\n"
+                "LINK src=worker-1 dest=worker-3\n"
+                "LINK src=worker-1 dest=store-1\n"
+                "LINK src=worker-2 dest=store-2\n"
+                "LINK src=worker-2 dest=worker-3\n"
+                "LINK src=worker-3 dest=store-1\n");
+        return load_factory_structure(iss);
+    }
+}
+
+TEST(RunningStatisticTest, MatchesDirectFormulas) {
+    std::vector<double> samples{2.0, 4.0, 4.0, 4.0, 5.0, 5.0, 7.0, 9.0};
+    RunningStatistic stat;
+    for (double x: samples) {
+        stat.add(x);
+    }
+    EXPECT_EQ(stat.count(), samples.size());
+    EXPECT_DOUBLE_EQ(stat.mean(), 5.0);
+    EXPECT_DOUBLE_EQ(stat.variance(), 32.0 / 7.0);
+    EXPECT_DOUBLE_EQ(stat.confidence_half_width(), 1.96 * std::sqrt(32.0 / 7.0) / std::sqrt(8.0));
+}
+
+TEST(RunningStatisticTest, MergeEqualsSequentialAccumulation) {
+    RunningStatistic all, left, right, empty;
+    for (int i = 0; i < 100; ++i) {
+        double x = std::sin(i) * 10 + i * 0.1;
+        all.add(x);
+        (i < 37 ? left : right).add(x);
+    }
+    left.merge(right);
+    left.merge(empty);
+    EXPECT_EQ(left.count(), all.count());
+    EXPECT_NEAR(left.mean(), all.mean(), 1e-12);
+    EXPECT_NEAR(left.variance(), all.variance(), 1e-9);
+
+    empty.merge(all);
+    EXPECT_EQ(empty.count(), all.count());
+    EXPECT_DOUBLE_EQ(empty.mean(), all.mean());
+}
+
+TEST(ReplicationTest, SummaryCoversEveryNodeAndReplication) {
+    Factory prototype = make_replicated_factory();
+    ReplicationOptions options;
+    options.replications = 24;
+    options.turns = 50;
+    options.threads = 3;
+
+    ReplicationSummary summary = run_replications(prototype, options);
+
+    EXPECT_EQ(summary.replications, 24U);
+    ASSERT_EQ(summary.workers.size(), 3U);
+    ASSERT_EQ(summary.storehouses.size(), 2U);
+    EXPECT_EQ(summary.workers[0].id, 1);
+    EXPECT_EQ(summary.storehouses[1].id, 2);
+    EXPECT_EQ(summary.plant_throughput.count(), 24U);
+    // Rampy dostarczają 1.5 paczki na turę; w stanie ustalonym większość z nich dociera do magazynów.
+    EXPECT_GT(summary.plant_throughput.mean(), 0.5);
+    EXPECT_LE(summary.plant_throughput.mean(), 1.5);
+    // Trasy są losowe, więc między replikacjami jest rozrzut.
+    EXPECT_GT(summary.storehouses[0].stored.stddev(), 0.0);
+    // Prototyp nie jest modyfikowany.
+    EXPECT_EQ(prototype.find_storehouse_by_id(1)->get_stored_count(), 0U);
+}
+
+TEST(ReplicationTest, ResultsDoNotDependOnThreadCountOrEngine) {
+    Factory prototype = make_replicated_factory();
+    ReplicationOptions options;
+    options.replications = 16;
+    options.turns = 40;
+    options.base_seed = 99;
+    options.threads = 1;
+    ReplicationSummary serial = run_replications(prototype, options);
+
+    options.threads = 4;
+    options.engine = SimulationEngine::EVENT_DRIVEN;
+    ReplicationSummary parallel = run_replications(prototype, options);
+
+    // Te same próbki, inna kolejność scalania - zgodność z dokładnością do zaokrągleń.
+    EXPECT_NEAR(parallel.plant_throughput.mean(), serial.plant_throughput.mean(), 1e-12);
+    EXPECT_NEAR(parallel.plant_throughput.variance(), serial.plant_throughput.variance(), 1e-12);
+    for (std::size_t i = 0; i < serial.workers.size(); ++i) {
+        EXPECT_NEAR(parallel.workers[i].mean_queue_length.mean(), serial.workers[i].mean_queue_length.mean(), 1e-12);
+        EXPECT_NEAR(parallel.workers[i].throughput.mean(), serial.workers[i].throughput.mean(), 1e-12);
+    }
+}
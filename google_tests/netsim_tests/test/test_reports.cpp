@@ -368,3 +368,174 @@ TEST(ReportsTest, TurnReportPackageInStock) {
 
     perform_turn_report_check(factory, t, expected_report_lines);
 }
+
+TEST(ReportsTest, AggregateStorehouse) {
+    Factory factory;
+
+    factory.add_ramp(Ramp(1, 1));
+    factory.add_storehouse(Storehouse(1, std::make_unique<AggregateStockpile>()));
+
+    Ramp& r = *(factory.find_ramp_by_id(1));
+    r.receiver_preferences_.add_receiver(&(*factory.find_storehouse_by_id(1)));
+
+    Time t = 1;
+    for (; t <= 3; ++t) {
+        factory.do_deliveries(t);
+        factory.do_package_passing();
+        factory.do_work(t);
+    }
+    --t;
+
+    // Paczki w magazynie zbiorczym nie zajmują identyfikatorów.
+    EXPECT_EQ(factory.get_package_id_allocator().assigned_count(), 0U);
+
+    // -----------------------------------------------------------------------
+
+    std::vector<std::string> expected_structure_lines{
+            "",
+            "== LOADING RAMPS ==",
+            "",
+            "LOADING RAMP #1",
+            "  Delivery interval: 1",
+            "  Receivers:",
+            "    storehouse #1",
+            "",
+            "",
+            "== WORKERS ==",
+            "",
+            "",
+            "== STOREHOUSES ==",
+            "",
+            "STOREHOUSE #1",
+            "  Stock mode: aggregate",
+            "",
+    };
+
+    perform_structure_report_check(factory, expected_structure_lines);
+
+    std::vector<std::string> expected_turn_lines{
+            "=== [ Turn: " + std::to_string(t) + " ] ===",
+            "",
+            "== WORKERS ==",
+            "",
+            "",
+            "== STOREHOUSES ==",
+            "",
+            "STOREHOUSE #1",
+            "  Stock: 3 package(s) (aggregated)",
+            "",
+    };
+
+    perform_turn_report_check(factory, t, expected_turn_lines);
+}
+
+TEST(ReportsTest, StructureReportListsRoutingSeed) {
+    Factory factory;
+    factory.add_ramp(Ramp(1, 1));
+    factory.add_storehouse(Storehouse(1));
+    factory.find_ramp_by_id(1)->receiver_preferences_.add_receiver(&(*factory.find_storehouse_by_id(1)));
+    factory.set_routing_seed(987654321);
+
+    std::vector<std::string> expected_structure_lines{
+            "",
+            "== LOADING RAMPS ==",
+            "",
+            "LOADING RAMP #1",
+            "  Delivery interval: 1",
+            "  Receivers:",
+            "    storehouse #1",
+            "",
+            "",
+            "== WORKERS ==",
+            "",
+            "",
+            "== STOREHOUSES ==",
+            "",
+            "STOREHOUSE #1",
+            "",
+            "",
+            "== ROUTING ==",
+            "",
+            "Seed: 987654321",
+    };
+
+    perform_structure_report_check(factory, expected_structure_lines);
+}
+
+namespace {
+    /**
+     * Fabryka z magazynami we wszystkich trybach (kolejka LIFO, kolejka FIFO, dziennik, zbiorczy) i losowymi trasami.
+     */
+    Factory make_reporting_factory() {
+        Factory factory;
+        factory.add_ramp(Ramp(1, 1));
+        factory.add_ramp(Ramp(2, 3));
+        factory.add_worker(Worker(1, 2, std::make_unique<PackageQueue>(PackageQueueType::FIFO)));
+        factory.add_worker(Worker(2, 3, std::make_unique<PackageQueue>(PackageQueueType::LIFO)));
+        factory.add_storehouse(Storehouse(1));
+        factory.add_storehouse(Storehouse(2, std::make_unique<PackageQueue>(PackageQueueType::FIFO)));
+        factory.add_storehouse(Storehouse(3, std::make_unique<PackageLog>()));
+        factory.add_storehouse(Storehouse(4, std::make_unique<AggregateStockpile>()));
+
+        auto worker = [&factory](ElementID id) { return &*factory.find_worker_by_id(id); };
+        auto store = [&factory](ElementID id) { return &*factory.find_storehouse_by_id(id); };
+        factory.find_ramp_by_id(1)->receiver_preferences_.add_receiver(worker(1));
+        factory.find_ramp_by_id(1)->receiver_preferences_.add_receiver(worker(2));
+        factory.find_ramp_by_id(2)->receiver_preferences_.add_receiver(worker(2));
+        for (ElementID id = 1; id <= 4; ++id) {
+            worker(1)->receiver_preferences_.add_receiver(store(id));
+            worker(2)->receiver_preferences_.add_receiver(store(id));
+        }
+        factory.set_routing_seed(31337);
+        return factory;
+    }
+}
+
+TEST(ReportsTest, AsyncWriterMatchesSynchronousTurnReports) {
+    Factory reference = make_reporting_factory();
+    std::ostringstream expected;
+    for (Time t = 1; t <= 40; ++t) {
+        reference.do_deliveries(t);
+        reference.do_package_passing();
+        reference.do_work(t);
+        generate_simulation_turn_report(reference, expected, t);
+    }
+
+    for (std::size_t buffered_turns: {1U, 2U, 8U}) {
+        Factory factory = make_reporting_factory();
+        std::ostringstream actual;
+        {
+            AsyncTurnReportWriter writer(factory, actual, buffered_turns);
+            for (Time t = 1; t <= 40; ++t) {
+                factory.do_deliveries(t);
+                factory.do_package_passing();
+                factory.do_work(t);
+                writer.capture(t);
+            }
+            writer.close();
+        }
+        EXPECT_EQ(actual.str(), expected.str()) << buffered_turns << " buffered turn(s)";
+    }
+}
+
+TEST(ReportsTest, AsyncWriterReportsFailedStream) {
+    Factory factory = make_reporting_factory();
+    std::ostringstream broken;
+    broken.setstate(std::ios::badbit);
+
+    AsyncTurnReportWriter writer(factory, broken, 1);
+    factory.do_deliveries(1);
+    factory.do_package_passing();
+    factory.do_work(1);
+    // Błąd zapisu może ujawnić się przy kolejnym zrzucie albo dopiero przy zamknięciu.
+    bool thrown = false;
+    try {
+        for (Time t = 1; t <= 3; ++t) {
+            writer.capture(t);
+        }
+        writer.close();
+    } catch (const std::runtime_error &) {
+        thrown = true;
+    }
+    EXPECT_TRUE(thrown);
+}
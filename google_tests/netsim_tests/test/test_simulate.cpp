@@ -6,6 +6,10 @@
 #include "helpers.hpp"
 #include "reports.hpp"
 
+#include <sstream>
+#include <string>
+#include <vector>
+
 using ::testing::Return;
 using ::testing::_;
 
@@ -35,3 +39,129 @@ TEST(SimulationTest, Simulate) {
     ASSERT_NE(storehouse_it->cbegin(), storehouse_it->cend());
     EXPECT_EQ(storehouse_it->cbegin()->get_id(), 1);
 }
+
+namespace {
+    /**
+     * Sieć z rozgałęzieniami "w dół" (wielu nadawców -> jeden odbiorca), ale bez wyboru odbiorcy,
+     * więc przebieg nie zależy od generatora losowego ani kolejności preferencji.
+     */
+    Factory make_merging_factory(PackageQueueType queue_type) {
+        Factory factory;
+        factory.add_ramp(Ramp(1, 3));
+        factory.add_ramp(Ramp(2, 7));
+        factory.add_ramp(Ramp(3, 1));
+        factory.add_worker(Worker(1, 2, std::make_unique<PackageQueue>(queue_type)));
+        factory.add_worker(Worker(2, 5, std::make_unique<PackageQueue>(queue_type)));
+        factory.add_worker(Worker(3, 1, std::make_unique<PackageQueue>(queue_type)));
+        factory.add_worker(Worker(4, 4, std::make_unique<PackageQueue>(queue_type)));
+        factory.add_storehouse(Storehouse(1));
+        factory.add_storehouse(Storehouse(2));
+
+        auto worker = [&factory](ElementID id) { return &*factory.find_worker_by_id(id); };
+        factory.find_ramp_by_id(1)->receiver_preferences_.add_receiver(worker(1));
+        factory.find_ramp_by_id(2)->receiver_preferences_.add_receiver(worker(1));
+        factory.find_ramp_by_id(3)->receiver_preferences_.add_receiver(worker(2));
+        worker(1)->receiver_preferences_.add_receiver(worker(3));
+        worker(2)->receiver_preferences_.add_receiver(worker(3));
+        worker(3)->receiver_preferences_.add_receiver(worker(4));
+        worker(4)->receiver_preferences_.add_receiver(&*factory.find_storehouse_by_id(1));
+        return factory;
+    }
+
+    std::vector<std::string> run_with_reports(Factory &factory, TimeOffset d, SimulationEngine engine) {
+        std::vector<std::string> reports;
+        simulate(factory, d, [&reports](Factory &f, Time t) {
+            std::ostringstream oss;
+            generate_simulation_turn_report(f, oss, t);
+            reports.push_back(oss.str());
+        }, engine);
+        return reports;
+    }
+}
+
+TEST(SimulationTest, EventDrivenMatchesTurnBasedFifo) {
+    Factory turn_based = make_merging_factory(PackageQueueType::FIFO);
+    Factory event_driven = make_merging_factory(PackageQueueType::FIFO);
+
+    auto expected = run_with_reports(turn_based, 60, SimulationEngine::TURN_BASED);
+    auto actual = run_with_reports(event_driven, 60, SimulationEngine::EVENT_DRIVEN);
+
+    ASSERT_EQ(actual.size(), 60U);
+    EXPECT_EQ(actual, expected);
+}
+
+TEST(SimulationTest, EventDrivenMatchesTurnBasedLifo) {
+    Factory turn_based = make_merging_factory(PackageQueueType::LIFO);
+    Factory event_driven = make_merging_factory(PackageQueueType::LIFO);
+
+    auto expected = run_with_reports(turn_based, 60, SimulationEngine::TURN_BASED);
+    auto actual = run_with_reports(event_driven, 60, SimulationEngine::EVENT_DRIVEN);
+
+    EXPECT_EQ(actual, expected);
+}
+
+TEST(SimulationTest, EventDrivenContinuesFromExistingState) {
+    // Druga symulacja startuje z paczkami w kolejkach i buforach pozostawionymi przez pierwszą.
+    Factory turn_based = make_merging_factory(PackageQueueType::FIFO);
+    Factory event_driven = make_merging_factory(PackageQueueType::FIFO);
+    simulate(turn_based, 17, {});
+    simulate(event_driven, 17, {});
+
+    auto expected = run_with_reports(turn_based, 30, SimulationEngine::TURN_BASED);
+    auto actual = run_with_reports(event_driven, 30, SimulationEngine::EVENT_DRIVEN);
+
+    EXPECT_EQ(actual, expected);
+}
+
+TEST(SimulationTest, EventDrivenReportsSkippedTurns) {
+    Factory factory;
+    factory.add_ramp(Ramp(1, 10));
+    factory.add_worker(Worker(1, 3, std::make_unique<PackageQueue>(PackageQueueType::FIFO)));
+    factory.add_storehouse(Storehouse(1));
+    factory.find_ramp_by_id(1)->receiver_preferences_.add_receiver(&*factory.find_worker_by_id(1));
+    factory.find_worker_by_id(1)->receiver_preferences_.add_receiver(&*factory.find_storehouse_by_id(1));
+
+    std::vector<Time> turns;
+    simulate(factory, 25, [&turns](Factory &, Time t) { turns.push_back(t); }, SimulationEngine::EVENT_DRIVEN);
+
+    ASSERT_EQ(turns.size(), 25U);
+    for (std::size_t i = 0; i < turns.size(); ++i) {
+        EXPECT_EQ(turns[i], static_cast<Time>(i + 1));
+    }
+    // Dostawy w turach 1, 11, 21; każda paczka trafia do magazynu 3 tury później.
+    EXPECT_EQ(factory.find_storehouse_by_id(1)->get_stored_count(), 3U);
+}
+
+TEST(SimulationTest, InconsistentFactoryThrows) {
+    Factory factory;
+    factory.add_ramp(Ramp(1, 1));
+    factory.add_worker(Worker(1, 1, std::make_unique<PackageQueue>(PackageQueueType::FIFO)));
+    factory.find_ramp_by_id(1)->receiver_preferences_.add_receiver(&*factory.find_worker_by_id(1));
+
+    EXPECT_THROW(simulate(factory, 1, {}), std::logic_error);
+    EXPECT_THROW(simulate(factory, 1, {}, SimulationEngine::EVENT_DRIVEN), std::logic_error);
+}
+
+TEST(SimulationTest, SeededBranchingRunIsEngineIndependent) {
+    // Rozgałęziona sieć z ziarnem tras: oba silniki losują te same trasy, bo wartości nie zależą od kolejności wywołań.
+    auto make_branching_factory = []() {
+        Factory factory = make_merging_factory(PackageQueueType::FIFO);
+        auto worker = [&factory](ElementID id) { return &*factory.find_worker_by_id(id); };
+        factory.find_ramp_by_id(1)->receiver_preferences_.add_receiver(worker(2));
+        worker(1)->receiver_preferences_.add_receiver(worker(4));
+        worker(2)->receiver_preferences_.add_receiver(&*factory.find_storehouse_by_id(2));
+        worker(3)->receiver_preferences_.add_receiver(&*factory.find_storehouse_by_id(1));
+        worker(4)->receiver_preferences_.add_receiver(&*factory.find_storehouse_by_id(2));
+        factory.set_routing_seed(7);
+        return factory;
+    };
+    Factory turn_based = make_branching_factory();
+    Factory event_driven = make_branching_factory();
+
+    auto expected = run_with_reports(turn_based, 80, SimulationEngine::TURN_BASED);
+    auto actual = run_with_reports(event_driven, 80, SimulationEngine::EVENT_DRIVEN);
+
+    EXPECT_EQ(actual, expected);
+    EXPECT_EQ(std::distance(event_driven.find_storehouse_by_id(2)->cbegin(), event_driven.find_storehouse_by_id(2)->cend()),
+              std::distance(turn_based.find_storehouse_by_id(2)->cbegin(), turn_based.find_storehouse_by_id(2)->cend()));
+}
@@ -5,6 +5,10 @@
 #include "storage_types.hpp"
 #include "types.hpp"
 
+#include <algorithm>
+#include <deque>
+#include <vector>
+
 using ::std::cout;
 using ::std::endl;
 
@@ -31,3 +35,109 @@ TEST(PackageQueueTest, IsLifoCorrect) {
     p = q.pop();
     EXPECT_EQ(p.get_id(), 1);
 }
+
+TEST(PackageQueueTest, KeepsOrderAcrossWrapAroundAndGrowth) {
+    // Przeplatane push/pop przesuwają początek bufora cyklicznego, a kolejne push wymuszają jego powiększenie.
+    for (auto type : {PackageQueueType::FIFO, PackageQueueType::LIFO}) {
+        PackageQueue q(type);
+        std::deque<ElementID> expected;
+        ElementID next_id = 1;
+        for (int round = 0; round < 50; ++round) {
+            for (int i = 0; i < 3; ++i) {
+                q.push(Package(next_id));
+                if (type == PackageQueueType::FIFO) {
+                    expected.push_back(next_id);
+                } else {
+                    expected.push_front(next_id);
+                }
+                ++next_id;
+            }
+            EXPECT_EQ(q.pop().get_id(), expected.front());
+            expected.pop_front();
+        }
+
+        ASSERT_EQ(q.size(), expected.size());
+        std::vector<ElementID> iterated;
+        for (const auto& package : q) {
+            iterated.push_back(package.get_id());
+        }
+        EXPECT_EQ(iterated, std::vector<ElementID>(expected.begin(), expected.end()));
+    }
+}
+
+TEST(PackageQueueTest, EmptyQueueHasEmptyRange) {
+    PackageQueue q(PackageQueueType::FIFO);
+    EXPECT_EQ(q.cbegin(), q.cend());
+
+    q.push(Package(1));
+    q.pop();
+    EXPECT_EQ(q.cbegin(), q.cend());
+}
+
+TEST(PackageLogTest, KeepsArrivalOrderAcrossChunks) {
+    PackageLog log;
+    const auto n = static_cast<ElementID>(2 * PackageLog::kChunkSize + 10);
+    for (ElementID id = 1; id <= n; ++id) {
+        log.push_at(Package(id), id / 100);
+    }
+
+    ASSERT_EQ(log.size(), static_cast<std::size_t>(n));
+    EXPECT_EQ(log.segment_count(), 3U);
+    ElementID expected = 1;
+    for (const auto& package : log) {
+        ASSERT_EQ(package.get_id(), expected++);
+    }
+    EXPECT_EQ(expected, n + 1);
+    EXPECT_EQ(log.at(PackageLog::kChunkSize).get_id(), static_cast<ElementID>(PackageLog::kChunkSize + 1));
+}
+
+TEST(PackageLogTest, FindsArrivalsBetweenTurns) {
+    PackageLog log;
+    // Tury przybycia: 1, 1, 3, 3, 3, 7, ...; paczka o ID = i przybywa w turze arrival(i).
+    std::vector<Time> arrivals;
+    for (Time t = 1; t <= 2000; t += 2) {
+        for (int k = 0; k < (t % 3) + 1; ++k) {
+            arrivals.push_back(t);
+        }
+    }
+    for (std::size_t i = 0; i < arrivals.size(); ++i) {
+        log.push_at(Package(static_cast<ElementID>(i + 1)), arrivals[i]);
+    }
+
+    for (auto [a, b] : {std::pair<Time, Time>{1, 1}, {2, 2}, {3, 9}, {500, 1500}, {1999, 5000}, {5000, 6000}}) {
+        auto range = log.arrivals_between(a, b);
+        auto first = std::lower_bound(arrivals.begin(), arrivals.end(), a) - arrivals.begin();
+        auto last = std::upper_bound(arrivals.begin(), arrivals.end(), b) - arrivals.begin();
+        EXPECT_EQ(range.first, static_cast<std::size_t>(first)) << "[" << a << ", " << b << "]";
+        EXPECT_EQ(range.last, static_cast<std::size_t>(last)) << "[" << a << ", " << b << "]";
+        for (std::size_t i = range.first; i < range.last; ++i) {
+            ASSERT_GE(log.arrival_time(i), a);
+            ASSERT_LE(log.arrival_time(i), b);
+        }
+    }
+}
+
+TEST(AggregateStockpileTest, CountsAndReleasesPackages) {
+    PackageIDAllocator ids;
+    AggregateStockpile stockpile(10);
+    for (Time t = 1; t <= 25; ++t) {
+        stockpile.push_at(Package(ids), t);
+    }
+
+    EXPECT_EQ(stockpile.get_arrival_count(), 25U);
+    EXPECT_EQ(ids.assigned_count(), 0U);
+    EXPECT_EQ(stockpile.cbegin(), stockpile.cend());
+    EXPECT_EQ(stockpile.get_histogram(), (std::vector<std::size_t>{10, 10, 5}));
+}
+
+TEST(AggregateStockpileTest, MergesBucketsToKeepMemoryBounded) {
+    AggregateStockpile stockpile(1, 4);
+    for (Time t = 1; t <= 10; ++t) {
+        stockpile.push_at(Package(t), t);
+    }
+
+    // Przedział podwojony dwukrotnie: 1 -> 2 -> 4 tury, tury 1-4, 5-8, 9-10.
+    EXPECT_EQ(stockpile.get_interval(), 4);
+    EXPECT_EQ(stockpile.get_histogram(), (std::vector<std::size_t>{4, 4, 2}));
+    EXPECT_EQ(stockpile.get_arrival_count(), 10U);
+}
@@ -0,0 +1,66 @@
+#include "gtest/gtest.h"
+
+#include "thread_pool.hpp"
+
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+TEST(ThreadPoolTest, ParallelForCoversRangeOnce) {
+    ThreadPool pool(4);
+    ASSERT_EQ(pool.size(), 4U);
+
+    for (std::size_t n: {0U, 1U, 3U, 4U, 1000U}) {
+        std::vector<int> visits(n, 0);
+        pool.parallel_for(n, [&visits](std::size_t begin, std::size_t end, std::size_t) {
+            for (std::size_t i = begin; i < end; ++i) {
+                ++visits[i];
+            }
+        });
+        for (std::size_t i = 0; i < n; ++i) {
+            EXPECT_EQ(visits[i], 1) << "n = " << n << ", i = " << i;
+        }
+    }
+}
+
+TEST(ThreadPoolTest, ChunksAreContiguousAndOrdered) {
+    ThreadPool pool(3);
+    std::vector<std::size_t> chunk_of(10, 0);
+    pool.parallel_for(chunk_of.size(), [&chunk_of](std::size_t begin, std::size_t end, std::size_t chunk) {
+        for (std::size_t i = begin; i < end; ++i) {
+            chunk_of[i] = chunk;
+        }
+    });
+    EXPECT_EQ(chunk_of, (std::vector<std::size_t>{0, 0, 0, 1, 1, 1, 2, 2, 2, 2}));
+}
+
+TEST(ThreadPoolTest, RunsEveryChunkRepeatedly) {
+    ThreadPool pool(3);
+    std::atomic<int> calls{0};
+    for (int round = 0; round < 100; ++round) {
+        pool.run([&calls](std::size_t) { ++calls; });
+    }
+    EXPECT_EQ(calls.load(), 300);
+}
+
+TEST(ThreadPoolTest, RethrowsExceptionFromChunk) {
+    ThreadPool pool(2);
+    EXPECT_THROW(pool.run([](std::size_t chunk) {
+        if (chunk == 1) {
+            throw std::runtime_error("chunk failed");
+        }
+    }), std::runtime_error);
+
+    // Pula pozostaje używalna po wyjątku.
+    std::atomic<int> calls{0};
+    pool.run([&calls](std::size_t) { ++calls; });
+    EXPECT_EQ(calls.load(), 2);
+}
+
+TEST(ThreadPoolTest, SingleThreadRunsInCaller) {
+    ThreadPool pool(1);
+    EXPECT_EQ(pool.size(), 1U);
+    std::vector<std::size_t> chunks;
+    pool.run([&chunks](std::size_t chunk) { chunks.push_back(chunk); });
+    EXPECT_EQ(chunks, (std::vector<std::size_t>{0}));
+}
@@ -0,0 +1,155 @@
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include "factory.hpp"
+#include "topology_generator.hpp"
+
+#include <random>
+#include <stdexcept>
+#include <string>
+
+namespace {
+    Factory generate(const TopologyOptions &options) {
+        return load_factory_structure(std::string_view(generate_factory_structure(options)));
+    }
+
+    std::size_t count_nodes(const Factory &factory, std::size_t &workers, std::size_t &storehouses) {
+        std::size_t ramps = 0;
+        workers = 0;
+        storehouses = 0;
+        for (auto it = factory.ramp_cbegin(); it != factory.ramp_cend(); ++it) {
+            ++ramps;
+        }
+        for (auto it = factory.worker_cbegin(); it != factory.worker_cend(); ++it) {
+            ++workers;
+        }
+        for (auto it = factory.storehouse_cbegin(); it != factory.storehouse_cend(); ++it) {
+            ++storehouses;
+        }
+        return ramps;
+    }
+}
+
+TEST(TopologyGeneratorTest, GeneratedStructuresAreConsistent) {
+    for (std::size_t workers: {0U, 1U, 7U, 64U}) {
+        for (std::size_t depth: {1U, 3U, 7U}) {
+            for (std::size_t fan_out: {1U, 2U, 5U}) {
+                if (workers > 0 && depth > workers) {
+                    continue;
+                }
+                TopologyOptions options;
+                options.ramps = 3;
+                options.workers = workers;
+                options.storehouses = 2;
+                options.depth = depth;
+                options.fan_out = fan_out;
+                options.back_edge_probability = 0.3;
+                options.seed = workers * 100 + depth * 10 + fan_out;
+                Factory factory = generate(options);
+                EXPECT_TRUE(factory.is_consistent()) << workers << " " << depth << " " << fan_out;
+
+                std::size_t loaded_workers = 0;
+                std::size_t loaded_storehouses = 0;
+                EXPECT_EQ(count_nodes(factory, loaded_workers, loaded_storehouses), 3U);
+                EXPECT_EQ(loaded_workers, workers);
+                EXPECT_EQ(loaded_storehouses, 2U);
+            }
+        }
+    }
+}
+
+TEST(TopologyGeneratorTest, EveryNodeHasASenderAndFanOutIsKept) {
+    TopologyOptions options;
+    options.ramps = 2;
+    options.workers = 40;
+    options.storehouses = 10;
+    options.depth = 4;
+    options.fan_out = 3;
+    Factory factory = generate(options);
+
+    for (auto it = factory.worker_cbegin(); it != factory.worker_cend(); ++it) {
+        EXPECT_FALSE(factory.get_senders_of(&*it).empty()) << "worker " << it->get_id();
+        EXPECT_GE(it->receiver_preferences_.get_preferences().size(), 3U) << "worker " << it->get_id();
+    }
+    for (auto it = factory.storehouse_cbegin(); it != factory.storehouse_cend(); ++it) {
+        EXPECT_FALSE(factory.get_senders_of(&*it).empty()) << "storehouse " << it->get_id();
+    }
+    // Rampy: dwie rampy na 10 robotników warstwy 0 - każda musi objąć połowę warstwy.
+    EXPECT_EQ(factory.find_ramp_by_id(1)->receiver_preferences_.get_preferences().size(), 5U);
+}
+
+TEST(TopologyGeneratorTest, BackEdgesPointToEarlierLayers) {
+    TopologyOptions options;
+    options.workers = 30;
+    options.depth = 3;
+    options.fan_out = 1;
+    options.back_edge_probability = 1.0;
+    Factory factory = generate(options);
+
+    // Warstwy: robotnicy 1-10, 11-20, 21-30; każdy robotnik warstw 1 i 2 ma połączenie wsteczne.
+    for (ElementID id = 11; id <= 30; ++id) {
+        const Worker &worker = *factory.find_worker_by_id(id);
+        std::size_t back_edges = 0;
+        for (const auto &[receiver, p]: worker.receiver_preferences_.get_preferences()) {
+            if (receiver->get_receiver_type() == ReceiverType::WORKER && receiver->get_id() < (id - 1) / 10 * 10 + 1) {
+                ++back_edges;
+            }
+        }
+        EXPECT_EQ(back_edges, 1U) << "worker " << id;
+    }
+    EXPECT_TRUE(factory.is_consistent());
+}
+
+TEST(TopologyGeneratorTest, OutputDependsOnlyOnOptions) {
+    TopologyOptions options;
+    options.workers = 50;
+    options.depth = 5;
+    options.fan_out = 3;
+    options.back_edge_probability = 0.5;
+    options.lifo_probability = 0.5;
+    options.processing_time = parse_time_distribution("uniform:1-4");
+    EXPECT_EQ(generate_factory_structure(options), generate_factory_structure(options));
+
+    TopologyOptions other = options;
+    other.seed = 2;
+    EXPECT_NE(generate_factory_structure(options), generate_factory_structure(other));
+}
+
+TEST(TopologyGeneratorTest, TimeDistributions) {
+    std::mt19937_64 rng(3);
+    TimeDistribution constant = parse_time_distribution("4");
+    EXPECT_EQ(constant.kind, TimeDistribution::Kind::CONSTANT);
+    EXPECT_EQ(constant.sample(rng), 4);
+
+    TimeDistribution uniform = parse_time_distribution("uniform:2-5");
+    TimeDistribution geometric = parse_time_distribution("geometric:3");
+    double sum = 0;
+    for (int i = 0; i < 10000; ++i) {
+        TimeOffset u = uniform.sample(rng);
+        EXPECT_GE(u, 2);
+        EXPECT_LE(u, 5);
+        TimeOffset g = geometric.sample(rng);
+        EXPECT_GE(g, 1);
+        sum += g;
+    }
+    EXPECT_NEAR(sum / 10000, 3.0, 0.15);
+
+    for (const char *spec: {"0", "x", "uniform:5-2", "uniform:3", "geometric:", "normal:3", "2a"}) {
+        EXPECT_THROW(parse_time_distribution(spec), std::invalid_argument) << spec;
+    }
+}
+
+TEST(TopologyGeneratorTest, InvalidOptionsAreRejected) {
+    TopologyOptions options;
+    options.depth = 9;
+    EXPECT_THROW(generate_factory_structure(options), std::invalid_argument);
+    options.depth = 2;
+    options.storehouses = 0;
+    EXPECT_THROW(generate_factory_structure(options), std::invalid_argument);
+    options.storehouses = 1;
+    options.fan_out = 0;
+    EXPECT_THROW(generate_factory_structure(options), std::invalid_argument);
+    options.fan_out = 1;
+    options.back_edge_probability = 1.5;
+    EXPECT_THROW(generate_factory_structure(options), std::invalid_argument);
+}
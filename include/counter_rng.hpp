@@ -0,0 +1,48 @@
+#ifndef NETSIM_COUNTER_RNG_HPP
+#define NETSIM_COUNTER_RNG_HPP
+
+/**
+ * plik nagłówkowy "counter_rng.hpp" zawierający licznikowy generator Philox4x32-10
+ * oraz klasę RoutingRandomSource
+*/
+
+#include <array>
+#include <cstdint>
+#include "types.hpp"
+
+/**
+ * @brief Philox4x32-10 (Salmon i in., "Parallel random numbers: as easy as 1, 2, 3", SC'11):
+ * bijekcja licznika sterowana kluczem. Ta sama para (licznik, klucz) zawsze daje ten sam wynik,
+ * a różne liczniki dają statystycznie niezależne wartości - generator nie ma stanu.
+ */
+std::array<std::uint32_t, 4> philox4x32_10(std::array<std::uint32_t, 4> counter, std::array<std::uint32_t, 2> key);
+
+class RoutingRandomSource {
+    /*!
+     * RoutingRandomSource
+     * - źródło losowości tras dla całej fabryki: wartość zależy wyłącznie od (ziarno, strumień nadawcy, tura, numer losowania)
+     * - nie ma współdzielonego stanu, więc wynik nie zależy od kolejności wywołań ani od liczby wątków
+     * - turę odczytuje z zegara fabryki
+     */
+public:
+    RoutingRandomSource(std::uint64_t seed, const Time *clock) : seed_(seed), clock_(clock) {};
+
+    /**
+     * @brief Liczba z przedziału [0, 1) (53 bity losowości)
+     * @param stream - klucz strumienia (nadawcy)
+     * @param draw - numer losowania nadawcy w bieżącej turze
+     */
+    double uniform(std::uint64_t stream, std::uint32_t draw) const;
+
+    std::uint64_t get_seed() const { return seed_; };
+
+    void set_seed(std::uint64_t seed) { seed_ = seed; };
+
+    Time get_turn() const { return clock_ != nullptr ? *clock_ : 0; };
+
+private:
+    std::uint64_t seed_;
+    const Time *clock_;
+};
+
+#endif //NETSIM_COUNTER_RNG_HPP
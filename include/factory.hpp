@@ -5,21 +5,52 @@
 #ifndef NETSIM_FACTORY_HPP
 #define NETSIM_FACTORY_HPP
 
+#include <algorithm>
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <optional>
 #include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
 #include "types.hpp"
 #include "nodes.hpp"
 
 template<class Node>
 class NodeCollection {
+    /*!
+     * NodeCollection
+     * - przechowuje węzły w std::list, więc ich adresy są stałe (wskaźniki odbiorców w ReceiverPreferences
+     *   pozostają ważne przy dodawaniu i usuwaniu innych węzłów)
+     * - utrzymuje indeks ID -> węzeł, dzięki czemu find_by_id() i remove_by_id() działają w O(1)
+     * - przy powtórzonych ID indeks wskazuje pierwszy dodany węzeł (tak jak wcześniejsze wyszukiwanie liniowe);
+     *   liczba powtórzeń jest pamiętana dla każdego ID, więc remove_by_id() przeszukuje listę tylko wtedy,
+     *   gdy usuwany ID sam ma powtórzenia - inne powtórzone ID nie spowalniają usuwania
+     */
 public:
     using container_t = typename std::list<Node>;
     using iterator = typename container_t::iterator;
     using const_iterator = typename container_t::const_iterator;
 
-    void add(Node &&node);
+    /**
+     * @brief Dodaje węzeł do kolekcji
+     * @return referencja na węzeł w kolekcji (jego adres się nie zmieni)
+     */
+    Node &add(Node &&node);
 
     void remove_by_id(ElementID id);
 
+    /**
+     * @brief Rezerwuje miejsce w indeksie ID na `count` węzłów (bez przebudowy przy kolejnych add())
+     */
+    void reserve(std::size_t count) { index_.reserve(count); }
+
+    std::size_t size() const { return nodes_.size(); }
+
     NodeCollection<Node>::iterator find_by_id(ElementID id);
 
     NodeCollection<Node>::const_iterator find_by_id(ElementID id) const;
@@ -38,23 +69,198 @@ public:
 
 private:
     container_t nodes_;
+    std::unordered_map<ElementID, iterator> index_;
+    // ID -> liczba węzłów o tym ID poza tym w indeksie (tylko ID powtórzone)
+    std::unordered_map<ElementID, std::size_t> duplicates_;
+};
+
+class LinkIndex : public ILinkObserver {
+    /*!
+     * LinkIndex
+     * - indeks odwrotny połączeń: odbiorca -> nadawcy, którzy mają go w swoich preferencjach
+     * - aktualizowany przez ReceiverPreferences podpiętych nadawców przy każdej zmianie preferencji
+     * - pozwala usunąć odbiorcę, odwiedzając tylko nadawców, którzy do niego linkują (O(stopień) zamiast O(N))
+     * - przy okazji utrzymuje status spójności: zmiana linku tylko dopisuje nadawcę (i odpiętego odbiorcę)
+     *   do listy zmienionych, a is_consistent() pamięta dla każdego nadawcy bez odbiorcy innego niż on sam,
+     *   czy jest osiągalny z rampy; po zmianie przeszukuje wstecz tylko tych z nich, do których zmienieni nadawcy
+     *   i odbiorcy prowadzą - bez takich nadawców albo bez zmian od poprzedniego pytania odpowiada w O(1)
+     */
+public:
+    void on_link_added(PackageSender *sender, IPackageReceiver *receiver) override;
+
+    void on_link_removed(PackageSender *sender, IPackageReceiver *receiver) override;
+
+    /**
+     * @brief Podpina indeks do preferencji nadawcy i rejestruje jego istniejące połączenia
+     * @param self - nadawca jako odbiorca (robotnik) albo nullptr dla rampy
+     */
+    void attach(PackageSender &sender, const IPackageReceiver *self);
+
+    /**
+     * @brief Wyrejestrowuje połączenia wychodzące nadawcy i odpina indeks od jego preferencji
+     */
+    void detach(PackageSender &sender);
+
+    /**
+     * @brief Usuwa wpis odbiorcy (wywoływane po odłączeniu go od wszystkich nadawców)
+     */
+    void forget_receiver(const IPackageReceiver *receiver) { senders_.erase(receiver); }
+
+    const std::vector<PackageSender *> &get_senders(const IPackageReceiver *receiver) const;
+
+    void reserve(std::size_t receivers, std::size_t senders) {
+        senders_.reserve(receivers);
+        states_.reserve(senders);
+        receiver_senders_.reserve(senders);
+    }
+
+    /**
+     * @brief Czy żaden nadawca bez odbiorcy innego niż on sam nie jest osiągalny z rampy
+     * (ta sama reguła co w Factory::find_inconsistent_nodes()); wynik jest zapamiętywany do następnej zmiany
+     */
+    bool is_consistent() const;
+
+private:
+    struct SenderState {
+        // Nadawca jako odbiorca (robotnik) albo nullptr (rampa).
+        const IPackageReceiver *self = nullptr;
+        // Brak odbiorcy innego niż on sam; wtedy ramp_upstream mówi, czy nadawca jest osiągalny z rampy.
+        bool unlinked = false;
+        bool ramp_upstream = false;
+        // Numer przeszukania, które odwiedziło nadawcę, i numer pytania, w którym okazał się nieosiągalny z rampy.
+        std::uint64_t visited = 0;
+        std::uint64_t no_ramp = 0;
+    };
+
+    /**
+     * @brief Ustawia flagę `unlinked` nadawcy według jego bieżących preferencji
+     */
+    void update_linked(const PackageSender *sender, SenderState &state) const;
+
+    void set_ramp_upstream(SenderState &state, bool ramp_upstream) const;
+
+    bool has_ramp_upstream(const PackageSender *start) const;
+
+    std::unordered_map<const IPackageReceiver *, std::vector<PackageSender *>> senders_;
+    // Podpięci nadawcy i ich stan sprawdzania spójności.
+    mutable std::unordered_map<const PackageSender *, SenderState> states_;
+    // Podpięci robotnicy jako odbiorcy -> oni sami jako nadawcy (krawędzie "w przód" między nadawcami).
+    std::unordered_map<const IPackageReceiver *, const PackageSender *> receiver_senders_;
+    // Nadawcy, których preferencje zmieniły się od ostatniego is_consistent(), i odbiorcy odpiętych linków
+    // (mogą się powtarzać i wskazywać węzły już usunięte).
+    mutable std::vector<const PackageSender *> touched_;
+    mutable std::vector<const IPackageReceiver *> touched_receivers_;
+    // Bufory przeszukiwań - alokowane raz.
+    mutable std::vector<const PackageSender *> affected_;
+    mutable std::vector<const PackageSender *> stack_;
+    mutable std::vector<const PackageSender *> visited_;
+    mutable std::uint64_t search_ = 0;
+    mutable std::uint64_t query_ = 0;
+    // Liczba nadawców bez odbiorcy innego niż oni sami i liczba tych z nich, którzy są osiągalni z rampy.
+    mutable std::size_t unlinked_count_ = 0;
+    mutable std::size_t reached_count_ = 0;
+    mutable bool status_valid_ = true;
+};
+
+enum class ElementType {
+    RAMP,
+    WORKER,
+    STOREHOUSE,
+    LINK
+};
+
+/**
+ * Nadawca naruszający spójność sieci: osiągalny z rampy, ale bez odbiorcy innego niż on sam
+ */
+struct InconsistentNode {
+    enum class Reason {
+        NO_RECEIVERS,
+        SELF_LINK_ONLY
+    };
+
+    ElementType type;
+    ElementID id;
+    Reason reason;
+
+    bool operator==(const InconsistentNode &other) const {
+        return type == other.type && id == other.id && reason == other.reason;
+    }
+};
+
+/**
+ * Liczniki węzła odczytane przez Factory::get_node_counters()
+ */
+struct NodeCounterRecord {
+    ElementType type;
+    ElementID id;
+    /**
+     * busy_turns obejmuje także trwające przetwarzanie
+     */
+    NodeCounters counters;
+    /**
+     * Tury robotnika bez przetwarzania od counters.since (dla ramp i magazynów 0)
+     */
+    std::uint64_t idle_turns;
 };
 
 class Factory {
+    /*!
+     * Factory
+     * - przechowuje węzły sieci (rampy, robotników, magazyny)
+     * - posiada własną domenę ID paczek - paczki tworzone przez jej rampy nie dzielą stanu z innymi fabrykami,
+     *   więc niezależne symulacje mogą działać równolegle w osobnych wątkach
+     * - utrzymuje indeks odwrotny połączeń (LinkIndex), więc usunięcie odbiorcy dotyka tylko nadawców,
+     *   którzy do niego linkują
+     * - fazy tury mogą być wykonywane na stałej puli wątków (set_thread_count()) z wynikiem identycznym
+     *   jak przy wykonaniu szeregowym
+     * - liczniki pracy węzłów trzyma w jednej płaskiej tablicy (NodeCounters), której wpisy podpina węzłom
+     * - opcjonalnie śledzi cykl życia paczek (PackageLifecycleTracker) i zbiera histogramy opóźnień węzłów
+     */
 public:
-    void add_ramp(Ramp &&ramp) { ramps_.add(std::move(ramp)); }
+    Factory();
+
+    /**
+     * @brief Przenosi węzły razem z domeną ID, zegarem i indeksem połączeń; `factory` pozostaje pustą fabryką
+     * gotową do dalszego użycia
+     */
+    Factory(Factory &&factory) noexcept;
+
+    Factory &operator=(Factory &&factory) noexcept;
+
+    ~Factory();
+
+    void add_ramp(Ramp &&ramp) {
+        ramp.set_id_allocator(package_ids_.get());
+        Ramp &added = ramps_.add(std::move(ramp));
+        links_->attach(added, nullptr);
+        attach_random_source(added);
+        attach_counters(added);
+        added.set_lifecycle_tracker(lifecycle_.get());
+        invalidate_node_cache();
+    }
 
-    void remove_ramp(ElementID id) { ramps_.remove_by_id(id); };
+    void remove_ramp(ElementID id);
 
     NodeCollection<Ramp>::iterator find_ramp_by_id(ElementID id) { return ramps_.find_by_id(id); }
 
     NodeCollection<Ramp>::const_iterator find_ramp_by_id(ElementID id) const { return ramps_.find_by_id(id); };
 
+    NodeCollection<Ramp>::iterator ramp_begin() { return ramps_.begin(); }
+
+    NodeCollection<Ramp>::iterator ramp_end() { return ramps_.end(); }
+
     NodeCollection<Ramp>::const_iterator ramp_cbegin() const { return ramps_.cbegin(); }
 
     NodeCollection<Ramp>::const_iterator ramp_cend() const { return ramps_.cend(); }
 
-    void add_worker(Worker &&worker) { workers_.add(std::move(worker)); }
+    void add_worker(Worker &&worker) {
+        Worker &added = workers_.add(std::move(worker));
+        links_->attach(added, &added);
+        attach_random_source(added);
+        attach_counters(added);
+        added.set_lifecycle_tracker(lifecycle_.get());
+        invalidate_node_cache();
+    }
 
     void remove_worker(ElementID id) { remove_receiver(workers_, id); };
 
@@ -62,11 +268,20 @@ public:
 
     NodeCollection<Worker>::const_iterator find_worker_by_id(ElementID id) const { return workers_.find_by_id(id); };
 
+    NodeCollection<Worker>::iterator worker_begin() { return workers_.begin(); }
+
+    NodeCollection<Worker>::iterator worker_end() { return workers_.end(); }
+
     NodeCollection<Worker>::const_iterator worker_cbegin() const { return workers_.cbegin(); };
 
     NodeCollection<Worker>::const_iterator worker_cend() const { return workers_.cend(); };
 
-    void add_storehouse(Storehouse &&storehouse) { storehouses_.add(std::move(storehouse)); }
+    void add_storehouse(Storehouse &&storehouse) {
+        storehouse.set_clock(time_.get());
+        storehouse.set_lifecycle_tracker(lifecycle_.get());
+        attach_counters(storehouses_.add(std::move(storehouse)));
+        invalidate_node_cache();
+    }
 
     void remove_storehouse(ElementID id) { remove_receiver(storehouses_, id); };
 
@@ -74,35 +289,244 @@ public:
 
     NodeCollection<Storehouse>::const_iterator find_storehouse_by_id(ElementID id) const { return storehouses_.find_by_id(id); };
 
+    NodeCollection<Storehouse>::iterator storehouse_begin() { return storehouses_.begin(); }
+
+    NodeCollection<Storehouse>::iterator storehouse_end() { return storehouses_.end(); }
+
     NodeCollection<Storehouse>::const_iterator storehouse_cbegin() const { return storehouses_.cbegin(); }
 
     NodeCollection<Storehouse>::const_iterator storehouse_cend() const { return storehouses_.cend(); }
 
-    bool is_consistent() const;
-
+    /**
+     * @brief Rezerwuje miejsce w indeksach węzłów i połączeń przed wstawieniem dużej liczby węzłów
+     * (używane przez load_factory_structure(), które zna liczby węzłów przed ich utworzeniem)
+     */
+    void reserve(std::size_t ramps, std::size_t workers, std::size_t storehouses) {
+        ramps_.reserve(ramps);
+        workers_.reserve(workers);
+        storehouses_.reserve(storehouses);
+        links_->reserve(workers + storehouses, ramps + workers);
+        reserve_counters(ramps + workers + storehouses);
+    }
+
+    /**
+     * @brief Sprawdza spójność: każdy nadawca osiągalny z rampy musi mieć odbiorcę innego niż on sam.
+     * Status jest utrzymywany przyrostowo przez indeks połączeń przy każdej zmianie węzłów i linków,
+     * więc wywołanie kosztuje O(1), o ile wszyscy nadawcy mają odbiorców albo od poprzedniego wywołania
+     * nic się nie zmieniło; w przeciwnym razie sprawdzani są tylko nadawcy bez odbiorców, do których prowadzą
+     * zmienione węzły i linki.
+     */
+    bool is_consistent() const { return links_->is_consistent(); }
+
+    /**
+     * @brief Pełne sprawdzenie spójności: przejście iteracyjne (jawny stos) po gęstych indeksach węzłów,
+     * O(węzły + połączenia). Zwraca wszystkie naruszenia (posortowane według typu i ID); pusty wektor
+     * oznacza sieć spójną.
+     */
+    std::vector<InconsistentNode> find_inconsistent_nodes() const;
+
+    /**
+     * @brief Dostawa. Zawsze szeregowa, w kolejności ramp - także przy wielu wątkach (identyfikatory nowych paczek
+     * zależą od kolejności przydziału, a sama dostawa jest zbyt tania, by opłacało się ją dzielić na wątki).
+     */
     void do_deliveries(Time t);
 
+    /**
+     * @brief Przekazanie półproduktów. Przy wielu wątkach w dwóch fazach:
+     * - zebranie: wybór odbiorcy dla każdego nadawcy z pełnym buforem (przy wspólnym generatorze szeregowo,
+     *   w kolejności ramp i robotników; po set_routing_seed() równolegle), a następnie rozdzielenie przesyłek
+     *   na wątki według odbiorcy
+     * - zatwierdzenie: każdy odbiorca jest obsługiwany przez jeden wątek, który wstawia paczki w kolejności nadawców,
+     *   więc zawartość kolejek i magazynów nie zależy od liczby wątków
+     */
     void do_package_passing();
 
+    /**
+     * @brief Przetworzenie. Przy wielu wątkach robotnicy pracują równolegle (każdy zmienia tylko własny stan).
+     */
     void do_work(Time t);
 
+    /**
+     * @brief Ustawia liczbę wątków wykonujących fazy tury; 1 (domyślnie) oznacza wykonanie szeregowe.
+     * Pula wątków jest tworzona raz i używana we wszystkich kolejnych turach.
+     */
+    void set_thread_count(std::size_t threads);
+
+    std::size_t get_thread_count() const;
+
+    /**
+     * @brief Włącza powtarzalne losowanie tras: każdy nadawca (obecny i dodany później) losuje z licznikowego
+     * strumienia wyznaczonego przez (seed, typ i ID nadawcy, tura, numer losowania). Ten sam seed i ta sama
+     * struktura dają te same trasy niezależnie od silnika symulacji i liczby wątków.
+     * Bez wywołania tej metody trasy losowane są ze wspólnego generatora probability_generator.
+     */
+    void set_routing_seed(std::uint64_t seed);
+
+    /**
+     * @brief Ziarno losowania tras (brak, jeśli używany jest wspólny generator)
+     */
+    std::optional<std::uint64_t> get_routing_seed() const;
+
+    const PackageIDAllocator &get_package_id_allocator() const { return *package_ids_; }
+
+    /**
+     * @brief Zwraca nadawców (rampy i robotników), którzy mają danego odbiorcę w swoich preferencjach
+     */
+    const std::vector<PackageSender *> &get_senders_of(const IPackageReceiver *receiver) const {
+        return links_->get_senders(receiver);
+    }
+
+    /**
+     * @brief Bieżąca tura - ustawiana przez do_deliveries() i do_work()
+     */
+    Time get_time() const { return *time_; }
+
+    /**
+     * @brief Ustawia bieżącą turę (dla silników symulacji, które wywołują metody węzłów bezpośrednio)
+     */
+    void set_time(Time t) { *time_ = t; }
+
+    /**
+     * @brief Zapisuje punkt kontrolny stanu dynamicznego (format factory_checkpoint): bieżącą turę, kolejki
+     * i bufory robotników, bufory ramp, zawartość magazynów, rejestr ID paczek oraz stan losowania tras.
+     * Koszt jest liniowy względem liczby węzłów i paczek - punkt można zapisywać co kilka tur.
+     * Punkt kontrolny zapisuje się między turami (np. w funkcji raportowej symulacji).
+     */
+    void save_checkpoint(std::ostream &os) const;
+
+    /**
+     * @brief Odtwarza stan dynamiczny z punktu kontrolnego (zob. factory_checkpoint). Fabryka musi mieć tę samą strukturę
+     * co fabryka zapisująca (te same węzły w tej samej kolejności i te same rodzaje magazynów), inaczej std::logic_error.
+     */
+    void restore_checkpoint(const void *data, std::size_t size);
+
+    /**
+     * @brief Jak wyżej; punkt kontrolny jest wczytywany ze strumienia w całości
+     */
+    void restore_checkpoint(std::istream &is);
+
+    /**
+     * @brief Tworzy `branches` niezależnych gałęzi o tej samej strukturze i tym samym stanie dynamicznym; kolejki
+     * i magazyny są współdzielone do pierwszej zmiany. Fabryka bez ziarna tras pobiera ziarna gałęzi z rng (przesuwa go).
+     * Wymaga kolejek PackageQueue i magazynów PackageQueue, PackageLog albo AggregateStockpile (std::logic_error).
+     */
+    std::vector<Factory> fork(std::size_t branches) const;
+
+    /**
+     * @brief Liczniki pracy wszystkich węzłów (rampy, robotnicy, magazyny w kolejności list fabryki) na bieżącą turę.
+     * Liczniki zbierane są w dostawie, przetworzeniu i przekazaniu (także przez silnik zdarzeniowy i przy wielu
+     * wątkach); tury bez zdarzeń są liczone jako bezczynne. Węzeł jest liczony od dodania do fabryki; gałęzie
+     * fork() liczą od tury rozgałęzienia, klony struktury od zera. Punkt kontrolny liczników nie zapisuje -
+     * restore_checkpoint() zeruje je i liczy od odtworzonej tury.
+     * Przy wyłączonych licznikach (NETSIM_NODE_COUNTERS=0) zwraca pusty wektor.
+     */
+    std::vector<NodeCounterRecord> get_node_counters() const;
+
+    /**
+     * @brief Zeruje liczniki wszystkich węzłów; liczenie zaczyna się od następnej tury (np. po rozgrzaniu symulacji)
+     */
+    void reset_node_counters();
+
+    /**
+     * @brief Włącza albo wyłącza śledzenie cyklu życia paczek: znaczniki czasu dostawy i przyjęcia przez robotnika
+     * trafiają do tablicy według ID paczki, a opóźnienia - do histogramów robotników (oczekiwanie, pobyt)
+     * i magazynów (od dostawy do przybycia). Tablica obejmuje tylko paczki w obiegu (przybycie do magazynu kończy
+     * śledzenie paczki), histogramy - zakres opóźnień; historii paczek nie ma, więc pamięć nie rośnie z liczbą
+     * przetworzonych ani zmagazynowanych paczek.
+     * Śledzone są paczki dostarczone po włączeniu; wyłączenie usuwa tablicę i histogramy. Gałęzie fork()
+     * i klony struktury śledzenia nie dziedziczą.
+     */
+    void set_latency_tracking(bool enabled);
+
+    bool is_latency_tracking_enabled() const { return lifecycle_ != nullptr; }
+
 private:
+    struct ParallelState;
 
     template<class Node>
     void remove_receiver(NodeCollection<Node> &collection, ElementID id);
 
+    void invalidate_node_cache();
+
+    /**
+     * @brief Pełne sprawdzenie dla find_inconsistent_nodes(); przy failures == nullptr zatrzymuje się
+     * na pierwszym naruszeniu
+     */
+    bool check_consistency(std::vector<InconsistentNode> *failures) const;
+
+    void attach_random_source(Ramp &ramp);
+
+    void attach_random_source(Worker &worker);
+
+    /**
+     * @brief Przydziela węzłowi wpis tablicy liczników (wolny wpis po usuniętym węźle albo nowy)
+     */
+    template<class Node>
+    void attach_counters(Node &node);
+
+    template<class Node>
+    void release_counters(Node &node);
+
+    /**
+     * @brief Powiększa tablicę liczników do co najmniej `count` wpisów, przepinając wskaźniki węzłów
+     */
+    void reserve_counters(std::size_t count);
+
+    ParallelState &parallel_state();
+
+    // Domena ID musi zostać zniszczona po węzłach, więc jest deklarowana jako pierwsza.
+    std::unique_ptr<PackageIDAllocator> package_ids_ = std::make_unique<PackageIDAllocator>();
+    // Bieżąca tura leży na stercie, aby wskaźniki magazynów pozostały ważne po przeniesieniu fabryki.
+    std::unique_ptr<Time> time_ = std::make_unique<Time>(0);
+    // Indeks połączeń na stercie - preferencje węzłów trzymają do niego wskaźnik.
+    std::unique_ptr<LinkIndex> links_ = std::make_unique<LinkIndex>();
+    // Źródło losowości tras (nullptr = wspólny generator); preferencje nadawców trzymają do niego wskaźnik.
+    std::unique_ptr<RoutingRandomSource> routing_;
     NodeCollection<Ramp> ramps_;
     NodeCollection<Worker> workers_;
     NodeCollection<Storehouse> storehouses_;
-
+    // Pula wątków i bufory robocze trybu równoległego (nullptr = wykonanie szeregowe).
+    std::unique_ptr<ParallelState> parallel_;
+    // Liczniki węzłów; bufor wektora nie zmienia adresu przy przeniesieniu fabryki, więc wskaźniki węzłów pozostają ważne.
+    std::vector<NodeCounters> counters_;
+    std::vector<std::size_t> free_counters_;
+    // Śledzenie cyklu życia paczek (nullptr = wyłączone); węzły trzymają do niego wskaźnik.
+    std::unique_ptr<PackageLifecycleTracker> lifecycle_;
 };
 
-enum class ElementType {
-    RAMP,
-    WORKER,
-    STOREHOUSE,
-    LINK
-};
+template<class Node>
+void Factory::attach_counters(Node &node) {
+#if NETSIM_NODE_COUNTERS
+    std::size_t slot;
+    if (!free_counters_.empty()) {
+        slot = free_counters_.back();
+        free_counters_.pop_back();
+    } else {
+        if (counters_.size() == counters_.capacity()) {
+            reserve_counters(std::max<std::size_t>(16, 2 * counters_.size()));
+        }
+        slot = counters_.size();
+        counters_.emplace_back();
+    }
+    counters_[slot] = NodeCounters();
+    counters_[slot].since = *time_;
+    node.set_counters(&counters_[slot]);
+#else
+    (void) node;
+#endif
+}
+
+template<class Node>
+void Factory::release_counters(Node &node) {
+#if NETSIM_NODE_COUNTERS
+    if (node.get_counters() != nullptr) {
+        free_counters_.push_back(static_cast<std::size_t>(node.get_counters() - counters_.data()));
+        node.set_counters(nullptr);
+    }
+#else
+    (void) node;
+#endif
+}
 
 struct ParsedLineData {
     ElementType type;
@@ -128,6 +552,30 @@ const std::map<std::string, PackageQueueType> QUEUE_TYPE_NAMES = {
         {"LIFO", PackageQueueType::LIFO}
 };
 
+/**
+ * @brief Nazwa typu kolejki z QUEUE_TYPE_NAMES (odwrotne wyszukiwanie w mapie)
+ */
+const std::string &queue_type_name(PackageQueueType type);
+
+/**
+ * @brief Węzły z zakresu [begin, end) uporządkowane rosnąco według ID (numerycznie; węzły o równych ID zachowują
+ * kolejność listy). Sortowane są pary (ID, wskaźnik), więc porównanie nie sięga do węzłów.
+ */
+template<class Node, class Iterator>
+std::vector<const Node *> sorted_by_id(Iterator begin, Iterator end) {
+    std::vector<std::pair<ElementID, const Node *>> keys;
+    for (auto it = begin; it != end; ++it) {
+        keys.emplace_back(it->get_id(), &*it);
+    }
+    std::stable_sort(keys.begin(), keys.end(), [](const auto &a, const auto &b) { return a.first < b.first; });
+    std::vector<const Node *> nodes;
+    nodes.reserve(keys.size());
+    for (const auto &key: keys) {
+        nodes.push_back(key.second);
+    }
+    return nodes;
+}
+
 const std::map<ReceiverType, std::string> RECEIVER_TYPE_NAMES = {
         {ReceiverType::WORKER, "worker"},
         {ReceiverType::STOREHOUSE, "storehouse"}
@@ -138,7 +586,8 @@ const std::map<ReceiverType, std::string> RECEIVER_TYPE_NAMES_IO = {
         {ReceiverType::STOREHOUSE, "store"}
 };
 /**
- * @brief Parsuje linię (odczytuje dane i zwraca je w postaci struktury składającej się z typu i mapy danych)
+ * @brief Parsuje linię (odczytuje dane i zwraca je w postaci struktury składającej się z typu i mapy danych).
+ * load_factory_structure() z niej nie korzysta - pozostaje dla kodu, który potrzebuje mapy pól.
  * @note Linia przyjmuje poniższy format: \n
  * TAG {key=pair}xN \n
  * gdzie TAG to jeden z czterech możliwych typów elementów (LOADING_RAMP, WORKER, STOREHOUSE, LINK), przykładowo: \n
@@ -148,8 +597,53 @@ const std::map<ReceiverType, std::string> RECEIVER_TYPE_NAMES_IO = {
  */
 ParsedLineData parse_line(const std::string &line);
 
+/**
+ * Dopuszczalne odchylenie sumy prawdopodobieństw linków nadawcy od 1 przy wczytywaniu struktury (tekstowej
+ * i binarnej) - pliki zapisane z p= w zaokrągleniu (np. 0.333333) nie sumują się dokładnie do 1.
+ */
+constexpr double kProbabilitySumTolerance = 1e-4;
+
+/**
+ * @brief Sprawdza sumę prawdopodobieństw linków nadawcy z tolerancją kProbabilitySumTolerance; wspólne
+ * dla wczytywania struktury tekstowej i binarnej, więc oba formaty zgłaszają ten sam komunikat
+ * @return std::nullopt albo komunikat, np. "probabilities of links from ramp-1 sum to 1.16667"
+ */
+std::optional<std::string> probability_sum_error(ElementType sender_type, ElementID sender_id,
+                                                 const ReceiverPreferences::preferences_t &preferences);
+
+/**
+ * @brief Wczytuje strukturę fabryki z tekstu. Linie puste i zaczynające się od ';' są pomijane.
+ * Każda linia jest dzielona na tokeny widokami (std::string_view) bez kopiowania, a liczby parsowane
+ * przez std::from_chars do rekordu o stałych polach. Błędy (std::logic_error) zawierają numer linii,
+ * np. "line 12: worker not found: 7". Prawdopodobieństwa linków nadawcy (p= razem z równym podziałem linków bez p=)
+ * muszą sumować się do 1 - inaczej błąd wskazuje pierwszy link nadawcy z p=.
+ */
+Factory load_factory_structure(std::string_view text);
+
+/**
+ * @brief Jak wyżej; strumień jest najpierw wczytywany w całości odczytami blokowymi
+ */
 Factory load_factory_structure(std::istream &is);
 
+/**
+ * @brief Jak wyżej; plik jest wczytywany jednym odczytem
+ */
+Factory load_factory_structure_file(const std::string &path);
+
+/**
+ * @brief Zapisuje strukturę fabryki w formacie tekstowym. Węzły każdego typu są uporządkowane rosnąco według ID
+ * (numerycznie), linki - nadawca po nadawcy, a u nadawcy magazyny przed robotnikami, każde według ID.
+ * Linie są formatowane do stałego bufora i wypisywane blokami; poza buforem zapis zajmuje tylko tablicę
+ * (ID, wskaźnik) węzłów i odbiorców bieżącego nadawcy.
+ */
 void save_factory_structure(const Factory &factory, std::ostream &os);
 
+/**
+ * @brief Tworzy nową fabrykę o tej samej strukturze: węzły w tej samej kolejności, te same typy kolejek
+ * i tryby magazynów oraz te same preferencje (z prawdopodobieństwami). Nie kopiuje paczek, zegara,
+ * ziarna tras ani liczby wątków - klon startuje jak świeżo wczytana fabryka.
+ * Pozwala wczytać plik struktury raz i uruchomić wiele niezależnych symulacji.
+ */
+Factory clone_factory_structure(const Factory &factory);
+
 #endif //NETSIM_FACTORY_HPP
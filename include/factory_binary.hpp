@@ -0,0 +1,86 @@
+#ifndef NETSIM_FACTORY_BINARY_HPP
+#define NETSIM_FACTORY_BINARY_HPP
+
+/**
+ * plik nagłówkowy "factory_binary.hpp" zawierający binarny format struktury fabryki (zapis, odczyt, odwzorowanie pliku)
+*/
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include "factory.hpp"
+
+namespace factory_binary {
+    /*!
+     * Układ pliku (wersja 1, kolejność bajtów maszyny zapisującej - sprawdzana przez byte_order):
+     * - Header
+     * - RampRecord[ramp_count], WorkerRecord[worker_count], StorehouseRecord[storehouse_count]
+     *   (w kolejności list fabryki, więc wczytana fabryka ma węzły w tej samej kolejności)
+     * - std::uint64_t link_offsets[ramp_count + worker_count + 1] - tablica CSR: linki nadawcy s
+     *   (najpierw rampy, potem robotnicy) to links[link_offsets[s], link_offsets[s + 1])
+     * - LinkRecord[link_count] - odbiorca jako indeks w tablicy robotników albo magazynów oraz prawdopodobieństwo
+     * Wszystkie rekordy mają rozmiar będący wielokrotnością 8 bajtów, więc każda sekcja jest wyrównana
+     * i plik odwzorowany w pamięci (mmap) można czytać bezpośrednio, bez parsowania pól.
+     */
+    constexpr char kMagic[8] = {'N', 'E', 'T', 'S', 'I', 'M', 'F', 'S'};
+    constexpr std::uint32_t kVersion = 1;
+    constexpr std::uint32_t kByteOrderMark = 0x01020304;
+
+    struct Header {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t byte_order;
+        std::uint64_t ramp_count;
+        std::uint64_t worker_count;
+        std::uint64_t storehouse_count;
+        std::uint64_t link_count;
+    };
+
+    struct RampRecord {
+        std::int32_t id;
+        std::int32_t delivery_interval;
+    };
+
+    struct WorkerRecord {
+        std::int32_t id;
+        std::int32_t processing_time;
+        std::uint32_t queue_type;
+        std::uint32_t reserved;
+    };
+
+    struct StorehouseRecord {
+        std::int32_t id;
+        std::uint32_t reserved;
+    };
+
+    struct LinkRecord {
+        std::uint32_t receiver_type;
+        std::uint32_t receiver_index;
+        double probability;
+    };
+
+    /**
+     * @brief Czy bufor zaczyna się od nagłówka formatu binarnego (sprawdza tylko sygnaturę)
+     */
+    bool is_binary_structure(const void *data, std::size_t size);
+}
+
+/**
+ * @brief Zapisuje strukturę fabryki w formacie binarnym (factory_binary). Zapis jest bezstratny względem
+ * formatu tekstowego: ID, parametry węzłów, typy kolejek, połączenia i ich prawdopodobieństwa.
+ */
+void save_factory_structure_binary(const Factory &factory, std::ostream &os);
+
+/**
+ * @brief Wczytuje strukturę z bufora w formacie binarnym. Sekcje są czytane bezpośrednio z bufora; gdy bufor
+ * nie jest wyrównany do 8 bajtów, jest najpierw kopiowany. Błędny lub obcięty plik - std::logic_error.
+ */
+Factory load_factory_structure_binary(const void *data, std::size_t size);
+
+/**
+ * @brief Jak wyżej; plik jest odwzorowywany w pamięci (mmap) tylko na czas budowy fabryki
+ */
+Factory load_factory_structure_binary_file(const std::string &path);
+
+#endif //NETSIM_FACTORY_BINARY_HPP
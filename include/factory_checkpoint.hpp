@@ -0,0 +1,111 @@
+#ifndef NETSIM_FACTORY_CHECKPOINT_HPP
+#define NETSIM_FACTORY_CHECKPOINT_HPP
+
+/**
+ * plik nagłówkowy "factory_checkpoint.hpp" zawierający binarny format punktu kontrolnego stanu dynamicznego fabryki
+ * (zapis i odczyt: Factory::save_checkpoint() i Factory::restore_checkpoint())
+*/
+
+#include <cstddef>
+#include <cstdint>
+
+namespace factory_checkpoint {
+    /*!
+     * Układ punktu kontrolnego (wersja 1, kolejność bajtów maszyny zapisującej - sprawdzana przez byte_order):
+     * - Header
+     * - RampState[ramp_count], WorkerState[worker_count], StorehouseState[storehouse_count]
+     *   (w kolejności list fabryki; ID węzłów pozwalają sprawdzić, że struktura jest ta sama)
+     * - PackageRecord[package_count] - kolejki robotników (w kolejności pop()), potem zawartość magazynów
+     *   (w kolejności iteracji), węzeł po węźle
+     * - std::int32_t arrivals[arrival_count] - tury przybycia paczek magazynów typu PackageLog
+     * - std::uint64_t histogram[histogram_count] - histogramy magazynów zbiorczych (AggregateStockpile)
+     * - char rng_state[rng_state_size] - stan wspólnego generatora rng (tylko bez ziarna tras)
+     * Struktura fabryki (węzły, połączenia, prawdopodobieństwa) nie jest zapisywana - zapisuje ją
+     * save_factory_structure() albo save_factory_structure_binary().
+     *
+     * Odtworzenie (Factory::restore_checkpoint()):
+     * - błędny punkt kontrolny albo inna struktura fabryki są wykrywane przed zmianą stanu fabryki
+     * - dotychczasowe paczki fabryki są usuwane; liczniki węzłów i śledzenie opóźnień (tablica i histogramy)
+     *   zaczynają od nowa, więc paczki odtworzone z punktu nie dają próbek opóźnień
+     * - przy ziarnie tras (set_routing_seed()) resume_simulation() kontynuuje symulację dokładnie tak, jak fabryka
+     *   zapisująca; bez ziarna odtwarzany jest stan wspólnego generatora rng, ale wybór odbiorcy zależy wtedy
+     *   od adresów węzłów - dokładną kontynuację daje tylko odtworzenie w tej samej fabryce (cofnięcie symulacji)
+     */
+    constexpr char kMagic[8] = {'N', 'E', 'T', 'S', 'I', 'M', 'C', 'P'};
+    constexpr std::uint32_t kVersion = 1;
+    constexpr std::uint32_t kByteOrderMark = 0x01020304;
+
+    /**
+     * Flagi nagłówka
+     */
+    constexpr std::uint32_t kHasRoutingSeed = 1;
+    constexpr std::uint32_t kHasRngState = 2;
+
+    /**
+     * Rodzaj magazynu paczek w StorehouseState::stockpile_kind
+     */
+    enum class StockpileKind : std::uint32_t {
+        QUEUE_FIFO,
+        QUEUE_LIFO,
+        LOG,
+        AGGREGATE
+    };
+
+    struct Header {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t byte_order;
+        std::int32_t time;
+        std::uint32_t flags;
+        std::uint64_t routing_seed;
+        std::uint64_t ramp_count;
+        std::uint64_t worker_count;
+        std::uint64_t storehouse_count;
+        std::uint64_t package_count;
+        std::uint64_t arrival_count;
+        std::uint64_t histogram_count;
+        std::uint64_t rng_state_size;
+        std::uint64_t id_allocations;
+        std::uint64_t id_releases;
+    };
+
+    /**
+     * Paczka: id == 0 oznacza pusty bufor; factory_domain == 1 - ID z domeny fabryki (wraca do jej rejestru),
+     * 0 - paczka spoza domeny fabryki (odtwarzana bez rejestracji ID)
+     */
+    struct PackageRecord {
+        std::int32_t id;
+        std::uint32_t factory_domain;
+    };
+
+    struct RampState {
+        std::int32_t id;
+        std::uint32_t reserved;
+        PackageRecord sending;
+    };
+
+    struct WorkerState {
+        std::int32_t id;
+        std::int32_t processing_start_time;
+        PackageRecord processing;
+        PackageRecord sending;
+        std::uint64_t queue_size;
+    };
+
+    struct StorehouseState {
+        std::int32_t id;
+        std::uint32_t stockpile_kind;
+        std::uint64_t package_count;
+        std::int32_t interval;
+        std::uint32_t reserved;
+        std::uint64_t arrival_count;
+        std::uint64_t histogram_size;
+    };
+
+    /**
+     * @brief Czy bufor zaczyna się od nagłówka punktu kontrolnego (sprawdza tylko sygnaturę)
+     */
+    bool is_checkpoint(const void *data, std::size_t size);
+}
+
+#endif //NETSIM_FACTORY_CHECKPOINT_HPP
@@ -0,0 +1,47 @@
+#ifndef NETSIM_NODE_COUNTERS_HPP
+#define NETSIM_NODE_COUNTERS_HPP
+
+/**
+ * plik nagłówkowy "node_counters.hpp" zawierający liczniki pracy węzłów zbierane w trakcie symulacji
+*/
+
+#include <cstdint>
+#include "types.hpp"
+
+// Liczniki można wyłączyć w czasie kompilacji (-DNETSIM_NODE_COUNTERS=0, opcja CMake NETSIM_NODE_COUNTERS) -
+// węzły nie mają wtedy wskaźnika na liczniki, a miejsca zliczania w ogóle nie są kompilowane.
+#ifndef NETSIM_NODE_COUNTERS
+#define NETSIM_NODE_COUNTERS 1
+#endif
+
+constexpr bool kNodeCountersEnabled = NETSIM_NODE_COUNTERS != 0;
+
+struct NodeCounters {
+    /*!
+     * NodeCounters
+     * - jeden wpis płaskiej tablicy fabryki na węzeł; węzeł trzyma wskaźnik na swój wpis
+     * - każde pole zmienia tylko wątek obsługujący dany węzeł w danej fazie tury (dostawa, przetworzenie,
+     *   zatwierdzenie przekazania u odbiorcy), więc liczniki nie potrzebują operacji atomowych
+     */
+    /**
+     * Paczki odebrane (rampa: paczki dostarczone)
+     */
+    std::uint64_t received = 0;
+    std::uint64_t sent = 0;
+    /**
+     * Tury przetwarzania zakończonych paczek (robotnik); trwające przetwarzanie dolicza Factory::get_node_counters()
+     */
+    std::uint64_t busy_turns = 0;
+    /**
+     * Tury, w których węzeł miał zrobić kolejny krok (dostawa, przetworzenie), a w buforze nadawczym wciąż leżała
+     * paczka - nieprzekazana w fazie przekazania
+     */
+    std::uint64_t blocked_turns = 0;
+    std::uint64_t max_queue_depth = 0;
+    /**
+     * Tura, od której węzeł jest liczony (dodanie do fabryki albo Factory::reset_node_counters())
+     */
+    Time since = 0;
+};
+
+#endif //NETSIM_NODE_COUNTERS_HPP
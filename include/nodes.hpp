@@ -6,12 +6,16 @@
 #define NETSIM_NODES_HPP
 
 #include "config.hpp"
+#include <algorithm>
 #include <memory>
 #include <utility>
 #include <vector>
 #include <optional>
 #include <map>
+#include "counter_rng.hpp"
+#include "node_counters.hpp"
 #include "package.hpp"
+#include "package_lifecycle.hpp"
 #include "storage_types.hpp"
 #include "types.hpp"
 #include "helpers.hpp"
@@ -61,9 +65,40 @@ public:
 #endif
 
     void receive_package(Package &&p) override {
-        stockpile_->push(std::move(p));
+        if (lifecycle_ != nullptr) {
+            lifecycle_->on_stored(p.get_id(), *latency_);
+        }
+        stockpile_->push_at(std::move(p), clock_ != nullptr ? *clock_ : 0);
+#if NETSIM_NODE_COUNTERS
+        if (counters_ != nullptr) {
+            ++counters_->received;
+        }
+#endif
     }
 
+    /**
+     * @brief Podpina zegar symulacji, z którego magazyn odczytuje turę przybycia paczek (robi to fabryka).
+     * @param clock - wskaźnik na bieżącą turę (nullptr = tura 0)
+     */
+    void set_clock(const Time *clock) { clock_ = clock; };
+
+    const IPackageStockpile *get_stockpile() const { return stockpile_.get(); };
+
+    IPackageStockpile *get_stockpile() { return stockpile_.get(); };
+
+    /**
+     * @brief Czy magazyn pracuje w trybie zbiorczym (tylko liczniki, bez przechowywania paczek)
+     */
+    bool is_aggregate() const { return dynamic_cast<const AggregateStockpile *>(stockpile_.get()) != nullptr; };
+
+    /**
+     * @brief Liczba paczek zgromadzonych w magazynie (w trybie zbiorczym - liczba paczek, które dotarły)
+     */
+    std::size_t get_stored_count() const {
+        auto aggregate = dynamic_cast<const AggregateStockpile *>(stockpile_.get());
+        return aggregate != nullptr ? aggregate->get_arrival_count() : stockpile_->size();
+    };
+
     IPackageStockpile::const_iterator begin() const override {
         return stockpile_->begin();
     }
@@ -80,10 +115,53 @@ public:
         return stockpile_->cend();
     }
 
+#if NETSIM_NODE_COUNTERS
+    /**
+     * @brief Podpina wpis tablicy liczników (robi to fabryka; nullptr = węzeł niezliczany)
+     */
+    void set_counters(NodeCounters *counters) { counters_ = counters; };
+
+    NodeCounters *get_counters() const { return counters_; };
+#endif
+
+    /**
+     * @brief Podpina śledzenie cyklu życia paczek (robi to fabryka). Z podpiętym śledzeniem magazyn zbiera
+     * histogram czasu od dostawy do przybycia; nullptr odłącza śledzenie i zwalnia histogram.
+     */
+    void set_lifecycle_tracker(PackageLifecycleTracker *tracker) {
+        lifecycle_ = tracker;
+        latency_ = tracker != nullptr ? std::make_unique<StorehouseLatency>() : nullptr;
+    };
+
+    /**
+     * @brief Histogram opóźnień magazynu (nullptr bez śledzenia cyklu życia paczek)
+     */
+    const StorehouseLatency *get_latency() const { return latency_.get(); };
+
 private:
     std::unique_ptr<IPackageStockpile> stockpile_;
+    const Time *clock_ = nullptr;
+#if NETSIM_NODE_COUNTERS
+    NodeCounters *counters_ = nullptr;
+#endif
+    PackageLifecycleTracker *lifecycle_ = nullptr;
+    std::unique_ptr<StorehouseLatency> latency_;
 };
 
+class PackageSender;
+
+class ILinkObserver {
+    /**
+     * Interfejs dla obiektów śledzących połączenia nadawca -> odbiorca (np. indeks odwrotny fabryki).
+     * ReceiverPreferences powiadamia obserwatora o każdym dodanym i usuniętym odbiorcy.
+     */
+public:
+    virtual void on_link_added(PackageSender *sender, IPackageReceiver *receiver) = 0;
+
+    virtual void on_link_removed(PackageSender *sender, IPackageReceiver *receiver) = 0;
+
+    virtual ~ILinkObserver() = default;
+};
 
 class ReceiverPreferences {
     /**
@@ -115,7 +193,9 @@ public:
 
     /**
      * metoda choose_receiver() zwraca wskaźnik na odbiorcę, który został wylosowany zgodnie z preferencjami.
-     * Polega to na wylosowaniu wartości z przedziału [0,1] i sprawdzeniu, do którego odbiorcy należy.
+     * Korzysta z tablicy aliasów (metoda Walkera/Vose'a): jedna wartość u z przedziału [0,1) wybiera kolumnę
+     * floor(u * k), a część ułamkowa decyduje, czy zwrócić odbiorcę kolumny, czy jego alias - O(1) niezależnie
+     * od liczby odbiorców. Tablica jest przebudowywana leniwie, dopiero po zmianie preferencji.
      *
      * @return wskaźnik na odbiorcę
      */
@@ -123,11 +203,48 @@ public:
 
     const preferences_t &get_preferences() const { return preferences_; };
 
-    void set_preferences(preferences_t preferences) { preferences_ = std::move(preferences); };
+    void set_preferences(preferences_t preferences);
+
+    /**
+     * @brief Podpina obserwatora połączeń. Zgłaszane są tylko zmiany wykonane po podpięciu
+     * (przez add_receiver(), remove_receiver() i set_preferences()).
+     * @param observer - obserwator (nullptr = brak)
+     * @param owner - nadawca, do którego należą preferencje
+     */
+    void set_link_observer(ILinkObserver *observer, PackageSender *owner) {
+        observer_ = observer;
+        owner_ = owner;
+    };
+
+    /**
+     * @brief Przełącza losowanie na źródło licznikowe (zamiast generatora przekazanego w konstruktorze).
+     * Wartość losowania zależy wtedy tylko od (ziarno, stream, tura, numer losowania w turze), a kolumny tablicy
+     * aliasów są uporządkowane według (typ odbiorcy, ID) - wybory nie zależą od kolejności wywołań ani adresów węzłów.
+     * @param source - źródło losowości (nullptr = powrót do generatora)
+     * @param stream - klucz strumienia nadawcy, unikalny w obrębie fabryki
+     */
+    void set_random_source(const RoutingRandomSource *source, std::uint64_t stream);
 
 private:
+    void rebuild_alias_table();
+
+    double next_random();
+
     ProbabilityGenerator generator_;
+    const RoutingRandomSource *random_source_ = nullptr;
+    std::uint64_t random_stream_ = 0;
+    Time draw_turn_ = 0;
+    std::uint32_t draw_index_ = 0;
     preferences_t preferences_;
+    ILinkObserver *observer_ = nullptr;
+    PackageSender *owner_ = nullptr;
+
+    // Tablica aliasów: kolumna i zwraca alias_receivers_[i] z prawdopodobieństwem alias_threshold_[i],
+    // a w przeciwnym razie alias_receivers_[alias_[i]].
+    std::vector<IPackageReceiver *> alias_receivers_;
+    std::vector<double> alias_threshold_;
+    std::vector<std::size_t> alias_;
+    bool alias_table_valid_ = false;
 };
 
 class PackageSender {
@@ -138,8 +255,16 @@ public:
 
     /**
      * @brief Metoda send_package() wysyła paczkę z bufora do odbiorcy
+     * @return odbiorca, do którego trafiła paczka (nullptr, gdy bufor był pusty)
+     */
+    IPackageReceiver *send_package();
+
+    /**
+     * @brief Przekazuje paczkę z bufora wskazanemu odbiorcy (bez losowania - odbiorca wybrany wcześniej).
+     * Bufor nie może być pusty.
+     * @param receiver - odbiorca paczki
      */
-    void send_package();
+    void send_package_to(IPackageReceiver *receiver);
 
     /**
      * @brief Metoda get_sending_buffer() zwraca odnośnik na paczkę
@@ -147,6 +272,20 @@ public:
      */
     const std::optional<Package> &get_sending_buffer() const { return sending_buffer_; };
 
+    /**
+     * @brief Zastępuje zawartość bufora (np. przy odtwarzaniu punktu kontrolnego)
+     */
+    void set_sending_buffer(std::optional<Package> p) { sending_buffer_ = std::move(p); };
+
+#if NETSIM_NODE_COUNTERS
+    /**
+     * @brief Podpina wpis tablicy liczników (robi to fabryka; nullptr = węzeł niezliczany)
+     */
+    void set_counters(NodeCounters *counters) { counters_ = counters; };
+
+    NodeCounters *get_counters() const { return counters_; };
+#endif
+
     ReceiverPreferences receiver_preferences_;
 protected:
     /**
@@ -155,6 +294,9 @@ protected:
      */
     void push_package(Package &&p) { sending_buffer_ = std::move(p); };
     std::optional<Package> sending_buffer_ = std::nullopt;
+#if NETSIM_NODE_COUNTERS
+    NodeCounters *counters_ = nullptr;
+#endif
 };
 
 class Ramp : public PackageSender {
@@ -169,16 +311,36 @@ public:
      */
     void deliver_goods(Time t);
 
+    /**
+     * @brief Czy w turze t przypada dostawa (tj. czy deliver_goods(t) utworzy paczkę)
+     */
+    bool is_delivery_turn(Time t) const { return (t - 1) % di_ == 0; }
+
     TimeOffset get_delivery_interval() const { return di_; };
 
     ElementID get_id() const { return id_; };
 
+    /**
+     * @brief Ustawia domenę ID, z której rampa przydziela identyfikatory nowym paczkom.
+     * Fabryka podpina tu własną domenę; bez niej używana jest domyślna domena procesu.
+     * @param allocator - alokator ID (nullptr = domena domyślna)
+     */
+    void set_id_allocator(PackageIDAllocator *allocator) { id_allocator_ = allocator; };
+
+    /**
+     * @brief Podpina śledzenie cyklu życia paczek - rampa zgłasza turę dostawy każdej nowej paczki
+     * (robi to fabryka; nullptr = bez śledzenia)
+     */
+    void set_lifecycle_tracker(PackageLifecycleTracker *tracker) { lifecycle_ = tracker; };
+
 private:
     /**
      * @brief Czas między dostawami
      */
     TimeOffset di_;
     ElementID id_;
+    PackageIDAllocator *id_allocator_ = nullptr;
+    PackageLifecycleTracker *lifecycle_ = nullptr;
 };
 
 class Worker : public IPackageReceiver, public PackageSender {
@@ -218,18 +380,59 @@ public:
      * @brief Metoda receive_package() pozwala pracownikowi odebrać paczkę.
      * @param p - paczka do odebrania
      */
-    void receive_package(Package &&p) override { package_queue_->push(std::move(p)); }
+    void receive_package(Package &&p) override {
+        if (lifecycle_ != nullptr) {
+            lifecycle_->on_enqueued(p.get_id());
+        }
+        package_queue_->push(std::move(p));
+#if NETSIM_NODE_COUNTERS
+        if (counters_ != nullptr) {
+            ++counters_->received;
+            counters_->max_queue_depth = std::max<std::uint64_t>(counters_->max_queue_depth, package_queue_->size());
+        }
+#endif
+    }
 
     TimeOffset get_processing_duration() const { return pd_; };
 
     Time get_package_processing_start_time() const { return package_processing_start_time_; };
 
+    /**
+     * @brief Zwraca paczkę aktualnie przetwarzaną przez pracownika (bufor przetwarzania)
+     */
+    const std::optional<Package> &get_processing_buffer() const { return current_package_; };
+
+    /**
+     * @brief Zastępuje zawartość bufora przetwarzania i turę rozpoczęcia przetwarzania
+     * (np. przy odtwarzaniu punktu kontrolnego)
+     */
+    void set_processing_buffer(std::optional<Package> p, Time start_time) {
+        current_package_ = std::move(p);
+        package_processing_start_time_ = start_time;
+    };
+
     IPackageQueue* get_queue() const { return package_queue_.get(); };
 
+    /**
+     * @brief Podpina śledzenie cyklu życia paczek (robi to fabryka). Z podpiętym śledzeniem robotnik zbiera
+     * histogramy oczekiwania w kolejce i pobytu; nullptr odłącza śledzenie i zwalnia histogramy.
+     */
+    void set_lifecycle_tracker(PackageLifecycleTracker *tracker) {
+        lifecycle_ = tracker;
+        latency_ = tracker != nullptr ? std::make_unique<WorkerLatency>() : nullptr;
+    };
+
+    /**
+     * @brief Histogramy opóźnień robotnika (nullptr bez śledzenia cyklu życia paczek)
+     */
+    const WorkerLatency *get_latency() const { return latency_.get(); };
+
 private:
     TimeOffset pd_;
     Time package_processing_start_time_ = 0;
     std::unique_ptr<IPackageQueue> package_queue_;
+    PackageLifecycleTracker *lifecycle_ = nullptr;
+    std::unique_ptr<WorkerLatency> latency_;
 
     std::optional<Package> current_package_ = std::nullopt;
 };
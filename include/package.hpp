@@ -5,16 +5,47 @@
  * plik nagłówkowy "package.hpp" zawierający definicję klasy Package
 */
 
-#include <set>
+#include "package_id_allocator.hpp"
 #include "types.hpp"
 
 class Package {
+    /*!
+     * Package działa jak uchwyt na identyfikator: przeniesienie kopiuje tylko liczbę, a obiekt źródłowy
+     * przechodzi w stan "pusty" (kNoID), więc jego destruktor nie zwalnia identyfikatora ponownie.
+     * Paczka pamięta alokator (domenę ID), z którego pochodzi jej identyfikator, i do niego go zwraca.
+     */
 public:
-    Package();
+    /**
+     * @brief Identyfikator obiektu, z którego przeniesiono zawartość
+     */
+    static constexpr ElementID kNoID = 0;
 
+    /**
+     * @brief Tworzy paczkę z identyfikatorem z domyślnej, wspólnej dla procesu domeny ID
+     */
+    Package() : Package(default_id_allocator) {};
+
+    /**
+     * @brief Tworzy paczkę z identyfikatorem z podanej domeny ID (np. domeny fabryki)
+     * @param allocator - alokator, z którego pobierany jest (i do którego wraca) identyfikator
+     */
+    explicit Package(PackageIDAllocator &allocator) : id_(allocator.allocate()), allocator_(&allocator) {};
+
+    /**
+     * @brief Tworzy paczkę o zadanym identyfikatorze; identyfikator nie jest rejestrowany ani zwalniany
+     */
     Package(ElementID id) : id_(id) {};
 
-    Package(Package &&package) = default;
+    /**
+     * @brief Tworzy paczkę z identyfikatorem już oznaczonym jako przydzielony w podanej domenie
+     * (PackageIDAllocator::acquire()) - np. przy odtwarzaniu punktu kontrolnego; paczka zwolni go w destruktorze
+     */
+    Package(PackageIDAllocator &allocator, ElementID id) : id_(id), allocator_(&allocator) {};
+
+    Package(Package &&package) noexcept : id_(package.id_), allocator_(package.allocator_) {
+        package.id_ = kNoID;
+        package.allocator_ = nullptr;
+    };
 
     Package(const Package &package) = delete;
 
@@ -24,12 +55,24 @@ public:
 
     ElementID get_id() const { return id_; };
 
+    /**
+     * @brief Czy identyfikator paczki pochodzi z podanej domeny ID (i do niej wróci)
+     */
+    bool belongs_to(const PackageIDAllocator &allocator) const { return allocator_ == &allocator; };
+
+    /**
+     * @brief Domena ID, do której wróci identyfikator paczki (nullptr - identyfikator nie jest rejestrowany)
+     */
+    const PackageIDAllocator *get_domain() const { return allocator_; };
+
     ~Package();
 
+    static const PackageIDAllocator &get_id_allocator() { return default_id_allocator; };
+
 private:
     ElementID id_;
-    static std::set<ElementID> freed_IDs;
-    static std::set<ElementID> assigned_IDs;
+    PackageIDAllocator *allocator_ = nullptr;
+    static PackageIDAllocator default_id_allocator;
 };
 
 #endif //NETSIM_PACKAGE_HPP
\ No newline at end of file
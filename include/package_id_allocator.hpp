@@ -0,0 +1,79 @@
+#ifndef NETSIM_PACKAGE_ID_ALLOCATOR_HPP
+#define NETSIM_PACKAGE_ID_ALLOCATOR_HPP
+
+/**
+ * plik nagłówkowy "package_id_allocator.hpp" zawierający definicję klasy PackageIDAllocator
+*/
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "types.hpp"
+
+class PackageIDAllocator {
+    /*!
+     * PackageIDAllocator
+     * - przydziela identyfikatory paczek z gęstego zakresu [1, capacity()]
+     * - zawsze zwraca najmniejszy wolny identyfikator (tak jak wcześniejsza implementacja na std::set)
+     * - stan przechowywany jest w hierarchicznej mapie bitowej: poziom 0 to bity identyfikatorów
+     *   (1 = wolny), a każdy bit poziomu k mówi, czy odpowiadające mu słowo poziomu k-1 ma wolny bit
+     * - allocate() i release() kosztują O(liczba poziomów), czyli log_64(n) - w praktyce co najwyżej 4-5 kroków,
+     *   bez alokacji węzła na każdy identyfikator
+     */
+public:
+    /**
+     * @brief Przydziela najmniejszy wolny identyfikator (w razie potrzeby powiększa zakres)
+     * @return przydzielony identyfikator (>= 1)
+     */
+    ElementID allocate();
+
+    /**
+     * @brief Zwalnia identyfikator. Zwolnienie identyfikatora, który nie jest przydzielony, nic nie robi.
+     * @param id - identyfikator do zwolnienia
+     */
+    void release(ElementID id);
+
+    /**
+     * @brief Oznacza podany identyfikator jako przydzielony (w razie potrzeby powiększa zakres) - pozwala odtworzyć
+     * rejestr z zapisanego stanu. Nie zmienia licznika wywołań allocate().
+     * @return false, gdy identyfikator jest już przydzielony albo nie jest dodatni
+     */
+    bool acquire(ElementID id);
+
+    bool is_assigned(ElementID id) const;
+
+    std::size_t assigned_count() const { return assigned_count_; }
+
+    /**
+     * @brief Liczniki wywołań allocate() i release() - pozwalają sprawdzić, ile razy paczki sięgnęły do rejestru
+     */
+    std::size_t allocation_count() const { return allocation_count_; }
+
+    std::size_t release_count() const { return release_count_; }
+
+    /**
+     * @brief Ustawia liczniki wywołań allocate() i release() (przy odtwarzaniu zapisanego stanu)
+     */
+    void set_counters(std::size_t allocations, std::size_t releases) {
+        allocation_count_ = allocations;
+        release_count_ = releases;
+    }
+
+    std::size_t capacity() const { return levels_.empty() ? 0 : levels_.front().size() * kWordBits; }
+
+private:
+    static constexpr std::size_t kWordBits = 64;
+
+    void grow();
+
+    void mark_used(std::size_t bit);
+
+    void mark_free(std::size_t bit);
+
+    std::vector<std::vector<std::uint64_t>> levels_;
+    std::size_t assigned_count_ = 0;
+    std::size_t allocation_count_ = 0;
+    std::size_t release_count_ = 0;
+};
+
+#endif //NETSIM_PACKAGE_ID_ALLOCATOR_HPP
@@ -0,0 +1,155 @@
+#ifndef NETSIM_PACKAGE_LIFECYCLE_HPP
+#define NETSIM_PACKAGE_LIFECYCLE_HPP
+
+/**
+ * plik nagłówkowy "package_lifecycle.hpp" zawierający śledzenie cyklu życia paczek (tablica znaczników czasu
+ * paczek w obiegu) oraz histogramy opóźnień o stałej pamięci
+*/
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+#include "types.hpp"
+
+class LatencyHistogram {
+    /*!
+     * LatencyHistogram
+     * - histogram logarytmiczny: wartości 0..31 mają własne kubełki, każda kolejna potęga dwójki dzieli się
+     *   na 16 kubełków, więc błąd względny percentyla nie przekracza 1/16 (6,25%)
+     * - pamięć nie zależy od liczby próbek: kubełków przybywa tylko do najwyższego użytego - dla wartości
+     *   poniżej 2^33 (z zapasem różnica dwóch wartości Time) co najwyżej kMaxBuckets
+     */
+public:
+    static constexpr unsigned kSubBucketBits = 4;
+    static constexpr std::size_t kMaxBuckets = (32 - kSubBucketBits) * (std::size_t(1) << kSubBucketBits) + 32;
+
+    void add(std::uint64_t value);
+
+    void merge(const LatencyHistogram &other);
+
+    std::uint64_t count() const { return count_; }
+
+    std::uint64_t max() const { return max_; }
+
+    double mean() const { return count_ == 0 ? 0.0 : static_cast<double>(sum_) / static_cast<double>(count_); }
+
+    /**
+     * @brief Percentyl q (0 < q <= 1): górna granica kubełka, w którym leży próbka o randze ceil(q * count()),
+     * ograniczona przez max(); 0 dla pustego histogramu
+     */
+    std::uint64_t percentile(double q) const;
+
+    std::size_t bucket_count() const { return buckets_.size(); }
+
+private:
+    static std::size_t bucket_of(std::uint64_t value);
+
+    static std::uint64_t bucket_upper_bound(std::size_t bucket);
+
+    std::vector<std::uint64_t> buckets_;
+    std::uint64_t count_ = 0;
+    std::uint64_t sum_ = 0;
+    std::uint64_t max_ = 0;
+};
+
+/**
+ * Histogramy robotnika (w turach): oczekiwanie w kolejce (odebranie -> początek przetwarzania) i pobyt
+ * (odebranie -> koniec przetwarzania, włącznie z turą zakończenia)
+ */
+struct WorkerLatency {
+    LatencyHistogram wait;
+    LatencyHistogram sojourn;
+};
+
+/**
+ * Histogram magazynu: czas od dostawy paczki na rampie do jej przybycia do magazynu (w turach)
+ */
+struct StorehouseLatency {
+    LatencyHistogram end_to_end;
+};
+
+class PackageLifecycleTracker {
+    /*!
+     * PackageLifecycleTracker
+     * - tablica znaczników czasu (dostawa, przyjęcie do kolejki bieżącego robotnika) paczek w obiegu:
+     *   adresowanie otwarte (sondowanie liniowe) według ID paczki, 16 B na wpis
+     * - przybycie do magazynu kończy śledzenie paczki - wpis jest tylko oznaczany, a usuwany przy najbliższej
+     *   przebudowie tablicy, więc jej rozmiar zależy od liczby paczek w obiegu, a nie od liczby paczek
+     *   w magazynach ani od największego ID w użyciu; wpis paczki usuniętej inaczej (np. razem z robotnikiem)
+     *   zostaje do ponownego przydziału jej ID
+     * - początku przetwarzania nie zapisuje - robotnik zna go sam i podaje przy zakończeniu
+     * - historii paczki nie przechowuje: zakończenie przetwarzania i przybycie do magazynu od razu trafiają
+     *   do histogramów węzła, a wpis jest nadpisywany przez kolejny etap albo przez nową paczkę o tym ID
+     * - układ tablicy zmienia się tylko przy dostawie (fazie szeregowej); pozostałe zdarzenia zmieniają wyłącznie
+     *   wpis swojej paczki i histogramy swojego węzła, więc można je zgłaszać z wątków puli
+     * - paczki spoza tablicy (np. obecne w fabryce przed włączeniem śledzenia) nie dają próbek dla etapów,
+     *   których początku nie widziano; znacznik z przyszłości (nieaktualny wpis) też nie daje próbki
+     */
+public:
+    /**
+     * @param clock - bieżąca tura (odczytywana przy przyjęciu paczki przez robotnika i magazyn)
+     */
+    explicit PackageLifecycleTracker(const Time *clock) : clock_(clock) {};
+
+    void on_created(ElementID id, Time t);
+
+    void on_enqueued(ElementID id);
+
+    /**
+     * @brief Zakończenie przetwarzania paczki rozpoczętego w turze start - próbki oczekiwania i pobytu robotnika
+     */
+    void on_finished(ElementID id, Time start, Time t, WorkerLatency &latency);
+
+    void on_stored(ElementID id, StorehouseLatency &latency);
+
+    /**
+     * @brief Liczba miejsc w tablicy (co najmniej dwukrotność liczby zajętych wpisów)
+     */
+    std::size_t table_size() const { return entries_.size(); }
+
+private:
+    static constexpr Time kUnknown = std::numeric_limits<Time>::min();
+
+    struct Entry {
+        // 0 - wolne miejsce
+        ElementID id = 0;
+        Time created = kUnknown;
+        Time enqueued = kUnknown;
+        // Paczka dotarła do magazynu - wpis zostanie usunięty przy przebudowie.
+        bool stored = false;
+    };
+
+    std::size_t slot_of(ElementID id) const {
+        // Mnożenie Fibonacciego - kolejne ID trafiają w rozrzucone miejsca.
+        return static_cast<std::size_t>((static_cast<std::uint64_t>(id) * 0x9E3779B97F4A7C15ULL) >> 32)
+               & (entries_.size() - 1);
+    }
+
+    Entry *find(ElementID id) {
+        if (id <= 0 || entries_.empty()) {
+            return nullptr;
+        }
+        for (std::size_t slot = slot_of(id);; slot = (slot + 1) & (entries_.size() - 1)) {
+            if (entries_[slot].id == id) {
+                return &entries_[slot];
+            }
+            if (entries_[slot].id == 0) {
+                return nullptr;
+            }
+        }
+    }
+
+    /**
+     * @brief Przebudowuje tablicę bez wpisów paczek, które dotarły do magazynu; po przebudowie zajęta jest
+     * co najwyżej ćwierć miejsc, więc koszt rozkłada się na kolejne dostawy
+     */
+    void rebuild();
+
+    const Time *clock_;
+    std::vector<Entry> entries_;
+    // Zajęte miejsca (także przez wpisy oznaczone jako stored).
+    std::size_t used_ = 0;
+};
+
+#endif //NETSIM_PACKAGE_LIFECYCLE_HPP
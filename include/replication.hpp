@@ -0,0 +1,110 @@
+#ifndef NETSIM_REPLICATION_HPP
+#define NETSIM_REPLICATION_HPP
+
+/**
+ * plik nagłówkowy "replication.hpp" zawierający funkcję run_replications() (wielokrotna symulacja Monte Carlo
+ * tej samej struktury) oraz struktury ze statystykami zbiorczymi
+*/
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "factory.hpp"
+#include "simulation.hpp"
+#include "types.hpp"
+
+class RunningStatistic {
+    /*!
+     * RunningStatistic
+     * - średnia i wariancja liczone strumieniowo (algorytm Welforda), bez przechowywania próbek
+     * - merge() łączy dwie statystyki (wzór Chana i in.), więc wątki mogą liczyć lokalnie i scalać wyniki na końcu
+     */
+public:
+    void add(double x);
+
+    void merge(const RunningStatistic &other);
+
+    std::size_t count() const { return count_; }
+
+    double mean() const { return mean_; }
+
+    /**
+     * @brief Wariancja z próby (dzielnik n - 1); 0 dla mniej niż dwóch próbek
+     */
+    double variance() const;
+
+    double stddev() const;
+
+    /**
+     * @brief Połowa szerokości przedziału ufności średniej: z * s / sqrt(n) (przybliżenie normalne, domyślnie 95%)
+     */
+    double confidence_half_width(double z = 1.96) const;
+
+private:
+    std::size_t count_ = 0;
+    double mean_ = 0;
+    double m2_ = 0;
+};
+
+struct WorkerReplicationStatistics {
+    ElementID id;
+    /**
+     * Liczba paczek przetworzonych na turę
+     */
+    RunningStatistic throughput;
+    /**
+     * Średnia (po turach) długość kolejki
+     */
+    RunningStatistic mean_queue_length;
+    RunningStatistic max_queue_length;
+};
+
+struct StorehouseReplicationStatistics {
+    ElementID id;
+    /**
+     * Liczba paczek w magazynie po ostatniej turze
+     */
+    RunningStatistic stored;
+};
+
+struct ReplicationSummary {
+    /*!
+     * ReplicationSummary
+     * - każda statystyka ma jedną próbkę na replikację (wartość z całego przebiegu)
+     * - węzły w kolejności list fabryki-wzorca
+     */
+    std::size_t replications = 0;
+    /**
+     * Paczki docierające do wszystkich magazynów na turę
+     */
+    RunningStatistic plant_throughput;
+    std::vector<WorkerReplicationStatistics> workers;
+    std::vector<StorehouseReplicationStatistics> storehouses;
+
+    void merge(const ReplicationSummary &other);
+};
+
+struct ReplicationOptions {
+    std::size_t replications = 200;
+    TimeOffset turns = 1000;
+    /**
+     * Replikacja r używa ziarna tras base_seed + r
+     */
+    std::uint64_t base_seed = 1;
+    /**
+     * Liczba wątków (0 = liczba rdzeni)
+     */
+    std::size_t threads = 0;
+    SimulationEngine engine = SimulationEngine::TURN_BASED;
+};
+
+/**
+ * @brief Przeprowadza options.replications niezależnych symulacji struktury prototype.
+ * Każda replikacja działa na klonie struktury (clone_factory_structure()) z własnym ziarnem tras, więc wynik
+ * nie zależy od pozostałych replikacji; replikacje są rozdzielane na stałą pulę wątków.
+ * Statystyki są scalane na bieżąco - pamięć nie zależy od liczby replikacji.
+ * @param prototype - fabryka-wzorzec (musi być spójna; nie jest modyfikowana)
+ */
+ReplicationSummary run_replications(const Factory &prototype, const ReplicationOptions &options);
+
+#endif //NETSIM_REPLICATION_HPP
@@ -0,0 +1,147 @@
+#ifndef NETSIM_REPORTS_HPP
+#define NETSIM_REPORTS_HPP
+
+/**
+ * plik nagłówkowy "reports.hpp" zawierający funkcje generujące raporty o strukturze fabryki i o stanie symulacji
+*/
+
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <ostream>
+#include <thread>
+#include <vector>
+#include "factory.hpp"
+#include "types.hpp"
+
+/**
+ * @brief Wypisuje raport o strukturze sieci: rampy, robotnicy (z typem kolejki) i magazyny wraz z odbiorcami.
+ * Węzły i odbiorcy są uporządkowani rosnąco według ID. Jeśli fabryka ma ziarno tras, raport kończy sekcja ROUTING.
+ * @param f - fabryka
+ * @param os - strumień wyjściowy
+ */
+void generate_structure_report(const Factory &f, std::ostream &os);
+
+/**
+ * @brief Wypisuje raport o stanie symulacji w danej turze: zawartość buforów i kolejek robotników oraz magazynów.
+ * @param f - fabryka
+ * @param os - strumień wyjściowy
+ * @param t - numer tury
+ */
+void generate_simulation_turn_report(const Factory &f, std::ostream &os, Time t);
+
+/**
+ * @brief Zapisuje liczniki węzłów (Factory::get_node_counters()) jako CSV: nagłówek i jeden wiersz na węzeł
+ * (type,id,received,sent,busy_turns,idle_turns,blocked_turns,max_queue_depth,since).
+ */
+void write_node_counters_csv(const Factory &f, std::ostream &os);
+
+/**
+ * @brief Zapisuje liczniki węzłów jako obiekt JSON: {"time": T, "nodes": [{"type": ..., "id": ..., ...}, ...]}
+ */
+void write_node_counters_json(const Factory &f, std::ostream &os);
+
+/**
+ * @brief Zapisuje liczniki węzłów w formacie tekstowym OpenMetrics (rodziny netsim_node_*, etykiety type i id;
+ * liczniki jako counter z przyrostkiem _total, maksymalna głębokość kolejki jako gauge), zakończonym "# EOF".
+ */
+void write_node_counters_openmetrics(const Factory &f, std::ostream &os);
+
+/**
+ * @brief Zapisuje percentyle opóźnień (Factory::set_latency_tracking()) jako CSV
+ * (type,id,metric,count,mean,p50,p99,p999,max; w turach): dla robotników wiersze wait i sojourn, dla magazynów
+ * end_to_end, a na końcu wiersz plant,0,end_to_end z histogramów wszystkich magazynów.
+ * Bez śledzenia zapisuje sam nagłówek.
+ */
+void write_latency_percentiles_csv(const Factory &f, std::ostream &os);
+
+class AsyncTurnReportWriter {
+    /*!
+     * AsyncTurnReportWriter
+     * - raporty tur w formacie generate_simulation_turn_report(), ale formatowane i zapisywane w wątku w tle
+     * - wątek symulacji tylko kopiuje zwięzły stan tury (ID paczek w buforach i kolejkach robotników, nowe paczki
+     *   w magazynach) do jednego z buffered_turns slotów - koszt capture() i rozmiar slotu to O(robotników +
+     *   paczek w kolejkach + paczek przybyłych do magazynów od poprzedniego zrzutu)
+     * - gdy wszystkie sloty czekają na zapis, capture() czeka (backpressure), więc symulacja nie ucieka
+     *   dowolnie daleko przed zapisem; ograniczona jest liczba zaległych zrzutów, nie pamięć wątku zapisu
+     * - magazyny są odtwarzane w wątku zapisu z przyrostów (magazyn tylko przyjmuje paczki), więc koszt
+     *   zrzutu nie rośnie z liczbą zgromadzonych paczek; za to wątek zapisu trzyma kopię ID wszystkich paczek
+     *   w magazynach niezbiorczych (8 B na paczkę), więc jego pamięć to O(zgromadzonych paczek) - tak jak
+     *   samych magazynów; stała jest tylko przy magazynach zbiorczych (tam przechowywany jest sam licznik)
+     * - struktura fabryki nie może się zmieniać, dopóki obiekt istnieje
+     */
+public:
+    /**
+     * @param f - fabryka, której tury będą raportowane
+     * @param os - strumień wyjściowy (używany wyłącznie przez wątek zapisu aż do close())
+     * @param buffered_turns - liczba slotów na zrzuty tur (co najmniej 1; 2 = podwójne buforowanie)
+     */
+    AsyncTurnReportWriter(const Factory &f, std::ostream &os, std::size_t buffered_turns = 2);
+
+    AsyncTurnReportWriter(const AsyncTurnReportWriter &) = delete;
+
+    AsyncTurnReportWriter &operator=(const AsyncTurnReportWriter &) = delete;
+
+    /**
+     * @brief Wywołuje close(); wyjątek wątku zapisu jest w destruktorze pomijany - aby go obsłużyć, wywołaj close()
+     */
+    ~AsyncTurnReportWriter();
+
+    /**
+     * @brief Zapisuje stan fabryki po turze t (wywoływane w wątku symulacji po każdej turze)
+     */
+    void capture(Time t);
+
+    /**
+     * @brief Funkcja raportująca do przekazania do simulate()
+     */
+    std::function<void(Factory &, Time)> reporter() {
+        return [this](Factory &, Time t) { capture(t); };
+    }
+
+    /**
+     * @brief Czeka na zapis wszystkich zrzutów, opróżnia strumień i kończy wątek zapisu.
+     * Rzuca wyjątek, który wystąpił podczas formatowania lub zapisu.
+     */
+    void close();
+
+private:
+    enum class StockMode {
+        APPEND,
+        PREPEND,
+        AGGREGATE,
+        FULL
+    };
+
+    struct Snapshot {
+        Time turn = 0;
+        std::vector<ElementID> values;
+    };
+
+    void write_loop();
+
+    void format(const Snapshot &snapshot);
+
+    std::ostream &os_;
+    std::vector<const Worker *> workers_;
+    std::vector<const Storehouse *> storehouses_;
+    std::vector<StockMode> stock_modes_;
+    // Liczba paczek w magazynie przy poprzednim zrzucie (wątek symulacji).
+    std::vector<std::size_t> captured_stock_;
+    // Odtworzona zawartość magazynów w kolejności przybycia (wątek zapisu) - O(paczek w magazynach niezbiorczych).
+    std::vector<std::vector<ElementID>> stock_mirror_;
+
+    std::vector<Snapshot> slots_;
+    std::size_t head_ = 0;
+    std::size_t filled_ = 0;
+    bool closing_ = false;
+    std::exception_ptr error_;
+    std::mutex mutex_;
+    std::condition_variable slot_filled_;
+    std::condition_variable slot_freed_;
+    std::thread writer_;
+};
+
+#endif //NETSIM_REPORTS_HPP
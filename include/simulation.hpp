@@ -0,0 +1,42 @@
+#ifndef NETSIM_SIMULATION_HPP
+#define NETSIM_SIMULATION_HPP
+
+/**
+ * plik nagłówkowy "simulation.hpp" zawierający funkcję simulate() przeprowadzającą symulację działania fabryki
+*/
+
+#include <functional>
+#include "factory.hpp"
+#include "types.hpp"
+
+enum class SimulationEngine {
+    /**
+     * Każda tura: dostawy, przekazywanie półproduktów, przetwarzanie - na wszystkich węzłach
+     */
+    TURN_BASED,
+    /**
+     * Kolejka priorytetowa najbliższych zdarzeń (dostawy, zakończenia przetwarzania, przekazania z buforów);
+     * tury bez zdarzeń są pomijane, a w turach ze zdarzeniami wywoływane są tylko węzły, których one dotyczą.
+     * Wynik jest identyczny z TURN_BASED.
+     */
+    EVENT_DRIVEN
+};
+
+/**
+ * @brief Przeprowadza symulację przez d tur (od tury 1).
+ * @param f - fabryka (musi być spójna, w przeciwnym razie rzucany jest std::logic_error)
+ * @param d - liczba tur
+ * @param rf - funkcja wywoływana po każdej turze (np. generowanie raportów)
+ * @param engine - silnik symulacji
+ */
+void simulate(Factory &f, TimeOffset d, std::function<void(Factory &, Time)> rf,
+              SimulationEngine engine = SimulationEngine::TURN_BASED);
+
+/**
+ * @brief Kontynuuje symulację przez kolejne d tur: od tury f.get_time() + 1 (np. po Factory::restore_checkpoint()).
+ * Numery tur przekazywane do rf są bezwzględne. Warunki i parametry jak w simulate().
+ */
+void resume_simulation(Factory &f, TimeOffset d, std::function<void(Factory &, Time)> rf,
+                       SimulationEngine engine = SimulationEngine::TURN_BASED);
+
+#endif //NETSIM_SIMULATION_HPP
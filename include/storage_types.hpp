@@ -6,10 +6,13 @@
  * i PackageQueue oraz typu wyliczeniowego PackageQueueType
 */
 
-#include <list>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <vector>
 #include "package.hpp"
 #include "types.hpp"
-#include <cstddef>
 
 enum class PackageQueueType {
     FIFO,
@@ -17,26 +20,124 @@ enum class PackageQueueType {
 };
 
 
+/**
+ * @brief Ciągły fragment pamięci magazynu paczek: [begin, end)
+ */
+struct PackageSpan {
+    const Package *begin = nullptr;
+    const Package *end = nullptr;
+};
+
+/**
+ * Niezmienna kopia zawartości magazynu, współdzielona przez gałęzie fabryki (Factory::fork()).
+ * Paczki nie mają domeny (same identyfikatory); in_domain mówi, które ID należą do domeny właściciela magazynu -
+ * magazyn korzystający z kopii traktuje je tak, jakby trzymał zarejestrowane paczki.
+ */
+struct PackageSnapshot {
+    std::vector<Package> packages;
+    std::vector<std::uint8_t> in_domain;
+    // Tury przybycia (tylko dla PackageLog).
+    std::vector<Time> arrivals;
+};
+
 class IPackageStockpile {
     /*!
      * klasa IPackageStockpile jest klasą abstrakcyjną, która zawiera metody do obsługi magazynu paczek
+     * - zawartość udostępniana jest jako ciąg ciągłych fragmentów (segment()), dzięki czemu iterator
+     *   nie zależy od kontenera, a przejście po fragmencie to zwykłe przesuwanie wskaźnika
      */
 public:
-    using const_iterator = std::list<Package>::const_iterator;
+    /*!
+     * Iterator jednokierunkowy po dowolnym magazynie paczek.
+     * Wywołanie wirtualne segment() następuje tylko na granicy fragmentów.
+     */
+    class const_iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Package;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const Package *;
+        using reference = const Package &;
+
+        const_iterator() = default;
+
+        reference operator*() const { return *pos_; }
+
+        pointer operator->() const { return pos_; }
+
+        const_iterator &operator++() {
+            if (++pos_ == segment_end_) {
+                enter_segment(segment_ + 1);
+            }
+            return *this;
+        }
+
+        const_iterator operator++(int) {
+            const_iterator old = *this;
+            ++(*this);
+            return old;
+        }
+
+        bool operator==(const const_iterator &other) const { return pos_ == other.pos_; }
+
+        bool operator!=(const const_iterator &other) const { return pos_ != other.pos_; }
+
+    private:
+        friend class IPackageStockpile;
+
+        explicit const_iterator(const IPackageStockpile *stockpile) : stockpile_(stockpile) { enter_segment(0); }
+
+        void enter_segment(std::size_t segment);
+
+        const IPackageStockpile *stockpile_ = nullptr;
+        std::size_t segment_ = 0;
+        const Package *pos_ = nullptr;
+        const Package *segment_end_ = nullptr;
+    };
 
     virtual void push(Package &&) = 0;
 
+    /**
+     * @brief Dodaje paczkę, podając turę jej przybycia. Magazyny, które nie zapisują czasu, ignorują turę.
+     * @param t - tura przybycia paczki
+     */
+    virtual void push_at(Package &&p, Time /*t*/) { push(std::move(p)); }
+
     virtual bool empty() const = 0;
 
     virtual size_t size() const = 0;
 
-    virtual const_iterator cbegin() const = 0;
+    /**
+     * @brief Usuwa całą zawartość magazynu (identyfikatory paczek wracają do ich domen)
+     */
+    virtual void clear() = 0;
 
-    virtual const_iterator cend() const = 0;
+    /**
+     * @brief Zwraca fragment zawartości o podanym numerze, w kolejności iteracji.
+     * Fragmenty mogą być puste; numer poza zakresem zwraca pusty fragment.
+     * @param index - numer fragmentu
+     */
+    virtual PackageSpan segment(std::size_t index) const = 0;
 
-    virtual const_iterator begin() const = 0;
+    /**
+     * @brief Liczba fragmentów, które zwraca segment()
+     */
+    virtual std::size_t segment_count() const = 0;
 
-    virtual const_iterator end() const = 0;
+    /**
+     * @brief Domena ID paczki z tego magazynu (nullptr - ID nie jest rejestrowane). Paczki ze współdzielonej
+     * kopii (PackageSnapshot) nie pamiętają domeny - zna ją magazyn.
+     * @param p - paczka udostępniona przez iterator magazynu
+     */
+    virtual const PackageIDAllocator *id_domain(const Package &p) const { return p.get_domain(); }
+
+    const_iterator cbegin() const { return const_iterator(this); }
+
+    const_iterator cend() const { return const_iterator(); }
+
+    const_iterator begin() const { return cbegin(); }
+
+    const_iterator end() const { return cend(); }
 
     virtual ~IPackageStockpile() {};
 };
@@ -62,37 +163,242 @@ class PackageQueue : public IPackageQueue {
      * PackageQueue
      * - klasa dziedzicząca po IPackageQueue
      * - zawiera prywatne pole typu PackageQueueType - określa typ kolejki (FIFO lub LIFO)
-     * - zawiera prywatne pole typu std::list<Package> - przechowuje paczki
-     * - zawiera konstruktor, który przyjmuje jako argument typ kolejki
-     * - zawiera metody push() i pop() - dodają i usuwają elementy z kolejki
+     * - przechowuje paczki w buforze cyklicznym o pojemności będącej potęgą dwójki (bez alokacji na każdą paczkę)
+     * - FIFO dokłada na koniec, LIFO na początek; pop() zawsze zdejmuje z początku - obie operacje O(1)
+     * - gdy bufor się zapełni, jego pojemność jest podwajana (zamortyzowane O(1))
+     * - może zaczynać od współdzielonej, niezmiennej zawartości (PackageSnapshot, copy-on-write przy Factory::fork()):
+     *   nowe paczki trafiają do własnego bufora, a pop() przesuwa tylko pozycję w kopii i tworzy paczkę z jej ID
      * - służy do obsługi kolejek paczek u robotników
      */
 public:
     PackageQueue(PackageQueueType type) : type_(type) {};
 
+    /**
+     * @brief Kolejka zaczynająca od współdzielonej zawartości
+     * @param base - zawartość w kolejności pop()
+     * @param domain - domena ID, do której należą paczki kopii oznaczone w in_domain
+     */
+    PackageQueue(PackageQueueType type, std::shared_ptr<const PackageSnapshot> base, PackageIDAllocator *domain)
+            : type_(type), base_(base && !base->packages.empty() ? std::move(base) : nullptr), base_domain_(domain) {};
+
+    PackageQueue(const PackageQueue &) = delete;
+
+    PackageQueue &operator=(const PackageQueue &) = delete;
+
     void push(Package &&) override;
 
     bool empty() const override;
 
-    size_t size() const override { return queue_.size(); }
+    size_t size() const override { return size_ + base_size(); }
 
-    const_iterator cbegin() const override { return queue_.cbegin(); };
+    void clear() override;
 
-    const_iterator cend() const override { return queue_.cend(); }
+    PackageSpan segment(std::size_t index) const override;
 
-    const_iterator begin() const override { return queue_.cbegin(); }
+    std::size_t segment_count() const override { return 3; }
 
-    const_iterator end() const override { return queue_.cend(); }
+    const PackageIDAllocator *id_domain(const Package &p) const override;
 
     Package pop() override;
 
     PackageQueueType get_queue_type() const override { return type_; };
 
+    /**
+     * @brief Niezmienna kopia zawartości (w kolejności pop()) do współdzielenia między gałęziami fabryki;
+     * kolejka, która sama nie zmieniła współdzielonej zawartości, zwraca ją bez kopiowania
+     * @param domain - domena ID właściciela kolejki (paczki z niej są oznaczane w in_domain)
+     */
+    std::shared_ptr<const PackageSnapshot> snapshot(const PackageIDAllocator &domain) const;
+
     ~PackageQueue() override;
 
 private:
+    void grow();
+
+    std::size_t base_size() const { return base_ ? base_->packages.size() - base_offset_ : 0; }
+
+    Package pop_base();
+
+    void release_base();
+
     PackageQueueType type_;
-    std::list<Package> queue_;
+    Package *buffer_ = nullptr;
+    std::size_t capacity_ = 0;
+    std::size_t head_ = 0;
+    std::size_t size_ = 0;
+    // Współdzielona zawartość: LIFO pobiera ją po własnym buforze, FIFO - przed nim.
+    std::shared_ptr<const PackageSnapshot> base_;
+    std::size_t base_offset_ = 0;
+    PackageIDAllocator *base_domain_ = nullptr;
+};
+
+class PackageLog : public IPackageStockpile {
+    /*!
+     * PackageLog
+     * - magazyn tylko do dopisywania (np. dla Storehouse): paczki trafiają do fragmentów o stałym rozmiarze
+     *   (kChunkSize), które nigdy nie są przenoszone ani realokowane
+     * - dla każdej paczki zapisuje turę przybycia; tury są niemalejące, więc zapytanie
+     *   "co przyszło między turą a i b" to wyszukiwanie binarne
+     * - size() jest O(1), iteracja przebiega po fragmentach od najstarszej paczki
+     * - może zaczynać od współdzielonej, niezmiennej zawartości (PackageSnapshot, Factory::fork()) - jest ona
+     *   traktowana jak najstarsze paczki, a nowe trafiają do własnych fragmentów
+     */
+public:
+    static constexpr std::size_t kChunkSize = 1024;
+
+    /**
+     * @brief Zakres indeksów [first, last) paczek w kolejności przybycia
+     */
+    struct IndexRange {
+        std::size_t first;
+        std::size_t last;
+
+        std::size_t size() const { return last - first; }
+    };
+
+    PackageLog() = default;
+
+    /**
+     * @brief Dziennik zaczynający od współdzielonej zawartości (z turami przybycia)
+     * @param domain - domena ID, do której należą paczki kopii oznaczone w in_domain
+     */
+    PackageLog(std::shared_ptr<const PackageSnapshot> base, PackageIDAllocator *domain);
+
+    PackageLog(const PackageLog &) = delete;
+
+    PackageLog &operator=(const PackageLog &) = delete;
+
+    ~PackageLog() override;
+
+    /**
+     * @brief Dopisuje paczkę z turą przybycia równą ostatniej zapisanej turze
+     */
+    void push(Package &&p) override { push_at(std::move(p), last_arrival_); }
+
+    /**
+     * @brief Dopisuje paczkę. Tura wcześniejsza niż ostatnia zapisana jest traktowana jak ostatnia zapisana,
+     * aby tury pozostały niemalejące.
+     */
+    void push_at(Package &&p, Time t) override;
+
+    bool empty() const override { return size() == 0; }
+
+    size_t size() const override { return base_size() + size_; }
+
+    void clear() override;
+
+    PackageSpan segment(std::size_t index) const override;
+
+    std::size_t segment_count() const override { return chunks_.size() + (base_ ? 1 : 0); }
+
+    const PackageIDAllocator *id_domain(const Package &p) const override;
+
+    const Package &at(std::size_t index) const {
+        const std::size_t shared = base_size();
+        if (index < shared) {
+            return base_->packages[index];
+        }
+        index -= shared;
+        return chunks_[index / kChunkSize].packages[index % kChunkSize];
+    }
+
+    Time arrival_time(std::size_t index) const {
+        const std::size_t shared = base_size();
+        if (index < shared) {
+            return base_->arrivals[index];
+        }
+        index -= shared;
+        return chunks_[index / kChunkSize].arrivals[index % kChunkSize];
+    }
+
+    /**
+     * @brief Niezmienna kopia zawartości (z turami przybycia) do współdzielenia między gałęziami fabryki;
+     * dziennik bez własnych paczek zwraca współdzieloną zawartość bez kopiowania
+     * @param domain - domena ID właściciela dziennika (paczki z niej są oznaczane w in_domain)
+     */
+    std::shared_ptr<const PackageSnapshot> snapshot(const PackageIDAllocator &domain) const;
+
+    /**
+     * @brief Zwraca zakres indeksów paczek, które przybyły w turach [a, b] (włącznie)
+     */
+    IndexRange arrivals_between(Time a, Time b) const;
+
+private:
+    struct Chunk {
+        std::vector<Package> packages;
+        std::vector<Time> arrivals;
+    };
+
+    /**
+     * @brief Indeks pierwszej paczki, która przybyła w turze >= t
+     */
+    std::size_t first_arrival_not_before(Time t) const;
+
+    std::size_t base_size() const { return base_ ? base_->packages.size() : 0; }
+
+    void release_base();
+
+    std::vector<Chunk> chunks_;
+    std::size_t size_ = 0;
+    Time last_arrival_ = 0;
+    std::shared_ptr<const PackageSnapshot> base_;
+    PackageIDAllocator *base_domain_ = nullptr;
+};
+
+class AggregateStockpile : public IPackageStockpile {
+    /*!
+     * AggregateStockpile
+     * - tryb "tylko liczniki" dla Storehouse: paczka jest zliczana i od razu zwalniana (jej ID wraca do domeny)
+     * - prowadzi histogram przybyć w przedziałach o długości interval tur; gdy liczba przedziałów osiągnie
+     *   max_buckets, sąsiednie przedziały są scalane, a długość przedziału podwajana - pamięć nie zależy
+     *   od długości symulacji
+     * - nie przechowuje paczek, więc iteracja jest pusta, a size() zwraca 0
+     */
+public:
+    AggregateStockpile(TimeOffset interval = 1, std::size_t max_buckets = 4096);
+
+    void push(Package &&p) override { push_at(std::move(p), 0); }
+
+    void push_at(Package &&p, Time t) override;
+
+    bool empty() const override { return true; }
+
+    size_t size() const override { return 0; }
+
+    /**
+     * @brief Zeruje licznik i histogram; długość przedziału pozostaje bez zmian
+     */
+    void clear() override;
+
+    PackageSpan segment(std::size_t) const override { return {}; }
+
+    std::size_t segment_count() const override { return 0; }
+
+    /**
+     * @brief Liczba paczek, które dotarły do magazynu
+     */
+    std::size_t get_arrival_count() const { return arrival_count_; }
+
+    /**
+     * @brief Długość przedziału histogramu (w turach); przedział i obejmuje tury [i * interval + 1, (i + 1) * interval]
+     */
+    TimeOffset get_interval() const { return interval_; }
+
+    std::size_t get_max_buckets() const { return max_buckets_; }
+
+    const std::vector<std::size_t> &get_histogram() const { return histogram_; }
+
+    /**
+     * @brief Ustawia stan liczników (przy odtwarzaniu punktu kontrolnego). Histogram nie może mieć
+     * więcej niż max_buckets przedziałów.
+     */
+    void set_state(TimeOffset interval, std::size_t arrival_count, std::vector<std::size_t> histogram);
+
+private:
+    TimeOffset interval_;
+    std::size_t max_buckets_;
+    std::size_t arrival_count_ = 0;
+    std::vector<std::size_t> histogram_;
 };
 
 #endif //NETSIM_STORAGE_TYPES_HPP
\ No newline at end of file
@@ -0,0 +1,65 @@
+#ifndef NETSIM_THREAD_POOL_HPP
+#define NETSIM_THREAD_POOL_HPP
+
+/**
+ * plik nagłówkowy "thread_pool.hpp" zawierający definicję klasy ThreadPool
+*/
+
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class ThreadPool {
+    /*!
+     * ThreadPool
+     * - stała pula wątków tworzona raz (np. na całą symulację), bez tworzenia wątków w każdej turze
+     * - wątek wywołujący również wykonuje pracę, więc pula rozmiaru n ma n - 1 wątków pomocniczych
+     * - run() jest barierą: wraca dopiero, gdy wszystkie fragmenty zostały wykonane;
+     *   pierwszy wyjątek rzucony we fragmencie jest ponownie rzucany w wątku wywołującym
+     */
+public:
+    /**
+     * @param threads - łączna liczba wątków wykonujących pracę (razem z wywołującym), co najmniej 1
+     */
+    explicit ThreadPool(std::size_t threads);
+
+    ThreadPool(const ThreadPool &) = delete;
+
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    ~ThreadPool();
+
+    std::size_t size() const { return helpers_.size() + 1; }
+
+    /**
+     * @brief Wykonuje task(chunk) dla każdego chunk z [0, size()) - każdy fragment na innym wątku
+     */
+    void run(const std::function<void(std::size_t chunk)> &task);
+
+    /**
+     * @brief Dzieli zakres [0, n) na size() ciągłych fragmentów i wykonuje body(begin, end, chunk) dla każdego z nich.
+     * Fragment o numerze c obejmuje [c * n / size(), (c + 1) * n / size()), więc podział zależy tylko od n i size().
+     */
+    void parallel_for(std::size_t n, const std::function<void(std::size_t begin, std::size_t end, std::size_t chunk)> &body);
+
+private:
+    void helper_loop(std::size_t chunk);
+
+    void execute(std::size_t chunk);
+
+    std::vector<std::thread> helpers_;
+    std::mutex mutex_;
+    std::condition_variable work_ready_;
+    std::condition_variable work_done_;
+    const std::function<void(std::size_t)> *task_ = nullptr;
+    std::size_t generation_ = 0;
+    std::size_t pending_ = 0;
+    std::exception_ptr error_;
+    bool stopping_ = false;
+};
+
+#endif //NETSIM_THREAD_POOL_HPP
@@ -0,0 +1,79 @@
+#ifndef NETSIM_TOPOLOGY_GENERATOR_HPP
+#define NETSIM_TOPOLOGY_GENERATOR_HPP
+
+/**
+ * plik nagłówkowy "topology_generator.hpp" zawierający generator syntetycznych struktur fabryki
+ * (w formacie tekstowym wczytywanym przez load_factory_structure())
+*/
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <random>
+#include <string>
+#include "types.hpp"
+
+struct TimeDistribution {
+    /*!
+     * TimeDistribution
+     * - CONSTANT: zawsze a
+     * - UNIFORM: równomiernie z [a, b]
+     * - GEOMETRIC: rozkład geometryczny na {1, 2, ...} o średniej a (długi ogon krótkich i rzadkich długich czasów)
+     */
+    enum class Kind {
+        CONSTANT,
+        UNIFORM,
+        GEOMETRIC
+    };
+
+    Kind kind = Kind::CONSTANT;
+    TimeOffset a = 1;
+    TimeOffset b = 1;
+
+    TimeOffset sample(std::mt19937_64 &rng) const;
+};
+
+/**
+ * @brief Odczytuje rozkład z zapisu "N" (stały), "uniform:A-B" albo "geometric:M" (średnia M).
+ * Wyrzuca std::invalid_argument dla błędnego zapisu lub czasów mniejszych niż 1.
+ */
+TimeDistribution parse_time_distribution(const std::string &spec);
+
+struct TopologyOptions {
+    /*!
+     * TopologyOptions
+     * - robotnicy są dzieleni na `depth` warstw o (prawie) równej liczności; rampy linkują do warstwy 0,
+     *   warstwa i do warstwy i + 1, ostatnia warstwa do magazynów
+     * - fan_out: liczba odbiorców każdego nadawcy w następnej warstwie (nie więcej niż liczność tej warstwy);
+     *   każdy węzeł następnej warstwy ma co najmniej jednego nadawcę
+     * - back_edge_probability: szansa, że robotnik spoza warstwy 0 dostanie dodatkowe połączenie do losowego
+     *   robotnika z wcześniejszej warstwy (cykle w sieci)
+     */
+    std::size_t ramps = 1;
+    std::size_t workers = 8;
+    std::size_t storehouses = 1;
+    std::size_t depth = 4;
+    std::size_t fan_out = 2;
+    double back_edge_probability = 0.0;
+    /**
+     * Szansa, że robotnik ma kolejkę LIFO (w przeciwnym razie FIFO)
+     */
+    double lifo_probability = 0.0;
+    TimeDistribution delivery_interval;
+    TimeDistribution processing_time;
+    std::uint64_t seed = 1;
+};
+
+/**
+ * @brief Zapisuje do os strukturę fabryki opisaną przez options (węzły, potem połączenia nadawca po nadawcy).
+ * Każdy nadawca ma odbiorcę w następnej warstwie, więc wczytana fabryka zawsze spełnia is_consistent().
+ * Wynik zależy tylko od options (także od seed). Pamięć nie zależy od liczby węzłów - struktura
+ * jest zapisywana strumieniowo, bez budowania fabryki.
+ * Wyrzuca std::invalid_argument dla opcji, z których nie da się zbudować spójnej sieci (brak ramp lub magazynów,
+ * depth == 0 albo większe niż liczba robotników, fan_out == 0, prawdopodobieństwa spoza [0, 1]).
+ */
+void generate_factory_structure(const TopologyOptions &options, std::ostream &os);
+
+std::string generate_factory_structure(const TopologyOptions &options);
+
+#endif //NETSIM_TOPOLOGY_GENERATOR_HPP
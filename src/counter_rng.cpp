@@ -0,0 +1,36 @@
+#include "counter_rng.hpp"
+
+namespace {
+    constexpr std::uint32_t kPhiloxM0 = 0xD2511F53;
+    constexpr std::uint32_t kPhiloxM1 = 0xCD9E8D57;
+    constexpr std::uint32_t kPhiloxW0 = 0x9E3779B9;
+    constexpr std::uint32_t kPhiloxW1 = 0xBB67AE85;
+
+    inline void mulhilo(std::uint32_t a, std::uint32_t b, std::uint32_t &hi, std::uint32_t &lo) {
+        std::uint64_t product = static_cast<std::uint64_t>(a) * b;
+        hi = static_cast<std::uint32_t>(product >> 32);
+        lo = static_cast<std::uint32_t>(product);
+    }
+}
+
+std::array<std::uint32_t, 4> philox4x32_10(std::array<std::uint32_t, 4> counter, std::array<std::uint32_t, 2> key) {
+    for (int round = 0; round < 10; ++round) {
+        if (round > 0) {
+            key[0] += kPhiloxW0;
+            key[1] += kPhiloxW1;
+        }
+        std::uint32_t hi0, lo0, hi1, lo1;
+        mulhilo(kPhiloxM0, counter[0], hi0, lo0);
+        mulhilo(kPhiloxM1, counter[2], hi1, lo1);
+        counter = {hi1 ^ counter[1] ^ key[0], lo1, hi0 ^ counter[3] ^ key[1], lo0};
+    }
+    return counter;
+}
+
+double RoutingRandomSource::uniform(std::uint64_t stream, std::uint32_t draw) const {
+    auto turn = static_cast<std::uint32_t>(get_turn());
+    auto bits = philox4x32_10({static_cast<std::uint32_t>(stream), static_cast<std::uint32_t>(stream >> 32), turn, draw},
+                              {static_cast<std::uint32_t>(seed_), static_cast<std::uint32_t>(seed_ >> 32)});
+    std::uint64_t word = (static_cast<std::uint64_t>(bits[0]) << 32) | bits[1];
+    return static_cast<double>(word >> 11) * 0x1.0p-53;
+}
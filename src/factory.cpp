@@ -2,25 +2,39 @@
 // Created by Hyperbook on 15.01.2023.
 //
 
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cmath>
+#include <fstream>
 #include <istream>
+#include <iterator>
+#include <type_traits>
 #include <ostream>
 #include <sstream>
+#include <utility>
 #include "factory.hpp"
+#include "thread_pool.hpp"
 
 template<class Node>
-void NodeCollection<Node>::add(Node &&node) {
+Node &NodeCollection<Node>::add(Node &&node) {
     nodes_.push_back(std::move(node));
+    if (!index_.emplace(nodes_.back().get_id(), std::prev(nodes_.end())).second) {
+        ++duplicates_[nodes_.back().get_id()];
+    }
+    return nodes_.back();
 }
 
-template void NodeCollection<Ramp>::add(Ramp &&ramp);
+template Ramp &NodeCollection<Ramp>::add(Ramp &&ramp);
 
-template void NodeCollection<Worker>::add(Worker &&worker);
+template Worker &NodeCollection<Worker>::add(Worker &&worker);
 
-template void NodeCollection<Storehouse>::add(Storehouse &&sender);
+template Storehouse &NodeCollection<Storehouse>::add(Storehouse &&sender);
 
 template<class Node>
 typename NodeCollection<Node>::iterator NodeCollection<Node>::find_by_id(ElementID id) {
-    return std::find_if(nodes_.begin(), nodes_.end(), [&id](const Node &node) { return node.get_id() == id; });
+    auto it = index_.find(id);
+    return it != index_.end() ? it->second : nodes_.end();
 }
 
 template NodeCollection<Ramp>::iterator NodeCollection<Ramp>::find_by_id(ElementID id);
@@ -31,7 +45,8 @@ template NodeCollection<Storehouse>::iterator NodeCollection<Storehouse>::find_b
 
 template<class Node>
 typename NodeCollection<Node>::const_iterator NodeCollection<Node>::find_by_id(ElementID id) const {
-    return std::find_if(nodes_.begin(), nodes_.end(), [&id](const Node &node) { return node.get_id() == id; });
+    auto it = index_.find(id);
+    return it != index_.end() ? const_iterator(it->second) : nodes_.cend();
 }
 
 template NodeCollection<Ramp>::const_iterator NodeCollection<Ramp>::find_by_id(ElementID id) const;
@@ -42,9 +57,20 @@ template NodeCollection<Storehouse>::const_iterator NodeCollection<Storehouse>::
 
 template<class Node>
 void NodeCollection<Node>::remove_by_id(ElementID id) {
-    auto it = find_by_id(id);
-    if (it != nodes_.end()) {
-        nodes_.erase(it);
+    auto it = index_.find(id);
+    if (it == index_.end()) {
+        return;
+    }
+    nodes_.erase(it->second);
+    index_.erase(it);
+    auto duplicate_count = duplicates_.find(id);
+    if (duplicate_count != duplicates_.end()) {
+        // Usuwany ID jest powtórzony - kolejny węzeł o tym ID przejmuje wpis w indeksie.
+        auto duplicate = std::find_if(nodes_.begin(), nodes_.end(), [&id](const Node &node) { return node.get_id() == id; });
+        index_.emplace(id, duplicate);
+        if (--duplicate_count->second == 0) {
+            duplicates_.erase(duplicate_count);
+        }
     }
 }
 
@@ -54,107 +80,645 @@ template void NodeCollection<Worker>::remove_by_id(ElementID id);
 
 template void NodeCollection<Storehouse>::remove_by_id(ElementID id);
 
-template<class Node>
-void Factory::remove_receiver(NodeCollection<Node> &collection, ElementID id) {
-    auto removed = collection.find_by_id(id);
-    IPackageReceiver *receiver = dynamic_cast<IPackageReceiver *>(&(*removed));
-    for (auto &worker: workers_) {
-        worker.receiver_preferences_.remove_receiver(receiver);
+struct Factory::ParallelState {
+    explicit ParallelState(std::size_t threads) : pool(threads) {}
+
+    ThreadPool pool;
+    // Wektory węzłów w kolejności list fabryki (odświeżane po zmianie struktury).
+    bool node_cache_valid = false;
+    std::vector<Worker *> workers;
+    std::vector<PackageSender *> senders;
+    // Odbiorca -> wątek, który zatwierdza przekazywane mu paczki.
+    std::unordered_map<const IPackageReceiver *, std::size_t> receiver_owner;
+    // Bufory robocze tur - alokowane raz, czyszczone po każdej fazie.
+    std::vector<IPackageReceiver *> chosen;
+    std::vector<std::vector<std::size_t>> buckets;
+};
+
+Factory::Factory() = default;
+
+// Źródło dostaje nową domenę ID, zegar i indeks połączeń, więc po przeniesieniu pozostaje pustą fabryką.
+Factory::Factory(Factory &&factory) noexcept
+        : package_ids_(std::exchange(factory.package_ids_, std::make_unique<PackageIDAllocator>())),
+          time_(std::exchange(factory.time_, std::make_unique<Time>(0))),
+          links_(std::exchange(factory.links_, std::make_unique<LinkIndex>())),
+          routing_(std::move(factory.routing_)),
+          ramps_(std::move(factory.ramps_)),
+          workers_(std::move(factory.workers_)),
+          storehouses_(std::move(factory.storehouses_)),
+          parallel_(std::move(factory.parallel_)),
+          counters_(std::move(factory.counters_)),
+          free_counters_(std::move(factory.free_counters_)),
+          lifecycle_(std::move(factory.lifecycle_)) {}
+
+Factory::~Factory() = default;
+
+Factory &Factory::operator=(Factory &&factory) noexcept {
+    if (this != &factory) {
+        // Najpierw węzły - paczki w kolejkach oddają ID do starej domeny, która jeszcze istnieje.
+        ramps_ = std::move(factory.ramps_);
+        workers_ = std::move(factory.workers_);
+        storehouses_ = std::move(factory.storehouses_);
+        package_ids_ = std::exchange(factory.package_ids_, std::make_unique<PackageIDAllocator>());
+        time_ = std::exchange(factory.time_, std::make_unique<Time>(0));
+        links_ = std::exchange(factory.links_, std::make_unique<LinkIndex>());
+        routing_ = std::move(factory.routing_);
+        parallel_ = std::move(factory.parallel_);
+        counters_ = std::move(factory.counters_);
+        free_counters_ = std::move(factory.free_counters_);
+        lifecycle_ = std::move(factory.lifecycle_);
     }
-    for (auto &ramp: ramps_) {
-        ramp.receiver_preferences_.remove_receiver(receiver);
+    return *this;
+}
+
+void Factory::set_thread_count(std::size_t threads) {
+    if (threads <= 1) {
+        parallel_.reset();
+    } else if (get_thread_count() != threads) {
+        parallel_ = std::make_unique<ParallelState>(threads);
     }
-    collection.remove_by_id(id);
 }
 
-template void Factory::remove_receiver(NodeCollection<Worker> &collection, ElementID id);
+std::size_t Factory::get_thread_count() const {
+    return parallel_ ? parallel_->pool.size() : 1;
+}
 
-template void Factory::remove_receiver(NodeCollection<Storehouse> &collection, ElementID id);
+namespace {
+    // Rampy i robotnicy mają osobne przestrzenie ID, więc typ nadawcy jest częścią klucza strumienia.
+    constexpr std::uint64_t kRampStream = 0;
+    constexpr std::uint64_t kWorkerStream = 1;
 
+    std::uint64_t routing_stream(std::uint64_t sender_type, ElementID id) {
+        return (sender_type << 32) | static_cast<std::uint32_t>(id);
+    }
+}
 
-void Factory::do_deliveries(Time t) {
+void Factory::set_routing_seed(std::uint64_t seed) {
+    if (routing_) {
+        routing_->set_seed(seed);
+        return;
+    }
+    routing_ = std::make_unique<RoutingRandomSource>(seed, time_.get());
     for (auto &ramp: ramps_) {
-        ramp.deliver_goods(t);
+        attach_random_source(ramp);
+    }
+    for (auto &worker: workers_) {
+        attach_random_source(worker);
     }
 }
 
-void Factory::do_work(Time t) {
+std::optional<std::uint64_t> Factory::get_routing_seed() const {
+    return routing_ ? std::optional<std::uint64_t>(routing_->get_seed()) : std::nullopt;
+}
+
+void Factory::attach_random_source(Ramp &ramp) {
+    if (routing_) {
+        ramp.receiver_preferences_.set_random_source(routing_.get(), routing_stream(kRampStream, ramp.get_id()));
+    }
+}
+
+void Factory::attach_random_source(Worker &worker) {
+    if (routing_) {
+        worker.receiver_preferences_.set_random_source(routing_.get(), routing_stream(kWorkerStream, worker.get_id()));
+    }
+}
+
+void Factory::reserve_counters(std::size_t count) {
+#if NETSIM_NODE_COUNTERS
+    if (count <= counters_.capacity()) {
+        return;
+    }
+    std::vector<NodeCounters> grown;
+    grown.reserve(count);
+    grown.assign(counters_.begin(), counters_.end());
+    auto rebind = [this, &grown](auto &node) {
+        if (node.get_counters() != nullptr) {
+            node.set_counters(grown.data() + (node.get_counters() - counters_.data()));
+        }
+    };
+    std::for_each(ramps_.begin(), ramps_.end(), rebind);
+    std::for_each(workers_.begin(), workers_.end(), rebind);
+    std::for_each(storehouses_.begin(), storehouses_.end(), rebind);
+    counters_.swap(grown);
+#else
+    (void) count;
+#endif
+}
+
+std::vector<NodeCounterRecord> Factory::get_node_counters() const {
+    std::vector<NodeCounterRecord> records;
+#if NETSIM_NODE_COUNTERS
+    const Time now = *time_;
+    records.reserve(counters_.size() - free_counters_.size());
+    auto add = [&records](ElementType type, ElementID id, const NodeCounters *counters) -> NodeCounterRecord & {
+        records.push_back({type, id, counters != nullptr ? *counters : NodeCounters(), 0});
+        return records.back();
+    };
+    for (const auto &ramp: ramps_) {
+        add(ElementType::RAMP, ramp.get_id(), ramp.get_counters());
+    }
+    for (const auto &worker: workers_) {
+        NodeCounterRecord &record = add(ElementType::WORKER, worker.get_id(), worker.get_counters());
+        NodeCounters &counters = record.counters;
+        if (worker.get_processing_buffer().has_value()) {
+            Time start = std::max(worker.get_package_processing_start_time(), counters.since + 1);
+            counters.busy_turns += static_cast<std::uint64_t>(std::max(0, now - start + 1));
+        }
+        const auto observed = static_cast<std::uint64_t>(std::max(0, now - counters.since));
+        record.idle_turns = observed > counters.busy_turns ? observed - counters.busy_turns : 0;
+    }
+    for (const auto &storehouse: storehouses_) {
+        add(ElementType::STOREHOUSE, storehouse.get_id(), storehouse.get_counters());
+    }
+#endif
+    return records;
+}
+
+void Factory::set_latency_tracking(bool enabled) {
+    if (enabled == is_latency_tracking_enabled()) {
+        return;
+    }
+    std::unique_ptr<PackageLifecycleTracker> tracker =
+            enabled ? std::make_unique<PackageLifecycleTracker>(time_.get()) : nullptr;
+    for (auto &ramp: ramps_) {
+        ramp.set_lifecycle_tracker(tracker.get());
+    }
     for (auto &worker: workers_) {
-        worker.do_work(t);
+        worker.set_lifecycle_tracker(tracker.get());
+    }
+    for (auto &storehouse: storehouses_) {
+        storehouse.set_lifecycle_tracker(tracker.get());
     }
+    lifecycle_ = std::move(tracker);
 }
 
-void Factory::do_package_passing() {
+void Factory::reset_node_counters() {
+    for (NodeCounters &counters: counters_) {
+        counters = NodeCounters();
+        counters.since = *time_;
+    }
+}
+
+void Factory::invalidate_node_cache() {
+    if (parallel_) {
+        parallel_->node_cache_valid = false;
+    }
+}
+
+Factory::ParallelState &Factory::parallel_state() {
+    ParallelState &state = *parallel_;
+    if (state.node_cache_valid) {
+        return state;
+    }
+    state.workers.clear();
+    state.senders.clear();
+    state.receiver_owner.clear();
     for (auto &ramp: ramps_) {
-        ramp.send_package();
+        state.senders.push_back(&ramp);
     }
+    const std::size_t threads = state.pool.size();
+    std::size_t next_owner = 0;
     for (auto &worker: workers_) {
-        worker.send_package();
+        state.workers.push_back(&worker);
+        state.senders.push_back(&worker);
+        state.receiver_owner.emplace(&worker, next_owner++ % threads);
+    }
+    for (auto &storehouse: storehouses_) {
+        // Magazyn zbiorczy zwalnia ID paczek we wspólnej domenie - wszystkie takie magazyny obsługuje jeden wątek.
+        state.receiver_owner.emplace(&storehouse, storehouse.is_aggregate() ? 0 : next_owner++ % threads);
     }
+    state.buckets.assign(threads * threads, {});
+    state.node_cache_valid = true;
+    return state;
 }
 
-enum class NodeState {
-    kNotVisited,
-    kVisited,
-    kFinished
-};
+void LinkIndex::on_link_added(PackageSender *sender, IPackageReceiver *receiver) {
+    senders_[receiver].push_back(sender);
+    touched_.push_back(sender);
+    status_valid_ = false;
+}
 
-bool is_storehouse_achievable(const PackageSender *node, std::map<const PackageSender *, NodeState> &node_states) {
-    if (node_states[node] == NodeState::kFinished) {
-        return true;
+void LinkIndex::on_link_removed(PackageSender *sender, IPackageReceiver *receiver) {
+    touched_.push_back(sender);
+    // Odbiorca nie jest już osiągalny przez tego nadawcę - jego obszar też trzeba sprawdzić.
+    touched_receivers_.push_back(receiver);
+    status_valid_ = false;
+
+    auto it = senders_.find(receiver);
+    if (it == senders_.end()) {
+        return;
+    }
+    auto &senders = it->second;
+    auto position = std::find(senders.begin(), senders.end(), sender);
+    if (position != senders.end()) {
+        *position = senders.back();
+        senders.pop_back();
+    }
+    if (senders.empty()) {
+        senders_.erase(it);
     }
-    node_states[node] = NodeState::kVisited;
+}
 
-    if (node->receiver_preferences_.get_preferences().empty()) {
-        throw std::logic_error("No receivers");
+void LinkIndex::attach(PackageSender &sender, const IPackageReceiver *self) {
+    states_[&sender].self = self;
+    if (self != nullptr) {
+        receiver_senders_[self] = &sender;
+    }
+    touched_.push_back(&sender);
+    status_valid_ = false;
+    sender.receiver_preferences_.set_link_observer(this, &sender);
+    for (const auto &pref: sender.receiver_preferences_) {
+        on_link_added(&sender, pref.first);
     }
+}
 
-    bool has_receiver = false;
-    for (auto &receiver: node->receiver_preferences_.get_preferences()) {
-        if (receiver.first->get_receiver_type() == ReceiverType::STOREHOUSE) {
-            has_receiver = true;
-        } else if (receiver.first->get_receiver_type() == ReceiverType::WORKER) {
-            IPackageReceiver *receiver_ptr = receiver.first;
-            auto worker_ptr = dynamic_cast<Worker *>(receiver_ptr);
-            auto sendrecv_ptr = dynamic_cast<PackageSender *>(worker_ptr);
-            if (sendrecv_ptr == node) {
-                continue;
+void LinkIndex::detach(PackageSender &sender) {
+    for (const auto &pref: sender.receiver_preferences_) {
+        on_link_removed(&sender, pref.first);
+    }
+    sender.receiver_preferences_.set_link_observer(nullptr, nullptr);
+    auto state = states_.find(&sender);
+    if (state != states_.end()) {
+        if (state->second.unlinked) {
+            set_ramp_upstream(state->second, false);
+            --unlinked_count_;
+        }
+        if (state->second.self != nullptr) {
+            receiver_senders_.erase(state->second.self);
+        }
+        states_.erase(state);
+    }
+    status_valid_ = false;
+}
+
+void LinkIndex::update_linked(const PackageSender *sender, SenderState &state) const {
+    const auto &preferences = sender->receiver_preferences_;
+    const bool unlinked = std::none_of(preferences.cbegin(), preferences.cend(),
+                                       [&state](const auto &pref) { return pref.first != state.self; });
+    if (unlinked == state.unlinked) {
+        return;
+    }
+    if (state.unlinked) {
+        set_ramp_upstream(state, false);
+        --unlinked_count_;
+    } else {
+        ++unlinked_count_;
+    }
+    state.unlinked = unlinked;
+}
+
+void LinkIndex::set_ramp_upstream(SenderState &state, bool ramp_upstream) const {
+    if (state.ramp_upstream != ramp_upstream) {
+        state.ramp_upstream = ramp_upstream;
+        ramp_upstream ? ++reached_count_ : --reached_count_;
+    }
+}
+
+bool LinkIndex::is_consistent() const {
+    if (status_valid_) {
+        return reached_count_ == 0;
+    }
+    // Wpisy w touched_ mogą wskazywać nadawców już odpiętych - tylko obecni w states_ są odczytywani.
+    for (const PackageSender *sender: touched_) {
+        auto state = states_.find(sender);
+        if (state != states_.end()) {
+            update_linked(sender, state->second);
+        }
+    }
+    if (unlinked_count_ != 0) {
+        // Osiągalność z rampy może się zmienić tylko w obszarze, do którego prowadzą zmienieni nadawcy
+        // i odbiorcy odpiętych linków - przejście w przód zbiera z niego nadawców bez odbiorców.
+        const std::uint64_t forward = ++search_;
+        stack_.clear();
+        auto push = [this, forward](const PackageSender *sender) {
+            auto state = states_.find(sender);
+            if (state != states_.end() && state->second.visited != forward) {
+                state->second.visited = forward;
+                stack_.push_back(sender);
+            }
+        };
+        for (const PackageSender *sender: touched_) {
+            push(sender);
+        }
+        for (const IPackageReceiver *receiver: touched_receivers_) {
+            auto sender = receiver_senders_.find(receiver);
+            if (sender != receiver_senders_.end()) {
+                push(sender->second);
             }
-            has_receiver = true;
-            if (node_states[sendrecv_ptr] == NodeState::kNotVisited) {
-                is_storehouse_achievable(sendrecv_ptr, node_states);
+        }
+        affected_.clear();
+        while (!stack_.empty()) {
+            const PackageSender *sender = stack_.back();
+            stack_.pop_back();
+            if (states_.at(sender).unlinked) {
+                affected_.push_back(sender);
             }
+            for (const auto &pref: sender->receiver_preferences_) {
+                auto downstream = receiver_senders_.find(pref.first);
+                if (downstream != receiver_senders_.end()) {
+                    push(downstream->second);
+                }
+            }
+        }
+        ++query_;
+        for (const PackageSender *sender: affected_) {
+            set_ramp_upstream(states_.at(sender), has_ramp_upstream(sender));
         }
     }
+    touched_.clear();
+    touched_receivers_.clear();
+    status_valid_ = true;
+    return reached_count_ == 0;
+}
+
+bool LinkIndex::has_ramp_upstream(const PackageSender *start) const {
+    // Przeszukiwanie wstecz (odbiorca -> nadawcy); dojście do rampy oznacza, że `start` jest osiągalny z rampy.
+    // Pętle własne nie są krawędziami. Nadawcy odwiedzeni przez nieudane przeszukiwanie w tym samym pytaniu
+    // też nie są osiągalni z rampy, więc kolejne przeszukiwania ich nie rozwijają.
+    const std::uint64_t search = ++search_;
+    stack_.clear();
+    visited_.clear();
+    stack_.push_back(start);
+    states_.at(start).visited = search;
+    while (!stack_.empty()) {
+        const PackageSender *sender = stack_.back();
+        stack_.pop_back();
+        const SenderState &state = states_.at(sender);
+        if (state.self == nullptr) {
+            return true;
+        }
+        visited_.push_back(sender);
+        if (state.no_ramp == query_) {
+            continue;
+        }
+        for (const PackageSender *upstream: get_senders(state.self)) {
+            SenderState &upstream_state = states_.at(upstream);
+            if (upstream != sender && upstream_state.visited != search) {
+                upstream_state.visited = search;
+                stack_.push_back(upstream);
+            }
+        }
+    }
+    for (const PackageSender *sender: visited_) {
+        states_.at(sender).no_ramp = query_;
+    }
+    return false;
+}
 
-    node_states[node] = NodeState::kFinished;
+const std::vector<PackageSender *> &LinkIndex::get_senders(const IPackageReceiver *receiver) const {
+    static const std::vector<PackageSender *> no_senders;
+    auto it = senders_.find(receiver);
+    return it != senders_.end() ? it->second : no_senders;
+}
 
-    if (!has_receiver) {
-        throw std::logic_error("No receiver");
+void Factory::remove_ramp(ElementID id) {
+    auto removed = ramps_.find_by_id(id);
+    if (removed == ramps_.end()) {
+        return;
     }
-    return true;
+    links_->detach(*removed);
+    release_counters(*removed);
+    ramps_.remove_by_id(id);
+    invalidate_node_cache();
 }
 
-bool Factory::is_consistent() const {
-    std::map<const PackageSender *, NodeState> node_states;
+template<class Node>
+void Factory::remove_receiver(NodeCollection<Node> &collection, ElementID id) {
+    auto removed = collection.find_by_id(id);
+    if (removed == collection.end()) {
+        return;
+    }
+    IPackageReceiver *receiver = &(*removed);
+    // Kopia - remove_receiver() aktualizuje indeks w trakcie pętli.
+    std::vector<PackageSender *> senders = links_->get_senders(receiver);
+    for (PackageSender *sender: senders) {
+        sender->receiver_preferences_.remove_receiver(receiver);
+    }
+    links_->forget_receiver(receiver);
+    if constexpr (std::is_base_of_v<PackageSender, Node>) {
+        links_->detach(*removed);
+    }
+    release_counters(*removed);
+    collection.remove_by_id(id);
+    invalidate_node_cache();
+}
 
-    for (const PackageSender &ramp: ramps_) {
-        node_states[&ramp] = NodeState::kNotVisited;
+template void Factory::remove_receiver(NodeCollection<Worker> &collection, ElementID id);
+
+template void Factory::remove_receiver(NodeCollection<Storehouse> &collection, ElementID id);
+
+
+void Factory::do_deliveries(Time t) {
+    *time_ = t;
+    // Dostawy są szeregowe także w trybie równoległym: przydział ID musi iść w kolejności ramp (domena zwraca
+    // najmniejszy wolny ID), a poza nim dostawa to jedno porównanie i przeniesienie paczki - rozdzielenie tego
+    // na wątki kosztowałoby więcej (zlecenie zadań puli i bariera w każdej turze), niż by dało.
+    for (auto &ramp: ramps_) {
+        ramp.deliver_goods(t);
     }
+}
 
-    for (const PackageSender &worker: workers_) {
-        node_states[&worker] = NodeState::kNotVisited;
+void Factory::do_work(Time t) {
+    *time_ = t;
+    if (!parallel_) {
+        for (auto &worker: workers_) {
+            worker.do_work(t);
+        }
+        return;
     }
+    ParallelState &state = parallel_state();
+    state.pool.parallel_for(state.workers.size(), [&state, t](std::size_t begin, std::size_t end, std::size_t) {
+        for (std::size_t i = begin; i < end; ++i) {
+            state.workers[i]->do_work(t);
+        }
+    });
+}
 
-    try {
-        for (const PackageSender &ramp: ramps_) {
-            is_storehouse_achievable(&ramp, node_states);
+void Factory::do_package_passing() {
+    if (!parallel_) {
+        for (auto &ramp: ramps_) {
+            ramp.send_package();
+        }
+        for (auto &worker: workers_) {
+            worker.send_package();
         }
+        return;
     }
-    catch (...) {
-        return false;
+    ParallelState &state = parallel_state();
+    const std::size_t threads = state.pool.size();
+
+    // Zebranie: wybór odbiorców, potem rozdział przesyłek według wątku odbiorcy. Wspólny generator wymusza
+    // losowanie w kolejności szeregowej; strumienie licznikowe (set_routing_seed()) można losować równolegle.
+    const bool parallel_choice = routing_ != nullptr;
+    state.chosen.assign(state.senders.size(), nullptr);
+    if (!parallel_choice) {
+        for (std::size_t i = 0; i < state.senders.size(); ++i) {
+            PackageSender &sender = *state.senders[i];
+            if (sender.get_sending_buffer().has_value()) {
+                state.chosen[i] = sender.receiver_preferences_.choose_receiver();
+            }
+        }
     }
-    return true;
+    state.pool.parallel_for(state.senders.size(), [&state, threads, parallel_choice](std::size_t begin, std::size_t end,
+                                                                                    std::size_t chunk) {
+        for (std::size_t i = begin; i < end; ++i) {
+            if (parallel_choice && state.senders[i]->get_sending_buffer().has_value()) {
+                state.chosen[i] = state.senders[i]->receiver_preferences_.choose_receiver();
+            }
+            if (state.chosen[i] == nullptr) {
+                continue;
+            }
+            auto owner = state.receiver_owner.find(state.chosen[i]);
+            std::size_t thread = owner != state.receiver_owner.end() ? owner->second : 0;
+            state.buckets[chunk * threads + thread].push_back(i);
+        }
+    });
+
+    // Zatwierdzenie: fragmenty nadawców są rozłączne i uporządkowane, więc przejście po nich w kolejności
+    // odtwarza kolejność szeregową dla każdego odbiorcy.
+    state.pool.run([&state, threads](std::size_t thread) {
+        for (std::size_t chunk = 0; chunk < threads; ++chunk) {
+            auto &bucket = state.buckets[chunk * threads + thread];
+            for (std::size_t i: bucket) {
+                state.senders[i]->send_package_to(state.chosen[i]);
+            }
+            bucket.clear();
+        }
+    });
+}
+
+namespace {
+    class ReceiverIndex {
+        /*!
+         * ReceiverIndex
+         * - płaska tablica z adresowaniem otwartym (sondowanie liniowe): adres odbiorcy -> gęsty indeks
+         * - budowana raz na jedno przejście po sieci; w przeciwieństwie do std::unordered_map bez osobnej
+         *   alokacji na każdy wpis
+         */
+    public:
+        static constexpr std::size_t kMissing = ~std::size_t(0);
+
+        explicit ReceiverIndex(std::size_t count) {
+            std::size_t capacity = 16;
+            while (capacity < 2 * count) {
+                capacity *= 2;
+            }
+            slots_.assign(capacity, {nullptr, kMissing});
+            mask_ = capacity - 1;
+        }
+
+        void insert(const IPackageReceiver *receiver, std::size_t index) {
+            std::size_t slot = hash(receiver);
+            while (slots_[slot].first != nullptr && slots_[slot].first != receiver) {
+                slot = (slot + 1) & mask_;
+            }
+            if (slots_[slot].first == nullptr) {
+                slots_[slot] = {receiver, index};
+            }
+        }
+
+        std::size_t find(const IPackageReceiver *receiver) const {
+            for (std::size_t slot = hash(receiver);; slot = (slot + 1) & mask_) {
+                if (slots_[slot].first == receiver) {
+                    return slots_[slot].second;
+                }
+                if (slots_[slot].first == nullptr) {
+                    return kMissing;
+                }
+            }
+        }
+
+    private:
+        std::size_t hash(const IPackageReceiver *receiver) const {
+            // Mnożenie Fibonacciego - rozprasza adresy wyrównane do rozmiaru węzła listy.
+            auto key = static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(receiver));
+            return static_cast<std::size_t>((key * 0x9E3779B97F4A7C15ULL) >> 32) & mask_;
+        }
+
+        std::vector<std::pair<const IPackageReceiver *, std::size_t>> slots_;
+        std::size_t mask_ = 0;
+    };
+}
+
+bool Factory::check_consistency(std::vector<InconsistentNode> *failures) const {
+    // Gęste indeksy nadawców: rampy [0, R), robotnicy [R, R + W) w kolejności list.
+    std::vector<const PackageSender *> senders;
+    senders.reserve(ramps_.size() + workers_.size());
+    for (const Ramp &ramp: ramps_) {
+        senders.push_back(&ramp);
+    }
+    const std::size_t ramp_count = senders.size();
+    for (const Worker &worker: workers_) {
+        senders.push_back(&worker);
+    }
+    ReceiverIndex worker_index(senders.size() - ramp_count);
+    for (std::size_t i = ramp_count; i < senders.size(); ++i) {
+        worker_index.insert(static_cast<const Worker *>(senders[i]), i);
+    }
+
+    // Faza 1 (sekwencyjnie, w kolejności list): krawędzie do robotników tej fabryki w postaci CSR
+    // oraz flaga, czy nadawca ma odbiorcę innego niż on sam. Pętla własna nie jest krawędzią.
+    std::vector<std::uint32_t> edge_offsets(senders.size() + 1, 0);
+    std::vector<std::uint32_t> edges;
+    std::vector<char> has_receiver(senders.size(), 0);
+    for (std::size_t node = 0; node < senders.size(); ++node) {
+        for (const auto &pref: senders[node]->receiver_preferences_) {
+            // Najpierw indeks - dla robotników nie trzeba sięgać do obiektu odbiorcy.
+            const std::size_t index = worker_index.find(pref.first);
+            if (index == ReceiverIndex::kMissing) {
+                // Magazyn albo robotnik spoza tej fabryki (odbiorca, którego nie da się przejść dalej).
+                has_receiver[node] = 1;
+            } else if (index != node) {
+                has_receiver[node] = 1;
+                edges.push_back(static_cast<std::uint32_t>(index));
+            }
+        }
+        edge_offsets[node + 1] = static_cast<std::uint32_t>(edges.size());
+    }
+
+    // Faza 2: przejście z jawnym stosem po tablicach CSR. Warunek jest lokalny dla nadawcy, więc wystarczy
+    // odwiedzić każdy osiągalny węzeł raz - bez stanu "w toku".
+    std::vector<char> visited(senders.size(), 0);
+    std::vector<std::uint32_t> stack;
+    bool consistent = true;
+    for (std::size_t root = 0; root < ramp_count; ++root) {
+        visited[root] = 1;
+        stack.push_back(static_cast<std::uint32_t>(root));
+        while (!stack.empty()) {
+            const std::size_t node = stack.back();
+            stack.pop_back();
+            for (std::uint32_t e = edge_offsets[node]; e < edge_offsets[node + 1]; ++e) {
+                if (!visited[edges[e]]) {
+                    visited[edges[e]] = 1;
+                    stack.push_back(edges[e]);
+                }
+            }
+            if (has_receiver[node]) {
+                continue;
+            }
+            consistent = false;
+            if (failures == nullptr) {
+                return false;
+            }
+            const PackageSender *sender = senders[node];
+            const bool is_ramp = node < ramp_count;
+            failures->push_back({is_ramp ? ElementType::RAMP : ElementType::WORKER,
+                                 is_ramp ? static_cast<const Ramp *>(sender)->get_id()
+                                         : static_cast<const Worker *>(sender)->get_id(),
+                                 sender->receiver_preferences_.get_preferences().empty()
+                                 ? InconsistentNode::Reason::NO_RECEIVERS : InconsistentNode::Reason::SELF_LINK_ONLY});
+        }
+    }
+    return consistent;
+}
+
+std::vector<InconsistentNode> Factory::find_inconsistent_nodes() const {
+    std::vector<InconsistentNode> failures;
+    check_consistency(&failures);
+    std::sort(failures.begin(), failures.end(), [](const InconsistentNode &a, const InconsistentNode &b) {
+        return std::make_pair(a.type, a.id) < std::make_pair(b.type, b.id);
+    });
+    return failures;
 }
 
 
@@ -190,259 +754,631 @@ ParsedLineData parse_line(const std::string &line) {
     return data;
 }
 
-Factory load_factory_structure(std::istream &is) {
+namespace {
+    /**
+     * Rekord jednej linii pliku struktury - stałe pola zamiast mapy klucz -> wartość.
+     */
+    struct NodeRef {
+        ElementType type = ElementType::RAMP;
+        ElementID id = 0;
+    };
+
+    struct StructureRecord {
+        ElementType type = ElementType::RAMP;
+        ElementID id = 0;
+        // delivery-interval (rampa) albo processing-time (robotnik)
+        TimeOffset interval = 0;
+        PackageQueueType queue_type = PackageQueueType::FIFO;
+        NodeRef src;
+        NodeRef dest;
+        // opcjonalne p= linku; bez niego nadawca dzieli prawdopodobieństwo równo między odbiorców
+        double probability = 0.0;
+        bool has_probability = false;
+    };
+
+    [[noreturn]] void throw_parse_error(std::size_t line_number, const std::string &message) {
+        throw std::logic_error("line " + std::to_string(line_number) + ": " + message);
+    }
+
+    bool is_separator(char c) {
+        return c == ' ' || c == '\t' || c == '\r';
+    }
+
+    /**
+     * Zwraca kolejny token (ciąg znaków bez białych znaków) i przesuwa początek `rest` za niego.
+     */
+    std::string_view next_token(std::string_view &rest) {
+        std::size_t begin = 0;
+        while (begin < rest.size() && is_separator(rest[begin])) {
+            ++begin;
+        }
+        std::size_t end = begin;
+        while (end < rest.size() && !is_separator(rest[end])) {
+            ++end;
+        }
+        std::string_view token = rest.substr(begin, end - begin);
+        rest.remove_prefix(end);
+        return token;
+    }
+
+    int parse_int(std::string_view value, std::size_t line_number, std::string_view key) {
+        int result = 0;
+        auto [ptr, ec] = std::from_chars(value.data(), value.data() + value.size(), result);
+        if (ec != std::errc() || ptr != value.data() + value.size()) {
+            throw_parse_error(line_number, "invalid value of '" + std::string(key) + "': " + std::string(value));
+        }
+        return result;
+    }
+
+    double parse_probability(std::string_view value, std::size_t line_number) {
+        double result = 0.0;
+        auto [ptr, ec] = std::from_chars(value.data(), value.data() + value.size(), result);
+        if (ec != std::errc() || ptr != value.data() + value.size() || !(result > 0.0 && result <= 1.0)) {
+            throw_parse_error(line_number, "invalid value of 'p': " + std::string(value));
+        }
+        return result;
+    }
+
+    NodeRef parse_node_ref(std::string_view value, std::size_t line_number, std::string_view key) {
+        std::size_t dash = value.find('-');
+        std::string_view type = value.substr(0, dash);
+        NodeRef ref;
+        if (type == "ramp") {
+            ref.type = ElementType::RAMP;
+        } else if (type == "worker") {
+            ref.type = ElementType::WORKER;
+        } else if (type == "store") {
+            ref.type = ElementType::STOREHOUSE;
+        } else {
+            throw_parse_error(line_number, "unknown node type in '" + std::string(key) + "': " + std::string(value));
+        }
+        if (dash == std::string_view::npos) {
+            throw_parse_error(line_number, "missing node id in '" + std::string(key) + "': " + std::string(value));
+        }
+        ref.id = parse_int(value.substr(dash + 1), line_number, key);
+        return ref;
+    }
+
+    StructureRecord parse_record(std::string_view line, std::size_t line_number) {
+        StructureRecord record;
+        std::string_view tag = next_token(line);
+        if (tag == "LOADING_RAMP") {
+            record.type = ElementType::RAMP;
+        } else if (tag == "WORKER") {
+            record.type = ElementType::WORKER;
+        } else if (tag == "STOREHOUSE") {
+            record.type = ElementType::STOREHOUSE;
+        } else if (tag == "LINK") {
+            record.type = ElementType::LINK;
+        } else {
+            throw_parse_error(line_number, "unknown tag: " + std::string(tag));
+        }
+
+        // Bit i = i-te pole z REQUIRED_FIELDS danego typu; powtórzony klucz - obowiązuje pierwsze wystąpienie.
+        const auto &required = REQUIRED_FIELDS.at(record.type);
+        unsigned seen = 0;
+        for (std::string_view token = next_token(line); !token.empty(); token = next_token(line)) {
+            std::size_t eq = token.find('=');
+            if (eq == 0 || eq == std::string_view::npos || eq + 1 == token.size()) {
+                throw_parse_error(line_number, "empty key or value: " + std::string(token));
+            }
+            std::string_view key = token.substr(0, eq);
+            std::string_view value = token.substr(eq + 1);
+            if (record.type == ElementType::LINK && key == "p") {
+                if (!record.has_probability) {
+                    record.probability = parse_probability(value, line_number);
+                    record.has_probability = true;
+                }
+                continue;
+            }
+            std::size_t field = 0;
+            while (field < required.size() && required[field] != key) {
+                ++field;
+            }
+            if (field == required.size()) {
+                throw_parse_error(line_number, "unknown key: " + std::string(key));
+            }
+            if (seen & (1U << field)) {
+                continue;
+            }
+            seen |= 1U << field;
+
+            if (key == "id") {
+                record.id = parse_int(value, line_number, key);
+            } else if (key == "delivery-interval" || key == "processing-time") {
+                record.interval = parse_int(value, line_number, key);
+            } else if (key == "queue-type") {
+                if (value == "FIFO") {
+                    record.queue_type = PackageQueueType::FIFO;
+                } else if (value == "LIFO") {
+                    record.queue_type = PackageQueueType::LIFO;
+                } else {
+                    throw_parse_error(line_number, "unknown queue type: " + std::string(value));
+                }
+            } else if (key == "src") {
+                record.src = parse_node_ref(value, line_number, key);
+            } else {
+                record.dest = parse_node_ref(value, line_number, key);
+            }
+        }
+        for (std::size_t field = 0; field < required.size(); ++field) {
+            if (!(seen & (1U << field))) {
+                throw_parse_error(line_number, "missing key: " + required[field]);
+            }
+        }
+        return record;
+    }
+
+    /**
+     * Linki nadawcy z podanym p= oraz miejsce pierwszego z nich (do komunikatu błędu)
+     */
+    struct ExplicitLinks {
+        ReceiverPreferences::preferences_t probabilities;
+        NodeRef sender;
+        std::size_t line_number = 0;
+    };
+
+    using ExplicitProbabilities = std::unordered_map<PackageSender *, ExplicitLinks>;
+
+    void add_link(Factory &factory, const StructureRecord &record, std::size_t line_number,
+                  ExplicitProbabilities &explicit_probabilities) {
+        PackageSender *sender = nullptr;
+        if (record.src.type == ElementType::RAMP) {
+            auto ramp = factory.find_ramp_by_id(record.src.id);
+            if (ramp == factory.ramp_end()) {
+                throw_parse_error(line_number, "ramp not found: " + std::to_string(record.src.id));
+            }
+            sender = &*ramp;
+        } else if (record.src.type == ElementType::WORKER) {
+            auto worker = factory.find_worker_by_id(record.src.id);
+            if (worker == factory.worker_end()) {
+                throw_parse_error(line_number, "worker not found: " + std::to_string(record.src.id));
+            }
+            sender = &*worker;
+        } else {
+            throw_parse_error(line_number, "storehouse cannot be a link source");
+        }
+
+        IPackageReceiver *receiver = nullptr;
+        if (record.dest.type == ElementType::WORKER) {
+            auto worker = factory.find_worker_by_id(record.dest.id);
+            if (worker == factory.worker_end()) {
+                throw_parse_error(line_number, "worker not found: " + std::to_string(record.dest.id));
+            }
+            receiver = &*worker;
+        } else if (record.dest.type == ElementType::STOREHOUSE) {
+            auto storehouse = factory.find_storehouse_by_id(record.dest.id);
+            if (storehouse == factory.storehouse_end()) {
+                throw_parse_error(line_number, "storehouse not found: " + std::to_string(record.dest.id));
+            }
+            receiver = &*storehouse;
+        } else {
+            throw_parse_error(line_number, "ramp cannot be a link destination");
+        }
+        sender->receiver_preferences_.add_receiver(receiver);
+        if (record.has_probability) {
+            ExplicitLinks &links = explicit_probabilities[sender];
+            if (links.probabilities.empty()) {
+                links.sender = record.src;
+                links.line_number = line_number;
+            }
+            links.probabilities[receiver] = record.probability;
+        }
+    }
+}
+
+std::optional<std::string> probability_sum_error(ElementType sender_type, ElementID sender_id,
+                                                 const ReceiverPreferences::preferences_t &preferences) {
+    double sum = 0.0;
+    for (const auto &pref: preferences) {
+        sum += pref.second;
+    }
+    if (std::abs(sum - 1.0) <= kProbabilitySumTolerance) {
+        return std::nullopt;
+    }
+    std::ostringstream message;
+    message << "probabilities of links from " << (sender_type == ElementType::RAMP ? "ramp-" : "worker-")
+            << sender_id << " sum to " << sum;
+    return message.str();
+}
+
+Factory load_factory_structure(std::string_view text) {
     Factory factory;
-    std::string line;
-    while (std::getline(is, line)) {
-        if (line.empty() || line[0] == ';') {
+    // Wstępne przejście po początkach linii: liczby węzłów pozwalają zarezerwować indeksy z góry.
+    std::size_t ramps = 0;
+    std::size_t workers = 0;
+    std::size_t storehouses = 0;
+    for (std::size_t begin = 0; begin < text.size();) {
+        std::size_t eol = text.find('\n', begin);
+        std::string_view line = text.substr(begin, eol == std::string_view::npos ? std::string_view::npos : eol - begin);
+        std::string_view tag = next_token(line);
+        ramps += tag == "LOADING_RAMP";
+        workers += tag == "WORKER";
+        storehouses += tag == "STOREHOUSE";
+        begin = eol == std::string_view::npos ? text.size() : eol + 1;
+    }
+    factory.reserve(ramps, workers, storehouses);
+
+    ExplicitProbabilities explicit_probabilities;
+    std::size_t line_number = 0;
+    while (!text.empty()) {
+        std::size_t eol = text.find('\n');
+        std::string_view line = text.substr(0, eol);
+        text.remove_prefix(eol == std::string_view::npos ? text.size() : eol + 1);
+        ++line_number;
+
+        std::string_view rest = line;
+        std::string_view first = next_token(rest);
+        if (first.empty() || first.front() == ';') {
             continue;
         }
-        ParsedLineData data = parse_line(line);
-        switch (data.type) {
+        StructureRecord record = parse_record(line, line_number);
+        switch (record.type) {
             case ElementType::RAMP:
-                try {
-                    ElementID id = std::stoi(data.data.at("id"));
-                    TimeOffset di = std::stoi(data.data.at("delivery-interval"));
-                    factory.add_ramp(Ramp(id, di));
-                }
-                catch (...) {
-                    throw std::logic_error("Invalid values");
-                }
+                factory.add_ramp(Ramp(record.id, record.interval));
                 break;
             case ElementType::WORKER:
-                try {
-                    ElementID id = std::stoi(data.data.at("id"));
-                    TimeOffset pd = std::stoi(data.data.at("processing-time"));
-                    factory.add_worker(Worker(id, pd, std::make_unique<PackageQueue>(
-                            QUEUE_TYPE_NAMES.at(data.data.at("queue-type")))));
-                }
-                catch (...) {
-                    throw std::logic_error("Invalid values");
-                }
+                factory.add_worker(Worker(record.id, record.interval, std::make_unique<PackageQueue>(record.queue_type)));
                 break;
             case ElementType::STOREHOUSE:
-                try {
-                    ElementID id = std::stoi(data.data.at("id"));
-                    factory.add_storehouse(Storehouse(id));
-                }
-                catch (...) {
-                    throw std::logic_error("Invalid values");
-                }
+                factory.add_storehouse(Storehouse(record.id));
                 break;
             case ElementType::LINK:
-                try {
-                    std::istringstream src(data.data.at("src"));
-                    std::string src_type;
-                    std::string src_sid;
-                    ElementID src_id;
-                    std::getline(src, src_type, '-');
-                    std::getline(src, src_sid, '-');
-                    src_id = std::stoi(src_sid);
-                    std::istringstream dst(data.data.at("dest"));
-                    std::string dst_type;
-                    std::string dst_sid;
-                    ElementID dst_id;
-                    std::getline(dst, dst_type, '-');
-                    std::getline(dst, dst_sid, '-');
-                    dst_id = std::stoi(dst_sid);
-
-                    if (src_type == "ramp") {
-                        auto ramp = factory.find_ramp_by_id(src_id);
-                        if (ramp == factory.ramp_cend()) {
-                            throw std::logic_error("Ramp not found");
-                        }
-
-                        if (dst_type == "worker") {
-                            auto worker = factory.find_worker_by_id(dst_id);
-                            if (worker == factory.worker_cend()) {
-                                throw std::logic_error("Worker not found");
-                            }
-                            ramp->receiver_preferences_.add_receiver(&(*worker));
-                        } else if (dst_type == "store") {
-                            auto storehouse = factory.find_storehouse_by_id(dst_id);
-                            if (storehouse == factory.storehouse_cend()) {
-                                throw std::logic_error("Storehouse not found");
-                            }
-                            ramp->receiver_preferences_.add_receiver(&(*storehouse));
-                        } else {
-                            throw std::logic_error("Unknown destination type");
-                        }
-                    } else if (src_type == "worker") {
-                        auto worker_src = factory.find_worker_by_id(src_id);
-                        if (dst_type == "worker") {
-                            auto worker = factory.find_worker_by_id(dst_id);
-                            if (worker == factory.worker_cend()) {
-                                throw std::logic_error("Worker not found");
-                            }
-                            worker_src->receiver_preferences_.add_receiver(&(*worker));
-                        } else if (dst_type == "store") {
-                            auto storehouse = factory.find_storehouse_by_id(dst_id);
-                            if (storehouse == factory.storehouse_cend()) {
-                                throw std::logic_error("Storehouse not found");
-                            }
-                            worker_src->receiver_preferences_.add_receiver(&(*storehouse));
-                        } else {
-                            throw std::logic_error("Unknown destination type");
-                        }
-                    } else {
-                        throw std::logic_error("Unknown source type");
-                    }
-                }
-                catch (...) {
-                    throw std::logic_error("Invalid values");
-                }
+                add_link(factory, record, line_number, explicit_probabilities);
                 break;
         }
     }
+    // Podane p= nadpisują równy podział dopiero po wczytaniu wszystkich linków nadawcy; wynik musi sumować się do 1.
+    const ExplicitLinks *invalid = nullptr;
+    std::string invalid_message;
+    for (auto &[sender, links]: explicit_probabilities) {
+        ReceiverPreferences::preferences_t preferences = sender->receiver_preferences_.get_preferences();
+        for (const auto &[receiver, probability]: links.probabilities) {
+            preferences[receiver] = probability;
+        }
+        // Zgłaszany jest nadawca z najwcześniejszym p= - komunikat nie zależy od kolejności mapy.
+        if (invalid == nullptr || links.line_number < invalid->line_number) {
+            if (auto error = probability_sum_error(links.sender.type, links.sender.id, preferences)) {
+                invalid = &links;
+                invalid_message = std::move(*error);
+            }
+        }
+        sender->receiver_preferences_.set_preferences(std::move(preferences));
+    }
+    if (invalid != nullptr) {
+        throw_parse_error(invalid->line_number, invalid_message);
+    }
     return factory;
 }
 
-std::vector<std::string> get_receivers_string_list(ReceiverPreferences::const_iterator begin,
-                                                   ReceiverPreferences::const_iterator end) {
-    std::vector<std::string> receivers;
-    std::for_each(begin, end, [&receivers](const auto &receiver) {
-        receivers.push_back(RECEIVER_TYPE_NAMES.at(receiver.first->get_receiver_type()) + " #" +
-                            std::to_string(receiver.first->get_id()));
-    });
-    std::sort(receivers.begin(), receivers.end());
-    return receivers;
+Factory load_factory_structure(std::istream &is) {
+    // Wczytanie całości jednym ciągiem odczytów blokowych, potem parsowanie widokami na bufor.
+    std::string text;
+    char block[1 << 16];
+    while (is.read(block, sizeof(block)) || is.gcount() > 0) {
+        text.append(block, static_cast<std::size_t>(is.gcount()));
+    }
+    return load_factory_structure(std::string_view(text));
 }
 
-void save_factory_structure(const Factory &factory, std::ostream &os) {
-    std::vector<std::string> links;
-
-    os << "\n" << "; == LOADING RAMPS ==" << "\n\n";
-    std::vector<std::string> ramp_lines;
-    std::for_each(factory.ramp_cbegin(), factory.ramp_cend(), [&ramp_lines, &links](const auto &ramp) {
-        std::ostringstream oss;
-        oss << "LOADING_RAMP id=" << ramp.get_id() << " delivery-interval=" << ramp.get_delivery_interval() << "\n";
-        ramp_lines.push_back(oss.str());
-        std::for_each(ramp.receiver_preferences_.cbegin(), ramp.receiver_preferences_.cend(),
-                      [&ramp, &links](const auto &receiver) {
-                          std::ostringstream receiver_oss;
-                          receiver_oss << "LINK src=ramp" << "-" << ramp.get_id() << " dest="
-                                       << RECEIVER_TYPE_NAMES_IO.at(receiver.first->get_receiver_type()) << "-"
-                                       << receiver.first->get_id() << "\n";
-                          links.push_back(receiver_oss.str());
-                      });
+Factory load_factory_structure_file(const std::string &path) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) {
+        throw std::runtime_error("Cannot open " + path);
+    }
+    std::string text(static_cast<std::size_t>(file.tellg()), '\0');
+    file.seekg(0);
+    if (!file.read(text.data(), static_cast<std::streamsize>(text.size()))) {
+        throw std::runtime_error("Cannot read " + path);
+    }
+    return load_factory_structure(std::string_view(text));
+}
 
-    });
+namespace {
+    /**
+     * Czy preferencje są równym podziałem (takim, jaki daje samo add_receiver()) - wtedy p= nie jest zapisywane.
+     */
+    bool has_uniform_probabilities(const ReceiverPreferences &preferences) {
+        const double uniform = 1.0 / static_cast<double>(preferences.get_preferences().size());
+        return std::all_of(preferences.cbegin(), preferences.cend(),
+                           [uniform](const auto &pref) { return pref.second == uniform; });
+    }
 
-    std::sort(ramp_lines.begin(), ramp_lines.end());
-    for (const auto &line: ramp_lines) {
-        os << line;
-    }
-
-    os << "\n" << "; == WORKERS ==" << "\n\n";
-    std::vector<std::string> worker_lines;
-    std::for_each(factory.worker_cbegin(), factory.worker_cend(), [&worker_lines, &links](const auto &worker) {
-        std::string queue_name;
-        for (const auto &it: QUEUE_TYPE_NAMES)
-            if (it.second == worker.get_queue()->get_queue_type())
-                queue_name = it.first;
-
-        std::ostringstream oss;
-        oss << "WORKER id=" << worker.get_id() << " processing-time=" << worker.get_processing_duration() << " queue-type=" << queue_name << "\n";
-        worker_lines.push_back(oss.str());
-
-        std::for_each(worker.receiver_preferences_.cbegin(), worker.receiver_preferences_.cend(),
-                      [&worker, &links](const auto &receiver) {
-                          std::ostringstream receiver_oss;
-                          receiver_oss << "LINK src=worker" << "-" << worker.get_id() << " dest="
-                                       << RECEIVER_TYPE_NAMES_IO.at(receiver.first->get_receiver_type()) << "-"
-                                       << receiver.first->get_id() << "\n";
-                          links.push_back(receiver_oss.str());
-                      });
-    });
+    class StructureWriter {
+        /*!
+         * StructureWriter
+         * - formatuje linie pliku struktury bezpośrednio do stałego bufora (std::to_chars, bez strumieni
+         *   pośrednich) i wypisuje go do strumienia w dużych blokach, gdy się zapełni
+         */
+    public:
+        explicit StructureWriter(std::ostream &os) : os_(os) {}
+
+        ~StructureWriter() { flush(); }
+
+        StructureWriter &operator<<(std::string_view text) {
+            if (text.size() > buffer_.size() - used_) {
+                flush();
+                if (text.size() > buffer_.size()) {
+                    os_.write(text.data(), static_cast<std::streamsize>(text.size()));
+                    return *this;
+                }
+            }
+            text.copy(buffer_.data() + used_, text.size());
+            used_ += text.size();
+            return *this;
+        }
 
-    std::sort(worker_lines.begin(), worker_lines.end());
-    for (const auto &line: worker_lines) {
-        os << line;
+        StructureWriter &operator<<(int value) {
+            reserve(kMaxNumberLength);
+            used_ = static_cast<std::size_t>(std::to_chars(buffer_.data() + used_, buffer_.data() + buffer_.size(),
+                                                           value).ptr - buffer_.data());
+            return *this;
+        }
+
+        /**
+         * @brief Najkrótszy zapis dziesiętny, który wczytany z powrotem daje dokładnie tę samą wartość
+         */
+        StructureWriter &operator<<(double value) {
+            reserve(kMaxNumberLength);
+            used_ = static_cast<std::size_t>(std::to_chars(buffer_.data() + used_, buffer_.data() + buffer_.size(),
+                                                           value).ptr - buffer_.data());
+            return *this;
+        }
+
+        void flush() {
+            os_.write(buffer_.data(), static_cast<std::streamsize>(used_));
+            used_ = 0;
+        }
+
+    private:
+        static constexpr std::size_t kMaxNumberLength = 32;
+
+        void reserve(std::size_t length) {
+            if (length > buffer_.size() - used_) {
+                flush();
+            }
+        }
+
+        std::ostream &os_;
+        std::array<char, 1 << 16> buffer_{};
+        std::size_t used_ = 0;
+    };
+}
+
+const std::string &queue_type_name(PackageQueueType type) {
+    for (const auto &[name, queue_type]: QUEUE_TYPE_NAMES) {
+        if (queue_type == type) {
+            return name;
+        }
     }
+    throw std::logic_error("unknown queue type");
+}
 
-    os << "\n" << "; == STOREHOUSES ==" << "\n\n";
-    std::vector<std::string> storehouse_lines;
-    std::for_each(factory.storehouse_cbegin(), factory.storehouse_cend(), [&storehouse_lines](const auto &storehouse) {
-        std::ostringstream oss;
-        oss << "STOREHOUSE id=" << storehouse.get_id() << "\n";
-        storehouse_lines.push_back(oss.str());
-    });
+void save_factory_structure(const Factory &factory, std::ostream &os) {
+    const auto ramps = sorted_by_id<Ramp>(factory.ramp_cbegin(), factory.ramp_cend());
+    const auto workers = sorted_by_id<Worker>(factory.worker_cbegin(), factory.worker_cend());
+    const auto storehouses = sorted_by_id<Storehouse>(factory.storehouse_cbegin(), factory.storehouse_cend());
+    StructureWriter out(os);
+
+    out << "\n; == LOADING RAMPS ==\n\n";
+    for (const auto *ramp: ramps) {
+        out << "LOADING_RAMP id=" << ramp->get_id() << " delivery-interval=" << ramp->get_delivery_interval() << "\n";
+    }
 
-    std::sort(storehouse_lines.begin(), storehouse_lines.end());
-    for (const auto &line: storehouse_lines) {
-        os << line;
+    out << "\n; == WORKERS ==\n\n";
+    for (const auto *worker: workers) {
+        out << "WORKER id=" << worker->get_id() << " processing-time=" << worker->get_processing_duration()
+            << " queue-type=" << queue_type_name(worker->get_queue()->get_queue_type()) << "\n";
     }
 
-    os << "\n" << "; == LINKS ==" << "\n";
-    std::sort(links.begin(), links.end());
-    for (const auto &line: links) {
-        os << line;
+    out << "\n; == STOREHOUSES ==\n\n";
+    for (const auto *storehouse: storehouses) {
+        out << "STOREHOUSE id=" << storehouse->get_id() << "\n";
     }
 
+    // Linki wypisywane nadawca po nadawcy (rampy, potem robotnicy, rosnąco według ID), odbiorcy nadawcy
+    // według (typ, ID) - magazyny przed robotnikami, jak w porządku nazw "store" < "worker".
+    out << "\n; == LINKS ==\n";
+    struct LinkLine {
+        ReceiverType type;
+        ElementID id;
+        double probability;
+    };
+    std::vector<LinkLine> receivers;
+    auto write_links = [&out, &receivers](std::string_view sender_type, ElementID sender_id,
+                                          const ReceiverPreferences &preferences) {
+        receivers.clear();
+        for (const auto &[receiver, probability]: preferences) {
+            receivers.push_back({receiver->get_receiver_type(), receiver->get_id(), probability});
+        }
+        std::stable_sort(receivers.begin(), receivers.end(), [](const LinkLine &a, const LinkLine &b) {
+            return std::make_pair(a.type != ReceiverType::STOREHOUSE, a.id) <
+                   std::make_pair(b.type != ReceiverType::STOREHOUSE, b.id);
+        });
+        const bool uniform = has_uniform_probabilities(preferences);
+        for (const auto &link: receivers) {
+            out << "LINK src=" << sender_type << "-" << sender_id << " dest=" << RECEIVER_TYPE_NAMES_IO.at(link.type)
+                << "-" << link.id;
+            if (!uniform) {
+                out << " p=" << link.probability;
+            }
+            out << "\n";
+        }
+    };
+    for (const auto *ramp: ramps) {
+        write_links("ramp", ramp->get_id(), ramp->receiver_preferences_);
+    }
+    for (const auto *worker: workers) {
+        write_links("worker", worker->get_id(), worker->receiver_preferences_);
+    }
+    out.flush();
     os.flush();
 }
 
-/** RAPORT **/
-/*
- * void save_factory_structure(const Factory &factory, std::ostream &os) {
-    os << "\n" << "== LOADING RAMPS ==" << "\n";
-    std::vector<std::string> ramp_lines;
-    std::for_each(factory.ramp_cbegin(), factory.ramp_cend(), [&ramp_lines](const auto &ramp) {
-        std::ostringstream oss;
-        oss << "LOADING RAMP #" << ramp.get_id() << "\n  Delivery interval: " << ramp.get_delivery_interval() << "\n";
-        std::vector<std::string> receivers = get_receivers_string_list(ramp.receiver_preferences_.cbegin(),
-                                                                       ramp.receiver_preferences_.cend());
-        oss << "  Receivers:\n";
-        for (const auto &receiver: receivers) {
-            oss << "    " << receiver << "\n";
-        }
-        ramp_lines.push_back(oss.str());
-    });
-
-    std::sort(ramp_lines.begin(), ramp_lines.end());
-    for (const auto &line: ramp_lines) {
-        os << line;
+namespace {
+    std::unique_ptr<IPackageStockpile> empty_stockpile_like(const IPackageStockpile *stockpile) {
+        if (auto aggregate = dynamic_cast<const AggregateStockpile *>(stockpile)) {
+            return std::make_unique<AggregateStockpile>(aggregate->get_interval(), aggregate->get_max_buckets());
+        }
+        if (dynamic_cast<const PackageLog *>(stockpile) != nullptr) {
+            return std::make_unique<PackageLog>();
+        }
+        if (auto queue = dynamic_cast<const IPackageQueue *>(stockpile)) {
+            return std::make_unique<PackageQueue>(queue->get_queue_type());
+        }
+        throw std::logic_error("Unsupported stockpile type");
     }
+}
 
-    os << "\n" << "== WORKERS ==" << "\n";
-    std::vector<std::string> worker_lines;
-    std::for_each(factory.worker_cbegin(), factory.worker_cend(), [&worker_lines](const auto &worker) {
-        std::ostringstream oss;
-        oss << "WORKER #" << worker.get_id() << "\n  Processing time: " << worker.get_processing_duration() << "\n";
+namespace {
+    /**
+     * @brief Przepisuje preferencje wszystkich nadawców `from` na odpowiadające im węzły `to`
+     * (odwzorowanie po pozycji na liście - działa także przy powtórzonych ID)
+     */
+    void copy_links(const Factory &from, Factory &to) {
+        std::unordered_map<const IPackageReceiver *, IPackageReceiver *> receivers;
+        auto worker = to.worker_begin();
+        for (auto it = from.worker_cbegin(); it != from.worker_cend(); ++it, ++worker) {
+            receivers.emplace(&*it, &*worker);
+        }
+        auto storehouse = to.storehouse_begin();
+        for (auto it = from.storehouse_cbegin(); it != from.storehouse_cend(); ++it, ++storehouse) {
+            receivers.emplace(&*it, &*storehouse);
+        }
+        auto copy_preferences = [&receivers](const PackageSender &sender, PackageSender &copy) {
+            ReceiverPreferences::preferences_t preferences;
+            for (const auto &pref: sender.receiver_preferences_) {
+                auto receiver = receivers.find(pref.first);
+                if (receiver == receivers.end()) {
+                    throw std::logic_error("Receiver outside of the factory");
+                }
+                preferences.emplace(receiver->second, pref.second);
+            }
+            copy.receiver_preferences_.set_preferences(std::move(preferences));
+        };
+        auto ramp = to.ramp_begin();
+        for (auto it = from.ramp_cbegin(); it != from.ramp_cend(); ++it, ++ramp) {
+            copy_preferences(*it, *ramp);
+        }
+        worker = to.worker_begin();
+        for (auto it = from.worker_cbegin(); it != from.worker_cend(); ++it, ++worker) {
+            copy_preferences(*it, *worker);
+        }
+    }
+}
 
-        std::string queue_name;
-        for (const auto &it: QUEUE_TYPE_NAMES)
-            if (it.second == worker.get_queue()->get_queue_type())
-                queue_name = it.first;
-        oss << "  Queue type: " << queue_name << "\n";
+Factory clone_factory_structure(const Factory &factory) {
+    Factory clone;
+    for (auto it = factory.ramp_cbegin(); it != factory.ramp_cend(); ++it) {
+        clone.add_ramp(Ramp(it->get_id(), it->get_delivery_interval()));
+    }
+    for (auto it = factory.worker_cbegin(); it != factory.worker_cend(); ++it) {
+        clone.add_worker(Worker(it->get_id(), it->get_processing_duration(),
+                                std::make_unique<PackageQueue>(it->get_queue()->get_queue_type())));
+    }
+    for (auto it = factory.storehouse_cbegin(); it != factory.storehouse_cend(); ++it) {
+        clone.add_storehouse(Storehouse(it->get_id(), empty_stockpile_like(it->get_stockpile())));
+    }
+    copy_links(factory, clone);
+    return clone;
+}
 
-        std::vector<std::string> receivers = get_receivers_string_list(worker.receiver_preferences_.cbegin(),
-                                                                       worker.receiver_preferences_.cend());
-        oss << "  Receivers:\n";
-        for (const auto &receiver: receivers) {
-            oss << "    " << receiver << "\n";
+// Gałąź dostaje własne węzły (preferencje wskazują jej węzły), kopię rejestru ID, turę i bufory; zawartość kolejek
+// i magazynów jest kopiowana raz (PackageSnapshot) i współdzielona przez gałęzie (copy-on-write) - także przy kolejnym
+// rozgałęzieniu niezmienionej gałęzi. Własne domeny ID pozwalają uruchamiać gałęzie równolegle. Gałęzie dziedziczą
+// ziarno tras; liczba wątków nie jest kopiowana.
+std::vector<Factory> Factory::fork(std::size_t branches) const {
+    // Zawartość kolejek i magazynów kopiowana jest raz - wszystkie gałęzie dostają te same kopie.
+    std::vector<std::shared_ptr<const PackageSnapshot>> queues;
+    queues.reserve(workers_.size());
+    for (const auto &worker: workers_) {
+        auto queue = dynamic_cast<const PackageQueue *>(worker.get_queue());
+        if (queue == nullptr) {
+            throw std::logic_error("Unsupported queue type");
+        }
+        queues.push_back(queue->snapshot(*package_ids_));
+    }
+    std::vector<std::shared_ptr<const PackageSnapshot>> stock;
+    stock.reserve(storehouses_.size());
+    for (const auto &storehouse: storehouses_) {
+        const IPackageStockpile *stockpile = storehouse.get_stockpile();
+        if (auto queue = dynamic_cast<const PackageQueue *>(stockpile)) {
+            stock.push_back(queue->snapshot(*package_ids_));
+        } else if (auto log = dynamic_cast<const PackageLog *>(stockpile)) {
+            stock.push_back(log->snapshot(*package_ids_));
+        } else if (dynamic_cast<const AggregateStockpile *>(stockpile) != nullptr) {
+            stock.push_back(nullptr);
+        } else {
+            throw std::logic_error("Unsupported stockpile type");
         }
-        worker_lines.push_back(oss.str());
-    });
-
-    std::sort(worker_lines.begin(), worker_lines.end());
-    for (const auto &line: worker_lines) {
-        os << line;
     }
 
-    os << "\n" << "== STOREHOUSES ==" << "\n";
-    std::vector<std::string> storehouse_lines;
-    std::for_each(factory.storehouse_cbegin(), factory.storehouse_cend(), [&storehouse_lines](const auto &storehouse) {
-        std::ostringstream oss;
-        oss << "STOREHOUSE #" << storehouse.get_id() << "\n";
-        storehouse_lines.push_back(oss.str());
-    });
+    std::vector<Factory> result(branches);
+    for (Factory &branch: result) {
+        // Kopia rejestru: ID paczek z kopii i buforów są w gałęzi zajęte, tak jak w oryginale.
+        *branch.package_ids_ = *package_ids_;
+        PackageIDAllocator *ids = branch.package_ids_.get();
+        auto copy_package = [this, ids](const std::optional<Package> &package) -> std::optional<Package> {
+            if (!package.has_value()) {
+                return std::nullopt;
+            }
+            return package->belongs_to(*package_ids_) ? Package(*ids, package->get_id()) : Package(package->get_id());
+        };
 
-    std::sort(storehouse_lines.begin(), storehouse_lines.end());
-    for (const auto &line: storehouse_lines) {
-        os << line;
-    }
+        branch.reserve(ramps_.size(), workers_.size(), storehouses_.size());
+        for (const auto &ramp: ramps_) {
+            branch.add_ramp(Ramp(ramp.get_id(), ramp.get_delivery_interval()));
+        }
+        std::size_t index = 0;
+        for (const auto &worker: workers_) {
+            branch.add_worker(Worker(worker.get_id(), worker.get_processing_duration(),
+                                     std::make_unique<PackageQueue>(worker.get_queue()->get_queue_type(),
+                                                                    queues[index++], ids)));
+        }
+        index = 0;
+        for (const auto &storehouse: storehouses_) {
+            const IPackageStockpile *stockpile = storehouse.get_stockpile();
+            std::unique_ptr<IPackageStockpile> copy;
+            if (auto queue = dynamic_cast<const PackageQueue *>(stockpile)) {
+                copy = std::make_unique<PackageQueue>(queue->get_queue_type(), stock[index], ids);
+            } else if (dynamic_cast<const PackageLog *>(stockpile) != nullptr) {
+                copy = std::make_unique<PackageLog>(stock[index], ids);
+            } else {
+                auto aggregate = static_cast<const AggregateStockpile *>(stockpile);
+                auto counters = std::make_unique<AggregateStockpile>(aggregate->get_interval(),
+                                                                     aggregate->get_max_buckets());
+                counters->set_state(aggregate->get_interval(), aggregate->get_arrival_count(),
+                                    aggregate->get_histogram());
+                copy = std::move(counters);
+            }
+            branch.add_storehouse(Storehouse(storehouse.get_id(), std::move(copy)));
+            ++index;
+        }
 
-    os.flush();
+        auto ramp = branch.ramps_.begin();
+        for (const auto &original: ramps_) {
+            (ramp++)->set_sending_buffer(copy_package(original.get_sending_buffer()));
+        }
+        auto worker = branch.workers_.begin();
+        for (const auto &original: workers_) {
+            worker->set_processing_buffer(copy_package(original.get_processing_buffer()),
+                                          original.get_package_processing_start_time());
+            (worker++)->set_sending_buffer(copy_package(original.get_sending_buffer()));
+        }
+        copy_links(*this, branch);
+        branch.set_time(*time_);
+        // Liczniki zostały podpięte przy turze 0 - gałąź liczy dopiero od tury rozgałęzienia.
+        branch.reset_node_counters();
+        if (routing_) {
+            branch.set_routing_seed(routing_->get_seed());
+        } else {
+            // Bez ziarna gałęzie losowałyby ze wspólnego rng (wyścig przy równoległych gałęziach) - każda dostaje
+            // własne ziarno, pobierane szeregowo z rng. Osobne zmienne ustalają kolejność losowań (kolejność
+            // obliczania argumentów operatora | nie jest określona).
+            const std::uint64_t high = rng();
+            const std::uint64_t low = rng();
+            branch.set_routing_seed((high << 32) | low);
+        }
+    }
+    return result;
 }
- */
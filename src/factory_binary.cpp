@@ -0,0 +1,308 @@
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+#include "factory_binary.hpp"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define NETSIM_HAVE_MMAP 1
+#endif
+
+using namespace factory_binary;
+
+namespace {
+    static_assert(std::is_same_v<ElementID, std::int32_t> && std::is_same_v<TimeOffset, std::int32_t>,
+                  "binary structure records store IDs and time offsets as 32-bit integers");
+    static_assert(sizeof(Header) == 48 && sizeof(RampRecord) == 8 && sizeof(WorkerRecord) == 16 &&
+                  sizeof(StorehouseRecord) == 8 && sizeof(LinkRecord) == 16, "unexpected record padding");
+
+    [[noreturn]] void throw_format_error(const std::string &message) {
+        throw std::logic_error("binary structure: " + message);
+    }
+
+    /**
+     * Widok sekcji pliku - wskaźniki prosto do bufora, po sprawdzeniu rozmiarów i wyrównania.
+     */
+    struct StructureSections {
+        const Header *header = nullptr;
+        const RampRecord *ramps = nullptr;
+        const WorkerRecord *workers = nullptr;
+        const StorehouseRecord *storehouses = nullptr;
+        const std::uint64_t *link_offsets = nullptr;
+        const LinkRecord *links = nullptr;
+    };
+
+    StructureSections map_sections(const unsigned char *data, std::size_t size) {
+        if (size < sizeof(Header) || !is_binary_structure(data, size)) {
+            throw_format_error("missing header");
+        }
+        StructureSections sections;
+        sections.header = reinterpret_cast<const Header *>(data);
+        const Header &header = *sections.header;
+        if (header.version != kVersion) {
+            throw_format_error("unsupported version " + std::to_string(header.version));
+        }
+        if (header.byte_order != kByteOrderMark) {
+            throw_format_error("byte order does not match this machine");
+        }
+
+        // Każda liczność jest ograniczona rozmiarem pliku, zanim zostanie przemnożona przez rozmiar rekordu.
+        std::size_t offset = sizeof(Header);
+        auto take = [&](std::uint64_t count, std::size_t record_size) {
+            if (count > (size - offset) / record_size) {
+                throw_format_error("truncated file");
+            }
+            const unsigned char *section = data + offset;
+            offset += static_cast<std::size_t>(count) * record_size;
+            return section;
+        };
+        sections.ramps = reinterpret_cast<const RampRecord *>(take(header.ramp_count, sizeof(RampRecord)));
+        sections.workers = reinterpret_cast<const WorkerRecord *>(take(header.worker_count, sizeof(WorkerRecord)));
+        sections.storehouses = reinterpret_cast<const StorehouseRecord *>(
+                take(header.storehouse_count, sizeof(StorehouseRecord)));
+        sections.link_offsets = reinterpret_cast<const std::uint64_t *>(
+                take(header.ramp_count + header.worker_count + 1, sizeof(std::uint64_t)));
+        sections.links = reinterpret_cast<const LinkRecord *>(take(header.link_count, sizeof(LinkRecord)));
+        if (offset != size) {
+            throw_format_error("trailing bytes after link table");
+        }
+        return sections;
+    }
+
+    Factory build_factory(const StructureSections &sections) {
+        const Header &header = *sections.header;
+        const auto ramp_count = static_cast<std::size_t>(header.ramp_count);
+        const auto worker_count = static_cast<std::size_t>(header.worker_count);
+        const auto storehouse_count = static_cast<std::size_t>(header.storehouse_count);
+
+        Factory factory;
+        factory.reserve(ramp_count, worker_count, storehouse_count);
+        for (std::size_t i = 0; i < ramp_count; ++i) {
+            factory.add_ramp(Ramp(sections.ramps[i].id, sections.ramps[i].delivery_interval));
+        }
+        for (std::size_t i = 0; i < worker_count; ++i) {
+            const WorkerRecord &record = sections.workers[i];
+            if (record.queue_type > static_cast<std::uint32_t>(PackageQueueType::LIFO)) {
+                throw_format_error("unknown queue type in worker " + std::to_string(record.id));
+            }
+            factory.add_worker(Worker(record.id, record.processing_time,
+                                      std::make_unique<PackageQueue>(static_cast<PackageQueueType>(record.queue_type))));
+        }
+        for (std::size_t i = 0; i < storehouse_count; ++i) {
+            factory.add_storehouse(Storehouse(sections.storehouses[i].id));
+        }
+
+        // Pusta fabryka + dodawanie na koniec list: kolejność list odpowiada indeksom tablic w pliku.
+        std::vector<PackageSender *> senders;
+        senders.reserve(ramp_count + worker_count);
+        std::vector<IPackageReceiver *> workers;
+        workers.reserve(worker_count);
+        std::vector<IPackageReceiver *> storehouses;
+        storehouses.reserve(storehouse_count);
+        for (auto it = factory.ramp_begin(); it != factory.ramp_end(); ++it) {
+            senders.push_back(&*it);
+        }
+        for (auto it = factory.worker_begin(); it != factory.worker_end(); ++it) {
+            senders.push_back(&*it);
+            workers.push_back(&*it);
+        }
+        for (auto it = factory.storehouse_begin(); it != factory.storehouse_end(); ++it) {
+            storehouses.push_back(&*it);
+        }
+
+        const std::uint64_t *offsets = sections.link_offsets;
+        if (offsets[0] != 0 || offsets[senders.size()] != header.link_count) {
+            throw_format_error("link offsets do not cover the link table");
+        }
+        for (std::size_t s = 0; s < senders.size(); ++s) {
+            if (offsets[s + 1] < offsets[s]) {
+                throw_format_error("link offsets are not monotonic");
+            }
+            if (offsets[s + 1] == offsets[s]) {
+                continue;
+            }
+            ReceiverPreferences::preferences_t preferences;
+            for (std::uint64_t l = offsets[s]; l < offsets[s + 1]; ++l) {
+                const LinkRecord &link = sections.links[l];
+                const std::vector<IPackageReceiver *> *table = nullptr;
+                if (link.receiver_type == static_cast<std::uint32_t>(ReceiverType::WORKER)) {
+                    table = &workers;
+                } else if (link.receiver_type == static_cast<std::uint32_t>(ReceiverType::STOREHOUSE)) {
+                    table = &storehouses;
+                } else {
+                    throw_format_error("unknown receiver type in link " + std::to_string(l));
+                }
+                if (link.receiver_index >= table->size()) {
+                    throw_format_error("receiver index out of range in link " + std::to_string(l));
+                }
+                // Te same warunki co p= w formacie tekstowym (odrzuca też NaN i nieskończoności).
+                if (!(link.probability > 0.0 && link.probability <= 1.0)) {
+                    throw_format_error("invalid probability in link " + std::to_string(l));
+                }
+                if (!preferences.emplace((*table)[link.receiver_index], link.probability).second) {
+                    throw_format_error("duplicate receiver in link " + std::to_string(l));
+                }
+            }
+            const bool ramp = s < ramp_count;
+            if (auto error = probability_sum_error(ramp ? ElementType::RAMP : ElementType::WORKER,
+                                                   ramp ? sections.ramps[s].id : sections.workers[s - ramp_count].id,
+                                                   preferences)) {
+                throw_format_error(*error);
+            }
+            senders[s]->receiver_preferences_.set_preferences(std::move(preferences));
+        }
+        return factory;
+    }
+
+    template<class Record>
+    void write_records(std::ostream &os, const std::vector<Record> &records) {
+        os.write(reinterpret_cast<const char *>(records.data()),
+                 static_cast<std::streamsize>(records.size() * sizeof(Record)));
+    }
+
+#ifdef NETSIM_HAVE_MMAP
+    class MappedFile {
+        /*!
+         * MappedFile
+         * - odwzorowuje cały plik w pamięci tylko do odczytu; odwzorowanie jest zwalniane w destruktorze
+         */
+    public:
+        explicit MappedFile(const std::string &path) {
+            int fd = ::open(path.c_str(), O_RDONLY);
+            if (fd < 0) {
+                throw std::runtime_error("Cannot open " + path);
+            }
+            struct stat st{};
+            if (::fstat(fd, &st) != 0) {
+                ::close(fd);
+                throw std::runtime_error("Cannot read " + path);
+            }
+            size_ = static_cast<std::size_t>(st.st_size);
+            if (size_ > 0) {
+                data_ = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+            }
+            ::close(fd);
+            if (data_ == MAP_FAILED) {
+                data_ = nullptr;
+                throw std::runtime_error("Cannot map " + path);
+            }
+        }
+
+        MappedFile(const MappedFile &) = delete;
+
+        MappedFile &operator=(const MappedFile &) = delete;
+
+        ~MappedFile() {
+            if (data_ != nullptr) {
+                ::munmap(data_, size_);
+            }
+        }
+
+        const void *data() const { return data_; }
+
+        std::size_t size() const { return size_; }
+
+    private:
+        void *data_ = nullptr;
+        std::size_t size_ = 0;
+    };
+#endif
+}
+
+bool factory_binary::is_binary_structure(const void *data, std::size_t size) {
+    return size >= sizeof(kMagic) && std::memcmp(data, kMagic, sizeof(kMagic)) == 0;
+}
+
+void save_factory_structure_binary(const Factory &factory, std::ostream &os) {
+    std::vector<RampRecord> ramps;
+    std::vector<WorkerRecord> workers;
+    std::vector<StorehouseRecord> storehouses;
+    std::unordered_map<const IPackageReceiver *, std::uint32_t> receiver_index;
+
+    for (auto it = factory.ramp_cbegin(); it != factory.ramp_cend(); ++it) {
+        ramps.push_back({it->get_id(), it->get_delivery_interval()});
+    }
+    for (auto it = factory.worker_cbegin(); it != factory.worker_cend(); ++it) {
+        receiver_index.emplace(&*it, static_cast<std::uint32_t>(workers.size()));
+        workers.push_back({it->get_id(), it->get_processing_duration(),
+                           static_cast<std::uint32_t>(it->get_queue()->get_queue_type()), 0});
+    }
+    for (auto it = factory.storehouse_cbegin(); it != factory.storehouse_cend(); ++it) {
+        receiver_index.emplace(&*it, static_cast<std::uint32_t>(storehouses.size()));
+        storehouses.push_back({it->get_id(), 0});
+    }
+
+    std::vector<std::uint64_t> link_offsets{0};
+    std::vector<LinkRecord> links;
+    auto add_sender_links = [&](const PackageSender &sender) {
+        const std::size_t first = links.size();
+        for (const auto &[receiver, probability]: sender.receiver_preferences_) {
+            auto index = receiver_index.find(receiver);
+            if (index == receiver_index.end()) {
+                throw std::logic_error("binary structure: link to a node outside the factory");
+            }
+            links.push_back({static_cast<std::uint32_t>(receiver->get_receiver_type()), index->second, probability});
+        }
+        // Kolejność w preferencjach zależy od adresów - w pliku linki są uporządkowane według (typ, indeks).
+        std::sort(links.begin() + static_cast<std::ptrdiff_t>(first), links.end(),
+                  [](const LinkRecord &a, const LinkRecord &b) {
+                      return std::tie(a.receiver_type, a.receiver_index) < std::tie(b.receiver_type, b.receiver_index);
+                  });
+        link_offsets.push_back(links.size());
+    };
+    std::for_each(factory.ramp_cbegin(), factory.ramp_cend(), add_sender_links);
+    std::for_each(factory.worker_cbegin(), factory.worker_cend(), add_sender_links);
+
+    Header header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.byte_order = kByteOrderMark;
+    header.ramp_count = ramps.size();
+    header.worker_count = workers.size();
+    header.storehouse_count = storehouses.size();
+    header.link_count = links.size();
+
+    os.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    write_records(os, ramps);
+    write_records(os, workers);
+    write_records(os, storehouses);
+    write_records(os, link_offsets);
+    write_records(os, links);
+    os.flush();
+}
+
+Factory load_factory_structure_binary(const void *data, std::size_t size) {
+    if (reinterpret_cast<std::uintptr_t>(data) % alignof(std::uint64_t) == 0) {
+        return build_factory(map_sections(static_cast<const unsigned char *>(data), size));
+    }
+    std::vector<std::uint64_t> aligned((size + sizeof(std::uint64_t) - 1) / sizeof(std::uint64_t));
+    std::memcpy(aligned.data(), data, size);
+    return build_factory(map_sections(reinterpret_cast<const unsigned char *>(aligned.data()), size));
+}
+
+Factory load_factory_structure_binary_file(const std::string &path) {
+#ifdef NETSIM_HAVE_MMAP
+    MappedFile file(path);
+    return load_factory_structure_binary(file.data(), file.size());
+#else
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) {
+        throw std::runtime_error("Cannot open " + path);
+    }
+    const auto size = static_cast<std::size_t>(file.tellg());
+    std::vector<std::uint64_t> buffer((size + sizeof(std::uint64_t) - 1) / sizeof(std::uint64_t));
+    file.seekg(0);
+    if (!file.read(reinterpret_cast<char *>(buffer.data()), static_cast<std::streamsize>(size))) {
+        throw std::runtime_error("Cannot read " + path);
+    }
+    return load_factory_structure_binary(buffer.data(), size);
+#endif
+}
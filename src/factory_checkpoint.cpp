@@ -0,0 +1,430 @@
+#include <cstring>
+#include <istream>
+#include <iterator>
+#include <optional>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "factory.hpp"
+#include "factory_checkpoint.hpp"
+#include "helpers.hpp"
+
+using namespace factory_checkpoint;
+
+namespace {
+    static_assert(std::is_same_v<ElementID, std::int32_t> && std::is_same_v<Time, std::int32_t>,
+                  "checkpoint records store IDs and turns as 32-bit integers");
+    static_assert(sizeof(Header) == 104 && sizeof(PackageRecord) == 8 && sizeof(RampState) == 16 &&
+                  sizeof(WorkerState) == 32 && sizeof(StorehouseState) == 40, "unexpected record padding");
+
+    [[noreturn]] void throw_checkpoint_error(const std::string &message) {
+        throw std::logic_error("checkpoint: " + message);
+    }
+
+    /**
+     * Widok tablicy rekordów w buforze; rekordy są kopiowane przy odczycie, więc bufor nie musi być wyrównany.
+     */
+    template<class Record>
+    class RecordArray {
+    public:
+        RecordArray() = default;
+
+        RecordArray(const unsigned char *data, std::uint64_t count) : data_(data), count_(count) {}
+
+        Record operator[](std::uint64_t index) const {
+            Record record;
+            std::memcpy(&record, data_ + index * sizeof(Record), sizeof(Record));
+            return record;
+        }
+
+        std::uint64_t size() const { return count_; }
+
+    private:
+        const unsigned char *data_ = nullptr;
+        std::uint64_t count_ = 0;
+    };
+
+    struct CheckpointSections {
+        Header header{};
+        RecordArray<RampState> ramps;
+        RecordArray<WorkerState> workers;
+        RecordArray<StorehouseState> storehouses;
+        RecordArray<PackageRecord> packages;
+        RecordArray<std::int32_t> arrivals;
+        RecordArray<std::uint64_t> histogram;
+        std::string rng_state;
+    };
+
+    CheckpointSections map_sections(const unsigned char *data, std::size_t size) {
+        if (size < sizeof(Header) || !is_checkpoint(data, size)) {
+            throw_checkpoint_error("missing header");
+        }
+        CheckpointSections sections;
+        Header &header = sections.header;
+        std::memcpy(&header, data, sizeof(Header));
+        if (header.version != kVersion) {
+            throw_checkpoint_error("unsupported version " + std::to_string(header.version));
+        }
+        if (header.byte_order != kByteOrderMark) {
+            throw_checkpoint_error("byte order does not match this machine");
+        }
+
+        std::size_t offset = sizeof(Header);
+        auto take = [&](std::uint64_t count, std::size_t record_size) {
+            if (count > (size - offset) / record_size) {
+                throw_checkpoint_error("truncated data");
+            }
+            const unsigned char *section = data + offset;
+            offset += static_cast<std::size_t>(count) * record_size;
+            return section;
+        };
+        sections.ramps = {take(header.ramp_count, sizeof(RampState)), header.ramp_count};
+        sections.workers = {take(header.worker_count, sizeof(WorkerState)), header.worker_count};
+        sections.storehouses = {take(header.storehouse_count, sizeof(StorehouseState)), header.storehouse_count};
+        sections.packages = {take(header.package_count, sizeof(PackageRecord)), header.package_count};
+        sections.arrivals = {take(header.arrival_count, sizeof(std::int32_t)), header.arrival_count};
+        sections.histogram = {take(header.histogram_count, sizeof(std::uint64_t)), header.histogram_count};
+        const unsigned char *rng_state = take(header.rng_state_size, 1);
+        sections.rng_state.assign(reinterpret_cast<const char *>(rng_state), static_cast<std::size_t>(header.rng_state_size));
+        if (offset != size) {
+            throw_checkpoint_error("trailing bytes after generator state");
+        }
+        return sections;
+    }
+
+    StockpileKind stockpile_kind(const IPackageStockpile &stockpile, ElementID storehouse_id) {
+        if (auto queue = dynamic_cast<const PackageQueue *>(&stockpile)) {
+            return queue->get_queue_type() == PackageQueueType::FIFO ? StockpileKind::QUEUE_FIFO
+                                                                     : StockpileKind::QUEUE_LIFO;
+        }
+        if (dynamic_cast<const PackageLog *>(&stockpile) != nullptr) {
+            return StockpileKind::LOG;
+        }
+        if (dynamic_cast<const AggregateStockpile *>(&stockpile) != nullptr) {
+            return StockpileKind::AGGREGATE;
+        }
+        throw_checkpoint_error("unsupported stockpile in storehouse " + std::to_string(storehouse_id));
+    }
+
+    PackageRecord package_record(const Package &package, const PackageIDAllocator &ids) {
+        return {package.get_id(), package.belongs_to(ids) ? 1U : 0U};
+    }
+
+    /**
+     * @brief Paczka z magazynu - domenę zna magazyn (paczki współdzielone z innymi gałęziami jej nie pamiętają)
+     */
+    PackageRecord package_record(const IPackageStockpile &stockpile, const Package &package,
+                                 const PackageIDAllocator &ids) {
+        return {package.get_id(), stockpile.id_domain(package) == &ids ? 1U : 0U};
+    }
+
+    PackageRecord package_record(const std::optional<Package> &package, const PackageIDAllocator &ids) {
+        return package.has_value() ? package_record(*package, ids) : PackageRecord{Package::kNoID, 0};
+    }
+
+    template<class Record>
+    void write_records(std::ostream &os, const std::vector<Record> &records) {
+        os.write(reinterpret_cast<const char *>(records.data()),
+                 static_cast<std::streamsize>(records.size() * sizeof(Record)));
+    }
+
+    /**
+     * @brief Wstawia n kolejnych paczek tak, aby kolejność pobierania była taka jak w zapisie:
+     * kolejka LIFO dokłada na początek, więc dostaje je od końca
+     */
+    template<class MakePackage>
+    void fill_queue(IPackageStockpile &stockpile, bool lifo, const RecordArray<PackageRecord> &packages,
+                    std::uint64_t first, std::uint64_t count, MakePackage make) {
+        for (std::uint64_t i = 0; i < count; ++i) {
+            stockpile.push(make(packages[lifo ? first + count - 1 - i : first + i]));
+        }
+    }
+}
+
+bool factory_checkpoint::is_checkpoint(const void *data, std::size_t size) {
+    return size >= sizeof(kMagic) && std::memcmp(data, kMagic, sizeof(kMagic)) == 0;
+}
+
+void Factory::save_checkpoint(std::ostream &os) const {
+    const PackageIDAllocator &ids = *package_ids_;
+    Header header{};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.byte_order = kByteOrderMark;
+    header.time = *time_;
+    header.id_allocations = ids.allocation_count();
+    header.id_releases = ids.release_count();
+
+    // Losowania licznikowe są numerowane w obrębie tury, a punkt kontrolny powstaje między turami,
+    // więc przy ziarnie tras wystarczy samo ziarno. Bez niego trasy zależą od stanu wspólnego generatora.
+    std::string rng_state;
+    if (routing_) {
+        header.flags |= kHasRoutingSeed;
+        header.routing_seed = routing_->get_seed();
+    } else {
+        std::ostringstream oss;
+        oss << rng;
+        rng_state = oss.str();
+        header.flags |= kHasRngState;
+    }
+
+    std::vector<RampState> ramps;
+    std::vector<WorkerState> workers;
+    std::vector<StorehouseState> storehouses;
+    std::vector<PackageRecord> packages;
+    std::vector<std::int32_t> arrivals;
+    std::vector<std::uint64_t> histogram;
+    ramps.reserve(ramps_.size());
+    workers.reserve(workers_.size());
+    storehouses.reserve(storehouses_.size());
+
+    for (const auto &ramp: ramps_) {
+        ramps.push_back({ramp.get_id(), 0, package_record(ramp.get_sending_buffer(), ids)});
+    }
+    for (const auto &worker: workers_) {
+        const IPackageQueue &queue = *worker.get_queue();
+        workers.push_back({worker.get_id(), worker.get_package_processing_start_time(),
+                           package_record(worker.get_processing_buffer(), ids),
+                           package_record(worker.get_sending_buffer(), ids), queue.size()});
+        for (const auto &package: queue) {
+            packages.push_back(package_record(queue, package, ids));
+        }
+    }
+    for (const auto &storehouse: storehouses_) {
+        const IPackageStockpile &stockpile = *storehouse.get_stockpile();
+        const StockpileKind kind = stockpile_kind(stockpile, storehouse.get_id());
+        StorehouseState state{storehouse.get_id(), static_cast<std::uint32_t>(kind), 0, 0, 0, 0, 0};
+        if (kind == StockpileKind::AGGREGATE) {
+            const auto &aggregate = static_cast<const AggregateStockpile &>(stockpile);
+            state.interval = aggregate.get_interval();
+            state.arrival_count = aggregate.get_arrival_count();
+            state.histogram_size = aggregate.get_histogram().size();
+            histogram.insert(histogram.end(), aggregate.get_histogram().begin(), aggregate.get_histogram().end());
+        } else {
+            state.package_count = stockpile.size();
+            for (const auto &package: stockpile) {
+                packages.push_back(package_record(stockpile, package, ids));
+            }
+            if (kind == StockpileKind::LOG) {
+                const auto &log = static_cast<const PackageLog &>(stockpile);
+                for (std::size_t i = 0; i < log.size(); ++i) {
+                    arrivals.push_back(log.arrival_time(i));
+                }
+            }
+        }
+        storehouses.push_back(state);
+    }
+
+    header.ramp_count = ramps.size();
+    header.worker_count = workers.size();
+    header.storehouse_count = storehouses.size();
+    header.package_count = packages.size();
+    header.arrival_count = arrivals.size();
+    header.histogram_count = histogram.size();
+    header.rng_state_size = rng_state.size();
+
+    os.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    write_records(os, ramps);
+    write_records(os, workers);
+    write_records(os, storehouses);
+    write_records(os, packages);
+    write_records(os, arrivals);
+    write_records(os, histogram);
+    os.write(rng_state.data(), static_cast<std::streamsize>(rng_state.size()));
+}
+
+void Factory::restore_checkpoint(std::istream &is) {
+    const std::string bytes((std::istreambuf_iterator<char>(is)), std::istreambuf_iterator<char>());
+    restore_checkpoint(bytes.data(), bytes.size());
+}
+
+void Factory::restore_checkpoint(const void *data, std::size_t size) {
+    const CheckpointSections sections = map_sections(static_cast<const unsigned char *>(data), size);
+    const Header &header = sections.header;
+
+    // Sprawdzenie zgodności ze strukturą - przed jakąkolwiek zmianą stanu fabryki.
+    if (header.ramp_count != ramps_.size() || header.worker_count != workers_.size() ||
+        header.storehouse_count != storehouses_.size()) {
+        throw_checkpoint_error("node counts do not match the factory");
+    }
+    if (header.time < 0) {
+        throw_checkpoint_error("negative turn");
+    }
+    if ((header.flags & kHasRoutingSeed) == 0 && routing_) {
+        throw_checkpoint_error("taken without a routing seed, but the factory has one");
+    }
+    std::uint64_t index = 0;
+    for (const auto &ramp: ramps_) {
+        if (sections.ramps[index].id != ramp.get_id()) {
+            throw_checkpoint_error("ramp " + std::to_string(index) + " does not match the factory");
+        }
+        ++index;
+    }
+    std::uint64_t packages = 0;
+    std::uint64_t arrivals = 0;
+    std::uint64_t histogram = 0;
+    auto count_packages = [&](std::uint64_t count) {
+        if (count > header.package_count - packages) {
+            throw_checkpoint_error("package table does not match node states");
+        }
+        packages += count;
+    };
+    index = 0;
+    for (const auto &worker: workers_) {
+        WorkerState state = sections.workers[index];
+        if (state.id != worker.get_id()) {
+            throw_checkpoint_error("worker " + std::to_string(index) + " does not match the factory");
+        }
+        count_packages(state.queue_size);
+        ++index;
+    }
+    index = 0;
+    for (const auto &storehouse: storehouses_) {
+        StorehouseState state = sections.storehouses[index];
+        const IPackageStockpile &stockpile = *storehouse.get_stockpile();
+        const auto kind = stockpile_kind(stockpile, storehouse.get_id());
+        if (state.id != storehouse.get_id() || state.stockpile_kind != static_cast<std::uint32_t>(kind)) {
+            throw_checkpoint_error("storehouse " + std::to_string(index) + " does not match the factory");
+        }
+        count_packages(state.package_count);
+        if (kind == StockpileKind::LOG) {
+            arrivals += state.package_count;
+        }
+        if (kind == StockpileKind::AGGREGATE) {
+            if (state.package_count != 0 || state.interval < 1 ||
+                state.histogram_size > static_cast<const AggregateStockpile &>(stockpile).get_max_buckets() ||
+                state.histogram_size > header.histogram_count - histogram) {
+                throw_checkpoint_error("invalid aggregate state in storehouse " + std::to_string(index));
+            }
+            histogram += state.histogram_size;
+        }
+        ++index;
+    }
+    if (packages != header.package_count || arrivals != header.arrival_count || histogram != header.histogram_count) {
+        throw_checkpoint_error("package table does not match node states");
+    }
+
+    // Rejestr ID budowany jest z zapisanych paczek - przy okazji wykrywa powtórzone identyfikatory.
+    PackageIDAllocator registry;
+    auto register_package = [&registry](PackageRecord record, bool may_be_empty) {
+        if (record.id == Package::kNoID && may_be_empty) {
+            return;
+        }
+        if (record.id <= 0 || (record.factory_domain != 0 && !registry.acquire(record.id))) {
+            throw_checkpoint_error("invalid or duplicate package ID " + std::to_string(record.id));
+        }
+    };
+    for (std::uint64_t i = 0; i < sections.ramps.size(); ++i) {
+        register_package(sections.ramps[i].sending, true);
+    }
+    for (std::uint64_t i = 0; i < sections.workers.size(); ++i) {
+        register_package(sections.workers[i].processing, true);
+        register_package(sections.workers[i].sending, true);
+    }
+    for (std::uint64_t i = 0; i < sections.packages.size(); ++i) {
+        register_package(sections.packages[i], false);
+    }
+    std::mt19937 restored_rng;
+    if ((header.flags & kHasRngState) != 0) {
+        std::istringstream iss(sections.rng_state);
+        if (!(iss >> restored_rng)) {
+            throw_checkpoint_error("invalid generator state");
+        }
+    }
+
+    // Usunięcie dotychczasowych paczek (ich ID wracają do starego rejestru, który zaraz zostanie zastąpiony).
+    for (auto &ramp: ramps_) {
+        ramp.set_sending_buffer(std::nullopt);
+    }
+    for (auto &worker: workers_) {
+        worker.get_queue()->clear();
+        worker.set_processing_buffer(std::nullopt, 0);
+        worker.set_sending_buffer(std::nullopt);
+    }
+    for (auto &storehouse: storehouses_) {
+        storehouse.get_stockpile()->clear();
+    }
+    registry.set_counters(static_cast<std::size_t>(header.id_allocations), static_cast<std::size_t>(header.id_releases));
+    // Przypisanie w miejscu - rampy i paczki trzymają wskaźnik na ten obiekt.
+    *package_ids_ = std::move(registry);
+
+    PackageIDAllocator &ids = *package_ids_;
+    auto make = [&ids](PackageRecord record) {
+        return record.factory_domain != 0 ? Package(ids, record.id) : Package(record.id);
+    };
+    auto make_optional = [&make](PackageRecord record) {
+        return record.id == Package::kNoID ? std::optional<Package>() : std::optional<Package>(make(record));
+    };
+
+    index = 0;
+    for (auto &ramp: ramps_) {
+        ramp.set_sending_buffer(make_optional(sections.ramps[index++].sending));
+    }
+    std::uint64_t package = 0;
+    index = 0;
+    for (auto &worker: workers_) {
+        WorkerState state = sections.workers[index++];
+        worker.set_processing_buffer(make_optional(state.processing), state.processing_start_time);
+        worker.set_sending_buffer(make_optional(state.sending));
+        IPackageQueue &queue = *worker.get_queue();
+        fill_queue(queue, queue.get_queue_type() == PackageQueueType::LIFO, sections.packages, package,
+                   state.queue_size, make);
+        package += state.queue_size;
+    }
+    std::uint64_t arrival = 0;
+    std::uint64_t bucket = 0;
+    index = 0;
+    for (auto &storehouse: storehouses_) {
+        StorehouseState state = sections.storehouses[index++];
+        IPackageStockpile &stockpile = *storehouse.get_stockpile();
+        switch (static_cast<StockpileKind>(state.stockpile_kind)) {
+            case StockpileKind::QUEUE_FIFO:
+            case StockpileKind::QUEUE_LIFO:
+                fill_queue(stockpile, state.stockpile_kind == static_cast<std::uint32_t>(StockpileKind::QUEUE_LIFO),
+                           sections.packages, package, state.package_count, make);
+                break;
+            case StockpileKind::LOG:
+                for (std::uint64_t i = 0; i < state.package_count; ++i) {
+                    stockpile.push_at(make(sections.packages[package + i]), sections.arrivals[arrival++]);
+                }
+                break;
+            case StockpileKind::AGGREGATE: {
+                std::vector<std::size_t> buckets(static_cast<std::size_t>(state.histogram_size));
+                for (auto &count: buckets) {
+                    count = static_cast<std::size_t>(sections.histogram[bucket++]);
+                }
+                static_cast<AggregateStockpile &>(stockpile).set_state(state.interval,
+                                                                      static_cast<std::size_t>(state.arrival_count),
+                                                                      std::move(buckets));
+                break;
+            }
+        }
+        package += state.package_count;
+    }
+
+    *time_ = header.time;
+    // Punkt kontrolny nie zapisuje liczników - liczenie zaczyna się od odtworzonej tury, bez sum sprzed cofnięcia.
+    reset_node_counters();
+    // Tabela śledzenia opisuje paczki sprzed cofnięcia (ID odtworzonych paczek mogą wskazywać cudze znaczniki),
+    // a histogramy - tury, które zostaną powtórzone: śledzenie zaczyna się od nowa, jak po włączeniu.
+    if (is_latency_tracking_enabled()) {
+        set_latency_tracking(false);
+        set_latency_tracking(true);
+    }
+    if ((header.flags & kHasRoutingSeed) != 0) {
+        set_routing_seed(header.routing_seed);
+        // Ponowne podpięcie zeruje liczniki losowań w turze - fabryka mogła już losować w turze, od której ruszy.
+        for (auto &ramp: ramps_) {
+            attach_random_source(ramp);
+        }
+        for (auto &worker: workers_) {
+            attach_random_source(worker);
+        }
+    }
+    if ((header.flags & kHasRngState) != 0) {
+        rng = restored_rng;
+    }
+}
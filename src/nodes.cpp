@@ -2,19 +2,104 @@
 // Created by Hyperbook on 15.01.2023.
 //
 
+#include <algorithm>
 #include <stdexcept>
 #include "nodes.hpp"
 
 IPackageReceiver *ReceiverPreferences::choose_receiver() {
-    double random = generator_();
-    double sum = 0;
-    for (auto &receiver : preferences_) {
-        sum += receiver.second;
-        if (random <= sum) {
-            return receiver.first;
+    if (preferences_.empty()) {
+        throw std::logic_error("No receiver chosen");
+    }
+    if (!alias_table_valid_) {
+        rebuild_alias_table();
+    }
+    const std::size_t k = alias_receivers_.size();
+    double scaled = next_random() * static_cast<double>(k);
+    std::size_t column = std::min(static_cast<std::size_t>(scaled), k - 1);
+    double fraction = scaled - static_cast<double>(column);
+    return fraction < alias_threshold_[column] ? alias_receivers_[column] : alias_receivers_[alias_[column]];
+}
+
+double ReceiverPreferences::next_random() {
+    if (random_source_ == nullptr) {
+        return generator_();
+    }
+    Time turn = random_source_->get_turn();
+    if (turn != draw_turn_) {
+        draw_turn_ = turn;
+        draw_index_ = 0;
+    }
+    return random_source_->uniform(random_stream_, draw_index_++);
+}
+
+void ReceiverPreferences::set_random_source(const RoutingRandomSource *source, std::uint64_t stream) {
+    random_source_ = source;
+    random_stream_ = stream;
+    draw_turn_ = 0;
+    draw_index_ = 0;
+    alias_table_valid_ = false;
+}
+
+void ReceiverPreferences::rebuild_alias_table() {
+    const std::size_t k = preferences_.size();
+    alias_receivers_.clear();
+    alias_threshold_.assign(k, 1.0);
+    alias_.resize(k);
+
+    double total = 0;
+    for (const auto &pref: preferences_) {
+        total += pref.second;
+    }
+
+    // Prawdopodobieństwa przeskalowane tak, by średnia wynosiła 1; kolumny poniżej 1 dopełniane są aliasem.
+    std::vector<double> scaled;
+    std::vector<std::size_t> small;
+    std::vector<std::size_t> large;
+    std::vector<const preferences_t::value_type *> columns;
+    columns.reserve(k);
+    for (const auto &pref: preferences_) {
+        columns.push_back(&pref);
+    }
+    if (random_source_ != nullptr) {
+        // Kolejność mapy zależy od adresów odbiorców - przy źródle licznikowym kolumny muszą być powtarzalne.
+        std::sort(columns.begin(), columns.end(), [](const auto *a, const auto *b) {
+#if (defined EXERCISE_ID && EXERCISE_ID != EXERCISE_ID_NODES)
+            return std::make_pair(a->first->get_receiver_type(), a->first->get_id()) <
+                   std::make_pair(b->first->get_receiver_type(), b->first->get_id());
+#else
+            return a->first->get_id() < b->first->get_id();
+#endif
+        });
+    }
+    scaled.reserve(k);
+    for (const auto *pref: columns) {
+        std::size_t i = alias_receivers_.size();
+        alias_receivers_.push_back(pref->first);
+        alias_[i] = i;
+        scaled.push_back(total > 0 ? pref->second * static_cast<double>(k) / total : 1.0);
+        (scaled.back() < 1.0 ? small : large).push_back(i);
+    }
+
+    while (!small.empty() && !large.empty()) {
+        std::size_t s = small.back();
+        small.pop_back();
+        std::size_t l = large.back();
+        alias_threshold_[s] = scaled[s];
+        alias_[s] = l;
+        scaled[l] -= 1.0 - scaled[s];
+        if (scaled[l] < 1.0) {
+            large.pop_back();
+            small.push_back(l);
         }
     }
-    throw std::logic_error("No receiver chosen");
+    // Pozostałe kolumny (także te, które zostały przez błędy zaokrągleń) wybierają wyłącznie siebie.
+    for (std::size_t i: small) {
+        alias_threshold_[i] = 1.0;
+    }
+    for (std::size_t i: large) {
+        alias_threshold_[i] = 1.0;
+    }
+    alias_table_valid_ = true;
 }
 
 void ReceiverPreferences::add_receiver(IPackageReceiver *receiver) {
@@ -22,7 +107,11 @@ void ReceiverPreferences::add_receiver(IPackageReceiver *receiver) {
     for (auto &pref : preferences_) {
         pref.second = prob;
     }
-    preferences_.insert({receiver, prob});
+    bool inserted = preferences_.insert({receiver, prob}).second;
+    alias_table_valid_ = false;
+    if (inserted && observer_ != nullptr) {
+        observer_->on_link_added(owner_, receiver);
+    }
 }
 
 void ReceiverPreferences::remove_receiver(IPackageReceiver *receiver) {
@@ -32,33 +121,89 @@ void ReceiverPreferences::remove_receiver(IPackageReceiver *receiver) {
         for (auto &pref: preferences_) {
             pref.second = prob;
         }
+        alias_table_valid_ = false;
+        if (observer_ != nullptr) {
+            observer_->on_link_removed(owner_, receiver);
+        }
+    }
+}
+
+void ReceiverPreferences::set_preferences(preferences_t preferences) {
+    if (observer_ != nullptr) {
+        for (const auto &pref: preferences_) {
+            if (preferences.find(pref.first) == preferences.end()) {
+                observer_->on_link_removed(owner_, pref.first);
+            }
+        }
+        for (const auto &pref: preferences) {
+            if (preferences_.find(pref.first) == preferences_.end()) {
+                observer_->on_link_added(owner_, pref.first);
+            }
+        }
     }
+    preferences_ = std::move(preferences);
+    alias_table_valid_ = false;
 }
 
-void PackageSender::send_package() {
+IPackageReceiver *PackageSender::send_package() {
     if (sending_buffer_.has_value()) {
         auto receiver = receiver_preferences_.choose_receiver();
         if (receiver != nullptr) {
-            receiver->receive_package(std::move(sending_buffer_.value()));
-            sending_buffer_.reset();
+            send_package_to(receiver);
         }
+        return receiver;
     }
+    return nullptr;
+}
+
+void PackageSender::send_package_to(IPackageReceiver *receiver) {
+    receiver->receive_package(std::move(sending_buffer_.value()));
+    sending_buffer_.reset();
+#if NETSIM_NODE_COUNTERS
+    if (counters_ != nullptr) {
+        ++counters_->sent;
+    }
+#endif
 }
 
 void Worker::do_work(Time t) {
+#if NETSIM_NODE_COUNTERS
+    if (counters_ != nullptr && sending_buffer_.has_value()) {
+        ++counters_->blocked_turns;
+    }
+#endif
     if(!current_package_.has_value() && !package_queue_->empty()){
         current_package_ = package_queue_->pop();
         package_processing_start_time_ = t;
     }
-    if(package_processing_start_time_+pd_ == t+1){
+    if(current_package_.has_value() && package_processing_start_time_+pd_ == t+1){
+        if (lifecycle_ != nullptr) {
+            lifecycle_->on_finished(current_package_->get_id(), package_processing_start_time_, t, *latency_);
+        }
         push_package(std::move(current_package_.value()));
         current_package_.reset();
+#if NETSIM_NODE_COUNTERS
+        if (counters_ != nullptr) {
+            // Tury sprzed podpięcia (lub wyzerowania) liczników nie są liczone.
+            counters_->busy_turns += static_cast<std::uint64_t>(
+                    t - std::max(package_processing_start_time_, counters_->since + 1) + 1);
+        }
+#endif
         package_processing_start_time_ = 0;
     }
 }
 
 void Ramp::deliver_goods(Time t) {
-    if ((t-1) % di_ == 0) {
-        push_package(Package());
+    if (is_delivery_turn(t)) {
+#if NETSIM_NODE_COUNTERS
+        if (counters_ != nullptr) {
+            ++counters_->received;
+            counters_->blocked_turns += sending_buffer_.has_value() ? 1 : 0;
+        }
+#endif
+        push_package(id_allocator_ != nullptr ? Package(*id_allocator_) : Package());
+        if (lifecycle_ != nullptr) {
+            lifecycle_->on_created(sending_buffer_->get_id(), t);
+        }
     }
 }
@@ -1,28 +1,22 @@
 #include "package.hpp"
 
-std::set<ElementID> Package::freed_IDs;
-std::set<ElementID> Package::assigned_IDs;
+PackageIDAllocator Package::default_id_allocator;
 
 Package &Package::operator=(Package &&package) noexcept {
-    id_ = package.id_;
-    return (*this);
-}
-
-Package::Package() {
-    if (Package::freed_IDs.empty()) {
-        if (Package::assigned_IDs.empty()) {
-            id_ = 1;
-        } else {
-            id_ = *(Package::assigned_IDs.rbegin()) + 1;
+    if (this != &package) {
+        if (allocator_ != nullptr) {
+            allocator_->release(id_);
         }
-    } else {
-        id_ = *Package::freed_IDs.begin();
-        Package::freed_IDs.erase(Package::freed_IDs.begin());
+        id_ = package.id_;
+        allocator_ = package.allocator_;
+        package.id_ = kNoID;
+        package.allocator_ = nullptr;
     }
-    Package::assigned_IDs.insert(id_);
+    return (*this);
 }
 
 Package::~Package() {
-    freed_IDs.insert(id_);
-    assigned_IDs.erase(id_);
+    if (allocator_ != nullptr) {
+        allocator_->release(id_);
+    }
 }
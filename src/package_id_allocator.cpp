@@ -0,0 +1,98 @@
+#include "package_id_allocator.hpp"
+
+namespace {
+    constexpr std::uint64_t kAllFree = ~std::uint64_t(0);
+
+    inline std::size_t lowest_set_bit(std::uint64_t word) {
+        return static_cast<std::size_t>(__builtin_ctzll(word));
+    }
+}
+
+ElementID PackageIDAllocator::allocate() {
+    ++allocation_count_;
+    if (levels_.empty() || levels_.back().front() == 0) {
+        grow();
+    }
+    // Zejście od korzenia zawsze najniższym ustawionym bitem daje najmniejszy wolny identyfikator.
+    std::size_t index = 0;
+    for (std::size_t level = levels_.size(); level-- > 0;) {
+        index = index * kWordBits + lowest_set_bit(levels_[level][index]);
+    }
+    mark_used(index);
+    ++assigned_count_;
+    return static_cast<ElementID>(index + 1);
+}
+
+void PackageIDAllocator::release(ElementID id) {
+    ++release_count_;
+    if (!is_assigned(id)) {
+        return;
+    }
+    mark_free(static_cast<std::size_t>(id - 1));
+    --assigned_count_;
+}
+
+bool PackageIDAllocator::acquire(ElementID id) {
+    if (id < 1 || is_assigned(id)) {
+        return false;
+    }
+    while (static_cast<std::size_t>(id) > capacity()) {
+        grow();
+    }
+    mark_used(static_cast<std::size_t>(id - 1));
+    ++assigned_count_;
+    return true;
+}
+
+bool PackageIDAllocator::is_assigned(ElementID id) const {
+    if (id < 1 || static_cast<std::size_t>(id) > capacity()) {
+        return false;
+    }
+    std::size_t bit = static_cast<std::size_t>(id - 1);
+    return (levels_.front()[bit / kWordBits] & (std::uint64_t(1) << (bit % kWordBits))) == 0;
+}
+
+void PackageIDAllocator::grow() {
+    std::size_t old_words = levels_.empty() ? 0 : levels_.front().size();
+    std::size_t new_words = old_words == 0 ? 1 : 2 * old_words;
+
+    std::vector<std::uint64_t> leaves = levels_.empty() ? std::vector<std::uint64_t>() : std::move(levels_.front());
+    leaves.resize(new_words, kAllFree);
+
+    // Podwajanie zakresu i przebudowa podsumowań kosztuje O(n), więc zamortyzowany koszt allocate() pozostaje stały.
+    levels_.clear();
+    levels_.push_back(std::move(leaves));
+    while (levels_.back().size() > 1) {
+        const auto &below = levels_.back();
+        std::vector<std::uint64_t> summary((below.size() + kWordBits - 1) / kWordBits, 0);
+        for (std::size_t i = 0; i < below.size(); ++i) {
+            if (below[i] != 0) {
+                summary[i / kWordBits] |= std::uint64_t(1) << (i % kWordBits);
+            }
+        }
+        levels_.push_back(std::move(summary));
+    }
+}
+
+void PackageIDAllocator::mark_used(std::size_t bit) {
+    for (auto &level: levels_) {
+        std::uint64_t &word = level[bit / kWordBits];
+        word &= ~(std::uint64_t(1) << (bit % kWordBits));
+        if (word != 0) {
+            return;
+        }
+        bit /= kWordBits;
+    }
+}
+
+void PackageIDAllocator::mark_free(std::size_t bit) {
+    for (auto &level: levels_) {
+        std::uint64_t &word = level[bit / kWordBits];
+        bool was_full = word == 0;
+        word |= std::uint64_t(1) << (bit % kWordBits);
+        if (!was_full) {
+            return;
+        }
+        bit /= kWordBits;
+    }
+}
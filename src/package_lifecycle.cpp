@@ -0,0 +1,141 @@
+#include "package_lifecycle.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    inline unsigned highest_set_bit(std::uint64_t value) {
+        return 63U - static_cast<unsigned>(__builtin_clzll(value));
+    }
+}
+
+std::size_t LatencyHistogram::bucket_of(std::uint64_t value) {
+    constexpr std::uint64_t sub_buckets = std::uint64_t(1) << kSubBucketBits;
+    if (value < 2 * sub_buckets) {
+        return static_cast<std::size_t>(value);
+    }
+    // Wartość z [2^e, 2^(e+1)) trafia do jednego z 16 kubełków tej potęgi według 4 bitów za najstarszym.
+    const unsigned e = highest_set_bit(value);
+    const std::uint64_t sub = (value >> (e - kSubBucketBits)) & (sub_buckets - 1);
+    return static_cast<std::size_t>(2 * sub_buckets + (e - kSubBucketBits - 1) * sub_buckets + sub);
+}
+
+std::uint64_t LatencyHistogram::bucket_upper_bound(std::size_t bucket) {
+    constexpr std::size_t sub_buckets = std::size_t(1) << kSubBucketBits;
+    if (bucket < 2 * sub_buckets) {
+        return bucket;
+    }
+    const std::size_t e = (bucket - 2 * sub_buckets) / sub_buckets + kSubBucketBits + 1;
+    const std::uint64_t sub = (bucket - 2 * sub_buckets) % sub_buckets;
+    return ((sub_buckets + sub + 1) << (e - kSubBucketBits)) - 1;
+}
+
+void LatencyHistogram::add(std::uint64_t value) {
+    const std::size_t bucket = bucket_of(value);
+    if (bucket >= buckets_.size()) {
+        buckets_.resize(bucket + 1, 0);
+    }
+    ++buckets_[bucket];
+    ++count_;
+    sum_ += value;
+    max_ = std::max(max_, value);
+}
+
+void LatencyHistogram::merge(const LatencyHistogram &other) {
+    if (other.buckets_.size() > buckets_.size()) {
+        buckets_.resize(other.buckets_.size(), 0);
+    }
+    for (std::size_t i = 0; i < other.buckets_.size(); ++i) {
+        buckets_[i] += other.buckets_[i];
+    }
+    count_ += other.count_;
+    sum_ += other.sum_;
+    max_ = std::max(max_, other.max_);
+}
+
+std::uint64_t LatencyHistogram::percentile(double q) const {
+    if (count_ == 0) {
+        return 0;
+    }
+    const auto rank = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(std::ceil(q * static_cast<double>(count_))));
+    std::uint64_t seen = 0;
+    for (std::size_t i = 0; i < buckets_.size(); ++i) {
+        seen += buckets_[i];
+        if (seen >= rank) {
+            return std::min(bucket_upper_bound(i), max_);
+        }
+    }
+    return max_;
+}
+
+void PackageLifecycleTracker::rebuild() {
+    std::size_t live = 0;
+    for (const Entry &entry: entries_) {
+        live += entry.id != 0 && !entry.stored;
+    }
+    std::size_t capacity = 16;
+    while (capacity < 4 * (live + 1)) {
+        capacity *= 2;
+    }
+    std::vector<Entry> previous(capacity);
+    previous.swap(entries_);
+    used_ = 0;
+    for (const Entry &entry: previous) {
+        if (entry.id == 0 || entry.stored) {
+            continue;
+        }
+        std::size_t slot = slot_of(entry.id);
+        while (entries_[slot].id != 0) {
+            slot = (slot + 1) & (entries_.size() - 1);
+        }
+        entries_[slot] = entry;
+        ++used_;
+    }
+}
+
+void PackageLifecycleTracker::on_created(ElementID id, Time t) {
+    if (id <= 0) {
+        return;
+    }
+    if (Entry *entry = find(id)) {
+        // ID zwolniony i przydzielony ponownie - wpis poprzedniej paczki jest nadpisywany.
+        *entry = Entry{id, t, kUnknown, false};
+        return;
+    }
+    if (2 * (used_ + 1) > entries_.size()) {
+        rebuild();
+    }
+    std::size_t slot = slot_of(id);
+    while (entries_[slot].id != 0) {
+        slot = (slot + 1) & (entries_.size() - 1);
+    }
+    entries_[slot] = Entry{id, t, kUnknown, false};
+    ++used_;
+}
+
+void PackageLifecycleTracker::on_enqueued(ElementID id) {
+    if (Entry *entry = find(id)) {
+        entry->enqueued = *clock_;
+    }
+}
+
+void PackageLifecycleTracker::on_finished(ElementID id, Time start, Time t, WorkerLatency &latency) {
+    const Entry *entry = find(id);
+    // Znacznik późniejszy niż początek przetwarzania jest nieaktualny (np. ID sprzed cofnięcia symulacji).
+    if (entry == nullptr || entry->enqueued == kUnknown || start < entry->enqueued) {
+        return;
+    }
+    latency.wait.add(static_cast<std::uint64_t>(start - entry->enqueued));
+    latency.sojourn.add(static_cast<std::uint64_t>(t - entry->enqueued + 1));
+}
+
+void PackageLifecycleTracker::on_stored(ElementID id, StorehouseLatency &latency) {
+    Entry *entry = find(id);
+    if (entry == nullptr) {
+        return;
+    }
+    if (entry->created != kUnknown && entry->created <= *clock_) {
+        latency.end_to_end.add(static_cast<std::uint64_t>(*clock_ - entry->created));
+    }
+    entry->stored = true;
+}
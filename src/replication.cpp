@@ -0,0 +1,151 @@
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <thread>
+#include "replication.hpp"
+#include "thread_pool.hpp"
+
+void RunningStatistic::add(double x) {
+    ++count_;
+    double delta = x - mean_;
+    mean_ += delta / static_cast<double>(count_);
+    m2_ += delta * (x - mean_);
+}
+
+void RunningStatistic::merge(const RunningStatistic &other) {
+    if (other.count_ == 0) {
+        return;
+    }
+    if (count_ == 0) {
+        *this = other;
+        return;
+    }
+    auto n_a = static_cast<double>(count_);
+    auto n_b = static_cast<double>(other.count_);
+    double delta = other.mean_ - mean_;
+    count_ += other.count_;
+    mean_ += delta * n_b / static_cast<double>(count_);
+    m2_ += other.m2_ + delta * delta * n_a * n_b / static_cast<double>(count_);
+}
+
+double RunningStatistic::variance() const {
+    return count_ > 1 ? m2_ / static_cast<double>(count_ - 1) : 0.0;
+}
+
+double RunningStatistic::stddev() const {
+    return std::sqrt(variance());
+}
+
+double RunningStatistic::confidence_half_width(double z) const {
+    return count_ > 0 ? z * stddev() / std::sqrt(static_cast<double>(count_)) : 0.0;
+}
+
+void ReplicationSummary::merge(const ReplicationSummary &other) {
+    replications += other.replications;
+    plant_throughput.merge(other.plant_throughput);
+    for (std::size_t i = 0; i < workers.size(); ++i) {
+        workers[i].throughput.merge(other.workers[i].throughput);
+        workers[i].mean_queue_length.merge(other.workers[i].mean_queue_length);
+        workers[i].max_queue_length.merge(other.workers[i].max_queue_length);
+    }
+    for (std::size_t i = 0; i < storehouses.size(); ++i) {
+        storehouses[i].stored.merge(other.storehouses[i].stored);
+    }
+}
+
+namespace {
+    ReplicationSummary empty_summary(const Factory &prototype) {
+        ReplicationSummary summary;
+        for (auto it = prototype.worker_cbegin(); it != prototype.worker_cend(); ++it) {
+            summary.workers.push_back({it->get_id(), {}, {}, {}});
+        }
+        for (auto it = prototype.storehouse_cbegin(); it != prototype.storehouse_cend(); ++it) {
+            summary.storehouses.push_back({it->get_id(), {}});
+        }
+        return summary;
+    }
+
+    /**
+     * Liczniki jednej replikacji; wielokrotnego użytku w obrębie wątku.
+     */
+    struct ReplicationCounters {
+        std::vector<const Worker *> workers;
+        std::vector<std::size_t> completed;
+        std::vector<std::size_t> queue_length_sum;
+        std::vector<std::size_t> max_queue_length;
+
+        void reset(const Factory &factory) {
+            workers.clear();
+            for (auto it = factory.worker_cbegin(); it != factory.worker_cend(); ++it) {
+                workers.push_back(&*it);
+            }
+            completed.assign(workers.size(), 0);
+            queue_length_sum.assign(workers.size(), 0);
+            max_queue_length.assign(workers.size(), 0);
+        }
+
+        void sample_turn() {
+            for (std::size_t i = 0; i < workers.size(); ++i) {
+                // Po fazie przetworzenia bufor nadawczy jest pełny tylko wtedy, gdy robotnik właśnie skończył paczkę.
+                if (workers[i]->get_sending_buffer().has_value()) {
+                    ++completed[i];
+                }
+                std::size_t length = workers[i]->get_queue()->size();
+                queue_length_sum[i] += length;
+                max_queue_length[i] = std::max(max_queue_length[i], length);
+            }
+        }
+    };
+
+    void run_replication(const Factory &prototype, const ReplicationOptions &options, std::size_t replication,
+                         ReplicationCounters &counters, ReplicationSummary &summary) {
+        Factory factory = clone_factory_structure(prototype);
+        factory.set_routing_seed(options.base_seed + replication);
+        counters.reset(factory);
+        simulate(factory, options.turns, [&counters](Factory &, Time) { counters.sample_turn(); }, options.engine);
+
+        const auto turns = static_cast<double>(options.turns);
+        for (std::size_t i = 0; i < counters.workers.size(); ++i) {
+            auto &worker = summary.workers[i];
+            worker.throughput.add(static_cast<double>(counters.completed[i]) / turns);
+            worker.mean_queue_length.add(static_cast<double>(counters.queue_length_sum[i]) / turns);
+            worker.max_queue_length.add(static_cast<double>(counters.max_queue_length[i]));
+        }
+        std::size_t delivered = 0;
+        std::size_t i = 0;
+        for (auto it = factory.storehouse_cbegin(); it != factory.storehouse_cend(); ++it, ++i) {
+            std::size_t stored = it->get_stored_count();
+            summary.storehouses[i].stored.add(static_cast<double>(stored));
+            delivered += stored;
+        }
+        summary.plant_throughput.add(static_cast<double>(delivered) / turns);
+        ++summary.replications;
+    }
+}
+
+ReplicationSummary run_replications(const Factory &prototype, const ReplicationOptions &options) {
+    if (!prototype.is_consistent()) {
+        throw std::logic_error("Factory is not consistent");
+    }
+    if (options.turns <= 0) {
+        throw std::invalid_argument("Number of turns must be positive");
+    }
+    std::size_t threads = options.threads != 0 ? options.threads : std::max(1U, std::thread::hardware_concurrency());
+    threads = std::max<std::size_t>(1, std::min(threads, options.replications));
+
+    // Każdy wątek ma własną sumę częściową; scalanie w kolejności fragmentów daje wynik zależny tylko od liczby wątków.
+    std::vector<ReplicationSummary> partial(threads, empty_summary(prototype));
+    ThreadPool pool(threads);
+    pool.parallel_for(options.replications, [&](std::size_t begin, std::size_t end, std::size_t chunk) {
+        ReplicationCounters counters;
+        for (std::size_t r = begin; r < end; ++r) {
+            run_replication(prototype, options, r, counters, partial[chunk]);
+        }
+    });
+
+    ReplicationSummary summary = empty_summary(prototype);
+    for (const auto &part: partial) {
+        summary.merge(part);
+    }
+    return summary;
+}
@@ -0,0 +1,451 @@
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+#include "reports.hpp"
+
+namespace {
+    void print_receivers(const ReceiverPreferences &preferences, std::ostream &os) {
+        std::vector<const IPackageReceiver *> receivers;
+        for (const auto &receiver: preferences) {
+            receivers.push_back(receiver.first);
+        }
+        // Magazyny przed robotnikami, w obrębie typu rosnąco według ID.
+        std::sort(receivers.begin(), receivers.end(), [](const IPackageReceiver *a, const IPackageReceiver *b) {
+            return std::make_pair(RECEIVER_TYPE_NAMES.at(a->get_receiver_type()), a->get_id()) <
+                   std::make_pair(RECEIVER_TYPE_NAMES.at(b->get_receiver_type()), b->get_id());
+        });
+        os << "  Receivers:\n";
+        for (const auto *receiver: receivers) {
+            os << "    " << RECEIVER_TYPE_NAMES.at(receiver->get_receiver_type()) << " #" << receiver->get_id() << "\n";
+        }
+    }
+
+    /**
+     * Dopisuje ID paczek z pozycji [first, last) w kolejności iteracji - po fragmentach, bez przechodzenia
+     * przez pominięte paczki.
+     */
+    void append_ids(const IPackageStockpile &stockpile, std::size_t first, std::size_t last, std::vector<ElementID> &out) {
+        std::size_t pos = 0;
+        for (std::size_t i = 0; i < stockpile.segment_count() && pos < last; ++i) {
+            PackageSpan span = stockpile.segment(i);
+            auto length = static_cast<std::size_t>(span.end - span.begin);
+            for (std::size_t k = std::max(first, pos); k < std::min(last, pos + length); ++k) {
+                out.push_back(span.begin[k - pos].get_id());
+            }
+            pos += length;
+        }
+    }
+
+    /**
+     * Wypisuje ID z zakresu; id rzutuje element zakresu na ID paczki.
+     */
+    template<class It, class Projection>
+    void print_ids(It begin, It end, std::ostream &os, Projection id) {
+        if (begin == end) {
+            os << "(empty)";
+            return;
+        }
+        os << "#" << id(*begin);
+        for (++begin; begin != end; ++begin) {
+            os << ", #" << id(*begin);
+        }
+    }
+
+    template<class It>
+    void print_ids(It begin, It end, std::ostream &os) {
+        print_ids(begin, end, os, [](ElementID id) { return id; });
+    }
+
+    ElementID package_id(const Package &package) { return package.get_id(); }
+}
+
+void generate_structure_report(const Factory &f, std::ostream &os) {
+    os << "\n" << "== LOADING RAMPS ==" << "\n\n";
+    for (const Ramp *ramp: sorted_by_id<Ramp>(f.ramp_cbegin(), f.ramp_cend())) {
+        os << "LOADING RAMP #" << ramp->get_id() << "\n";
+        os << "  Delivery interval: " << ramp->get_delivery_interval() << "\n";
+        print_receivers(ramp->receiver_preferences_, os);
+        os << "\n";
+    }
+
+    os << "\n" << "== WORKERS ==" << "\n\n";
+    for (const Worker *worker: sorted_by_id<Worker>(f.worker_cbegin(), f.worker_cend())) {
+        os << "WORKER #" << worker->get_id() << "\n";
+        os << "  Processing time: " << worker->get_processing_duration() << "\n";
+        os << "  Queue type: " << queue_type_name(worker->get_queue()->get_queue_type()) << "\n";
+        print_receivers(worker->receiver_preferences_, os);
+        os << "\n";
+    }
+
+    os << "\n" << "== STOREHOUSES ==" << "\n\n";
+    for (const Storehouse *storehouse: sorted_by_id<Storehouse>(f.storehouse_cbegin(), f.storehouse_cend())) {
+        os << "STOREHOUSE #" << storehouse->get_id() << "\n";
+        if (storehouse->is_aggregate()) {
+            os << "  Stock mode: aggregate" << "\n";
+        }
+        os << "\n";
+    }
+
+    // Ziarno pozwala odtworzyć przebieg z raportu (trasy zależą tylko od ziarna i struktury).
+    if (auto seed = f.get_routing_seed()) {
+        os << "\n" << "== ROUTING ==" << "\n\n";
+        os << "Seed: " << *seed << "\n";
+    }
+
+    os.flush();
+}
+
+void generate_simulation_turn_report(const Factory &f, std::ostream &os, Time t) {
+    os << "=== [ Turn: " << t << " ] ===" << "\n\n";
+
+    os << "== WORKERS ==" << "\n\n";
+    for (const Worker *worker: sorted_by_id<Worker>(f.worker_cbegin(), f.worker_cend())) {
+        os << "WORKER #" << worker->get_id() << "\n";
+
+        os << "  PBuffer: ";
+        const auto &processing = worker->get_processing_buffer();
+        if (processing.has_value()) {
+            os << "#" << processing->get_id() << " (pt = " << t - worker->get_package_processing_start_time() + 1
+               << ")";
+        } else {
+            os << "(empty)";
+        }
+        os << "\n";
+
+        os << "  Queue: ";
+        print_ids(worker->cbegin(), worker->cend(), os, package_id);
+        os << "\n";
+
+        os << "  SBuffer: ";
+        const auto &sending = worker->get_sending_buffer();
+        if (sending.has_value()) {
+            os << "#" << sending->get_id();
+        } else {
+            os << "(empty)";
+        }
+        os << "\n\n";
+    }
+
+    os << "\n" << "== STOREHOUSES ==" << "\n\n";
+    for (const Storehouse *storehouse: sorted_by_id<Storehouse>(f.storehouse_cbegin(), f.storehouse_cend())) {
+        os << "STOREHOUSE #" << storehouse->get_id() << "\n";
+        os << "  Stock: ";
+        if (storehouse->is_aggregate()) {
+            os << storehouse->get_stored_count() << " package(s) (aggregated)";
+        } else {
+            print_ids(storehouse->cbegin(), storehouse->cend(), os, package_id);
+        }
+        os << "\n\n";
+    }
+
+    os.flush();
+}
+
+namespace {
+    const char *counter_node_type(ElementType type) {
+        switch (type) {
+            case ElementType::RAMP:
+                return "ramp";
+            case ElementType::WORKER:
+                return "worker";
+            case ElementType::STOREHOUSE:
+                return "storehouse";
+            default:
+                return "link";
+        }
+    }
+
+    /**
+     * Rodzina metryk OpenMetrics: nazwa, typ, opis i pole rekordu
+     */
+    struct CounterMetric {
+        const char *name;
+        const char *type;
+        const char *help;
+        std::uint64_t (*value)(const NodeCounterRecord &);
+    };
+
+    const CounterMetric kCounterMetrics[] = {
+            {"netsim_node_packages_received", "counter", "Packages received by the node (ramps: delivered).",
+             [](const NodeCounterRecord &r) { return r.counters.received; }},
+            {"netsim_node_packages_sent", "counter", "Packages passed on to a receiver.",
+             [](const NodeCounterRecord &r) { return r.counters.sent; }},
+            {"netsim_node_busy_turns", "counter", "Turns spent processing a package.",
+             [](const NodeCounterRecord &r) { return r.counters.busy_turns; }},
+            {"netsim_node_idle_turns", "counter", "Turns of a worker without a package in processing.",
+             [](const NodeCounterRecord &r) { return r.idle_turns; }},
+            {"netsim_node_blocked_turns", "counter", "Turns blocked by a package left in the sending buffer.",
+             [](const NodeCounterRecord &r) { return r.counters.blocked_turns; }},
+            {"netsim_node_max_queue_depth", "gauge", "Maximum number of packages in the worker queue.",
+             [](const NodeCounterRecord &r) { return r.counters.max_queue_depth; }},
+    };
+}
+
+void write_node_counters_csv(const Factory &f, std::ostream &os) {
+    os << "type,id,received,sent,busy_turns,idle_turns,blocked_turns,max_queue_depth,since\n";
+    for (const auto &r: f.get_node_counters()) {
+        os << counter_node_type(r.type) << "," << r.id << "," << r.counters.received << "," << r.counters.sent << ","
+           << r.counters.busy_turns << "," << r.idle_turns << "," << r.counters.blocked_turns << ","
+           << r.counters.max_queue_depth << "," << r.counters.since << "\n";
+    }
+}
+
+void write_node_counters_json(const Factory &f, std::ostream &os) {
+    os << "{\"time\": " << f.get_time() << ", \"nodes\": [";
+    const char *separator = "\n";
+    for (const auto &r: f.get_node_counters()) {
+        os << separator << "  {\"type\": \"" << counter_node_type(r.type) << "\", \"id\": " << r.id
+           << ", \"received\": " << r.counters.received << ", \"sent\": " << r.counters.sent
+           << ", \"busy_turns\": " << r.counters.busy_turns << ", \"idle_turns\": " << r.idle_turns
+           << ", \"blocked_turns\": " << r.counters.blocked_turns
+           << ", \"max_queue_depth\": " << r.counters.max_queue_depth << ", \"since\": " << r.counters.since << "}";
+        separator = ",\n";
+    }
+    os << "\n]}\n";
+}
+
+void write_node_counters_openmetrics(const Factory &f, std::ostream &os) {
+    const std::vector<NodeCounterRecord> records = f.get_node_counters();
+    for (const CounterMetric &metric: kCounterMetrics) {
+        const bool counter = std::string_view(metric.type) == "counter";
+        os << "# TYPE " << metric.name << " " << metric.type << "\n";
+        os << "# HELP " << metric.name << " " << metric.help << "\n";
+        for (const auto &r: records) {
+            os << metric.name << (counter ? "_total" : "") << "{type=\"" << counter_node_type(r.type)
+               << "\",id=\"" << r.id << "\"} " << metric.value(r) << "\n";
+        }
+    }
+    os << "# EOF\n";
+}
+
+namespace {
+    void write_latency_row(std::ostream &os, const char *type, ElementID id, const char *metric,
+                           const LatencyHistogram &h) {
+        os << type << "," << id << "," << metric << "," << h.count() << "," << h.mean() << "," << h.percentile(0.5)
+           << "," << h.percentile(0.99) << "," << h.percentile(0.999) << "," << h.max() << "\n";
+    }
+}
+
+void write_latency_percentiles_csv(const Factory &f, std::ostream &os) {
+    os << "type,id,metric,count,mean,p50,p99,p999,max\n";
+    if (!f.is_latency_tracking_enabled()) {
+        return;
+    }
+    for (auto it = f.worker_cbegin(); it != f.worker_cend(); ++it) {
+        write_latency_row(os, "worker", it->get_id(), "wait", it->get_latency()->wait);
+        write_latency_row(os, "worker", it->get_id(), "sojourn", it->get_latency()->sojourn);
+    }
+    LatencyHistogram plant;
+    for (auto it = f.storehouse_cbegin(); it != f.storehouse_cend(); ++it) {
+        write_latency_row(os, "storehouse", it->get_id(), "end_to_end", it->get_latency()->end_to_end);
+        plant.merge(it->get_latency()->end_to_end);
+    }
+    write_latency_row(os, "plant", 0, "end_to_end", plant);
+}
+
+AsyncTurnReportWriter::AsyncTurnReportWriter(const Factory &f, std::ostream &os, std::size_t buffered_turns)
+        : os_(os), workers_(sorted_by_id<Worker>(f.worker_cbegin(), f.worker_cend())),
+          storehouses_(sorted_by_id<Storehouse>(f.storehouse_cbegin(), f.storehouse_cend())),
+          slots_(std::max<std::size_t>(buffered_turns, 1)) {
+    for (const Storehouse *storehouse: storehouses_) {
+        const IPackageStockpile *stockpile = storehouse->get_stockpile();
+        StockMode mode = StockMode::FULL;
+        if (storehouse->is_aggregate()) {
+            mode = StockMode::AGGREGATE;
+        } else if (dynamic_cast<const PackageLog *>(stockpile) != nullptr) {
+            mode = StockMode::APPEND;
+        } else if (auto queue = dynamic_cast<const IPackageQueue *>(stockpile)) {
+            mode = queue->get_queue_type() == PackageQueueType::LIFO ? StockMode::PREPEND : StockMode::APPEND;
+        }
+        stock_modes_.push_back(mode);
+    }
+    captured_stock_.assign(storehouses_.size(), 0);
+    stock_mirror_.resize(storehouses_.size());
+    writer_ = std::thread(&AsyncTurnReportWriter::write_loop, this);
+}
+
+AsyncTurnReportWriter::~AsyncTurnReportWriter() {
+    try {
+        close();
+    } catch (...) {
+    }
+}
+
+void AsyncTurnReportWriter::capture(Time t) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    slot_freed_.wait(lock, [this] { return filled_ < slots_.size() || error_ || closing_; });
+    if (error_) {
+        std::rethrow_exception(error_);
+    }
+    if (closing_) {
+        throw std::logic_error("Report writer is closed");
+    }
+    Snapshot &slot = slots_[head_];
+    lock.unlock();
+
+    // Slot należy do wątku symulacji, dopóki nie zostanie opublikowany - kopiowanie bez blokady.
+    slot.turn = t;
+    auto &values = slot.values;
+    values.clear();
+    for (const Worker *worker: workers_) {
+        const auto &processing = worker->get_processing_buffer();
+        values.push_back(processing.has_value() ? processing->get_id() : Package::kNoID);
+        values.push_back(t - worker->get_package_processing_start_time() + 1);
+        const auto &sending = worker->get_sending_buffer();
+        values.push_back(sending.has_value() ? sending->get_id() : Package::kNoID);
+        const IPackageQueue &queue = *worker->get_queue();
+        values.push_back(static_cast<ElementID>(queue.size()));
+        append_ids(queue, 0, queue.size(), values);
+    }
+    for (std::size_t i = 0; i < storehouses_.size(); ++i) {
+        const IPackageStockpile &stockpile = *storehouses_[i]->get_stockpile();
+        std::size_t size = stockpile.size();
+        switch (stock_modes_[i]) {
+            case StockMode::AGGREGATE:
+                values.push_back(static_cast<ElementID>(storehouses_[i]->get_stored_count()));
+                break;
+            case StockMode::APPEND:
+                values.push_back(static_cast<ElementID>(size - captured_stock_[i]));
+                append_ids(stockpile, captured_stock_[i], size, values);
+                captured_stock_[i] = size;
+                break;
+            case StockMode::PREPEND:
+                values.push_back(static_cast<ElementID>(size - captured_stock_[i]));
+                append_ids(stockpile, 0, size - captured_stock_[i], values);
+                captured_stock_[i] = size;
+                break;
+            case StockMode::FULL:
+                values.push_back(static_cast<ElementID>(size));
+                append_ids(stockpile, 0, size, values);
+                break;
+        }
+    }
+
+    lock.lock();
+    head_ = (head_ + 1) % slots_.size();
+    ++filled_;
+    lock.unlock();
+    slot_filled_.notify_one();
+}
+
+void AsyncTurnReportWriter::close() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closing_ = true;
+    }
+    slot_filled_.notify_one();
+    if (writer_.joinable()) {
+        writer_.join();
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (error_) {
+        std::exception_ptr error = error_;
+        error_ = nullptr;
+        std::rethrow_exception(error);
+    }
+}
+
+void AsyncTurnReportWriter::write_loop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        if (filled_ == 0) {
+            if (closing_) {
+                break;
+            }
+            // Brak zaległych tur - dobry moment na opróżnienie strumienia.
+            lock.unlock();
+            os_.flush();
+            lock.lock();
+            slot_filled_.wait(lock, [this] { return filled_ > 0 || closing_; });
+            continue;
+        }
+        const Snapshot &slot = slots_[(head_ + slots_.size() - filled_) % slots_.size()];
+        lock.unlock();
+        try {
+            format(slot);
+            if (!os_) {
+                throw std::runtime_error("Writing the turn report failed");
+            }
+        } catch (...) {
+            lock.lock();
+            error_ = std::current_exception();
+            lock.unlock();
+            slot_freed_.notify_all();
+            return;
+        }
+        lock.lock();
+        --filled_;
+        slot_freed_.notify_one();
+    }
+    lock.unlock();
+    os_.flush();
+}
+
+void AsyncTurnReportWriter::format(const Snapshot &snapshot) {
+    const Time t = snapshot.turn;
+    auto value = snapshot.values.cbegin();
+    os_ << "=== [ Turn: " << t << " ] ===" << "\n\n";
+
+    os_ << "== WORKERS ==" << "\n\n";
+    for (const Worker *worker: workers_) {
+        os_ << "WORKER #" << worker->get_id() << "\n";
+        ElementID processing = *value++;
+        ElementID pt = *value++;
+        ElementID sending = *value++;
+        auto queue_length = static_cast<std::size_t>(*value++);
+
+        os_ << "  PBuffer: ";
+        if (processing != Package::kNoID) {
+            os_ << "#" << processing << " (pt = " << pt << ")";
+        } else {
+            os_ << "(empty)";
+        }
+        os_ << "\n";
+
+        os_ << "  Queue: ";
+        print_ids(value, value + static_cast<std::ptrdiff_t>(queue_length), os_);
+        value += static_cast<std::ptrdiff_t>(queue_length);
+        os_ << "\n";
+
+        os_ << "  SBuffer: ";
+        if (sending != Package::kNoID) {
+            os_ << "#" << sending;
+        } else {
+            os_ << "(empty)";
+        }
+        os_ << "\n\n";
+    }
+
+    os_ << "\n" << "== STOREHOUSES ==" << "\n\n";
+    for (std::size_t i = 0; i < storehouses_.size(); ++i) {
+        os_ << "STOREHOUSE #" << storehouses_[i]->get_id() << "\n";
+        os_ << "  Stock: ";
+        auto count = static_cast<std::size_t>(*value++);
+        auto &mirror = stock_mirror_[i];
+        switch (stock_modes_[i]) {
+            case StockMode::AGGREGATE:
+                os_ << count << " package(s) (aggregated)";
+                break;
+            case StockMode::APPEND:
+                mirror.insert(mirror.end(), value, value + static_cast<std::ptrdiff_t>(count));
+                print_ids(mirror.cbegin(), mirror.cend(), os_);
+                break;
+            case StockMode::PREPEND:
+                // Nowe paczki przychodzą od najnowszej - w lustrze trzymana jest kolejność przybycia.
+                mirror.insert(mirror.end(), std::make_reverse_iterator(value + static_cast<std::ptrdiff_t>(count)),
+                              std::make_reverse_iterator(value));
+                print_ids(mirror.crbegin(), mirror.crend(), os_);
+                break;
+            case StockMode::FULL:
+                mirror.assign(value, value + static_cast<std::ptrdiff_t>(count));
+                print_ids(mirror.cbegin(), mirror.cend(), os_);
+                break;
+        }
+        if (stock_modes_[i] != StockMode::AGGREGATE) {
+            value += static_cast<std::ptrdiff_t>(count);
+        }
+        os_ << "\n\n";
+    }
+}
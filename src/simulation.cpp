@@ -0,0 +1,206 @@
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "simulation.hpp"
+
+namespace {
+    using Event = std::pair<Time, std::size_t>;
+    using EventQueue = std::priority_queue<Event, std::vector<Event>, std::greater<Event>>;
+
+    void simulate_turn_based(Factory &f, Time first, Time last, const std::function<void(Factory &, Time)> &rf) {
+        for (Time t = first; t <= last; ++t) {
+            f.do_deliveries(t);
+            f.do_package_passing();
+            f.do_work(t);
+            if (rf) {
+                rf(f, t);
+            }
+        }
+    }
+
+    class EventDrivenSimulation {
+        /*!
+         * EventDrivenSimulation
+         * - odtwarza dokładnie kolejność wywołań symulacji turowej (dostawy ramp w kolejności listy,
+         *   przekazywanie: najpierw rampy, potem robotnicy w kolejności listy, na końcu przetwarzanie),
+         *   ale tylko dla węzłów, których coś dotyczy w danej turze
+         * - zdarzenia czasowe (dostawy ramp i zakończenia przetwarzania) trzymane są w kopcach (tura, indeks węzła),
+         *   zdarzenia wynikające z przekazywania (pełny bufor nadawczy, paczka w kolejce) zbierane są na bieżąco
+         * - tury bez żadnego zdarzenia są pomijane (rf jest dla nich nadal wywoływane)
+         * - symulacja może zacząć się od dowolnej tury (kontynuacja, np. po odtworzeniu punktu kontrolnego)
+         */
+    public:
+        EventDrivenSimulation(Factory &f, Time first) : factory_(f) {
+            // Indeks w wektorze = pozycja na liście fabryki, więc sortowanie indeksów odtwarza kolejność turową.
+            for (auto it = f.ramp_begin(); it != f.ramp_end(); ++it) {
+                ramps_.push_back(&*it);
+            }
+            for (auto it = f.worker_begin(); it != f.worker_end(); ++it) {
+                worker_index_.emplace(&*it, workers_.size());
+                workers_.push_back(&*it);
+            }
+            for (std::size_t i = 0; i < ramps_.size(); ++i) {
+                // Pierwsza tura dostawy >= first (dostawy przypadają w turach 1, 1 + di, 1 + 2 di, ...).
+                TimeOffset di = ramps_[i]->get_delivery_interval();
+                TimeOffset since_last = (first - 1) % di;
+                deliveries_.emplace(since_last == 0 ? first : first + di - since_last, i);
+            }
+            // Stan początkowy może zawierać paczki (np. fabryka po wcześniejszej symulacji).
+            for (std::size_t i = 0; i < workers_.size(); ++i) {
+                const Worker &worker = *workers_[i];
+                if (worker.get_sending_buffer().has_value()) {
+                    pending_senders_.push_back(i);
+                }
+                if (worker.get_processing_buffer().has_value()) {
+                    schedule_completion(i, worker.get_package_processing_start_time(), first);
+                } else if (!worker.get_queue()->empty()) {
+                    due_workers_.push_back(i);
+                }
+            }
+        }
+
+        void run(Time first, Time last, const std::function<void(Factory &, Time)> &rf) {
+            Time t = next_event_time(first);
+            for (Time skipped = first; skipped < std::min(t, last + 1); ++skipped) {
+                report(rf, skipped);
+            }
+            while (t <= last) {
+                turn(t);
+                report(rf, t);
+                Time next = next_event_time(t + 1);
+                for (Time skipped = t + 1; skipped < std::min(next, last + 1); ++skipped) {
+                    report(rf, skipped);
+                }
+                t = next;
+            }
+        }
+
+    private:
+        void report(const std::function<void(Factory &, Time)> &rf, Time t) {
+            // Tura pominięta też upływa - fabryka kończy na ostatniej turze (kontynuacja, liczniki bezczynności).
+            factory_.set_time(t);
+            if (rf) {
+                rf(factory_, t);
+            }
+        }
+
+        Time next_event_time(Time earliest) const {
+            if (!pending_senders_.empty() || !due_workers_.empty()) {
+                return earliest;
+            }
+            Time next = std::numeric_limits<Time>::max();
+            if (!deliveries_.empty()) {
+                next = std::min(next, deliveries_.top().first);
+            }
+            if (!completions_.empty()) {
+                next = std::min(next, completions_.top().first);
+            }
+            return std::max(next, earliest);
+        }
+
+        void turn(Time t) {
+            factory_.set_time(t);
+
+            // Dostawa
+            std::vector<std::size_t> delivering_ramps;
+            while (!deliveries_.empty() && deliveries_.top().first == t) {
+                std::size_t i = deliveries_.top().second;
+                deliveries_.pop();
+                ramps_[i]->deliver_goods(t);
+                delivering_ramps.push_back(i);
+                deliveries_.emplace(t + ramps_[i]->get_delivery_interval(), i);
+            }
+
+            // Przekazanie półproduktów
+            std::sort(delivering_ramps.begin(), delivering_ramps.end());
+            for (std::size_t i: delivering_ramps) {
+                mark_receiver(ramps_[i]->send_package());
+            }
+            std::vector<std::size_t> senders;
+            senders.swap(pending_senders_);
+            std::sort(senders.begin(), senders.end());
+            for (std::size_t i: senders) {
+                mark_receiver(workers_[i]->send_package());
+                // Po wysłaniu pracownik jest wolny - może pobrać kolejną paczkę z kolejki.
+                due_workers_.push_back(i);
+            }
+
+            // Przetworzenie
+            while (!completions_.empty() && completions_.top().first == t) {
+                due_workers_.push_back(completions_.top().second);
+                completions_.pop();
+            }
+            std::vector<std::size_t> due;
+            due.swap(due_workers_);
+            std::sort(due.begin(), due.end());
+            due.erase(std::unique(due.begin(), due.end()), due.end());
+            for (std::size_t i: due) {
+                Worker &worker = *workers_[i];
+                worker.do_work(t);
+                if (worker.get_processing_buffer().has_value() && worker.get_package_processing_start_time() == t) {
+                    schedule_completion(i, t, t + 1);
+                }
+                if (worker.get_sending_buffer().has_value()) {
+                    pending_senders_.push_back(i);
+                }
+            }
+        }
+
+        /**
+         * @brief Planuje zakończenie przetwarzania (tura start + pd - 1), o ile nastąpi ono nie wcześniej niż w turze earliest
+         */
+        void schedule_completion(std::size_t i, Time start, Time earliest) {
+            Time done = start + workers_[i]->get_processing_duration() - 1;
+            if (done >= earliest) {
+                completions_.emplace(done, i);
+            }
+        }
+
+        void mark_receiver(IPackageReceiver *receiver) {
+            auto it = worker_index_.find(receiver);
+            if (it != worker_index_.end()) {
+                due_workers_.push_back(it->second);
+            }
+        }
+
+        Factory &factory_;
+        std::vector<Ramp *> ramps_;
+        std::vector<Worker *> workers_;
+        std::unordered_map<const IPackageReceiver *, std::size_t> worker_index_;
+        EventQueue deliveries_;
+        EventQueue completions_;
+        std::vector<std::size_t> pending_senders_;
+        std::vector<std::size_t> due_workers_;
+    };
+}
+
+namespace {
+    void run_turns(Factory &f, Time first, Time last, const std::function<void(Factory &, Time)> &rf,
+                   SimulationEngine engine) {
+        if (!f.is_consistent()) {
+            throw std::logic_error("Factory is not consistent");
+        }
+        switch (engine) {
+            case SimulationEngine::TURN_BASED:
+                simulate_turn_based(f, first, last, rf);
+                break;
+            case SimulationEngine::EVENT_DRIVEN:
+                EventDrivenSimulation(f, first).run(first, last, rf);
+                break;
+        }
+    }
+}
+
+void simulate(Factory &f, TimeOffset d, std::function<void(Factory &, Time)> rf, SimulationEngine engine) {
+    run_turns(f, 1, static_cast<Time>(d), rf, engine);
+}
+
+void resume_simulation(Factory &f, TimeOffset d, std::function<void(Factory &, Time)> rf, SimulationEngine engine) {
+    const Time first = f.get_time() + 1;
+    run_turns(f, first, first + static_cast<Time>(d) - 1, rf, engine);
+}
@@ -1,29 +1,331 @@
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <new>
+#include <utility>
 #include "storage_types.hpp"
 
+void IPackageStockpile::const_iterator::enter_segment(std::size_t segment) {
+    std::size_t count = stockpile_->segment_count();
+    for (segment_ = segment; segment_ < count; ++segment_) {
+        PackageSpan span = stockpile_->segment(segment_);
+        if (span.begin != span.end) {
+            pos_ = span.begin;
+            segment_end_ = span.end;
+            return;
+        }
+    }
+    pos_ = nullptr;
+    segment_end_ = nullptr;
+}
+
+namespace {
+    /**
+     * @brief Paczka o ID z i-tej pozycji kopii - zarejestrowana w domenie właściciela, jeśli kopia tak ją oznacza
+     */
+    Package package_from_snapshot(const PackageSnapshot &snapshot, std::size_t i, PackageIDAllocator *domain) {
+        const ElementID id = snapshot.packages[i].get_id();
+        return snapshot.in_domain[i] != 0 ? Package(*domain, id) : Package(id);
+    }
+
+    void add_to_snapshot(PackageSnapshot &snapshot, const Package &package, const PackageIDAllocator *domain,
+                         const PackageIDAllocator &owner) {
+        snapshot.packages.emplace_back(package.get_id());
+        snapshot.in_domain.push_back(domain == &owner ? 1 : 0);
+    }
+
+    /**
+     * @brief Czy paczka leży w tablicy współdzielonej kopii (index - jej pozycja w kopii)
+     */
+    bool in_snapshot(const PackageSnapshot *snapshot, const Package &p, std::size_t &index) {
+        if (snapshot == nullptr || snapshot->packages.empty()) {
+            return false;
+        }
+        const Package *first = snapshot->packages.data();
+        std::less<const Package *> before;
+        if (before(&p, first) || !before(&p, first + snapshot->packages.size())) {
+            return false;
+        }
+        index = static_cast<std::size_t>(&p - first);
+        return true;
+    }
+}
+
 bool PackageQueue::empty() const {
-    return queue_.empty();
+    return size_ == 0 && base_size() == 0;
 }
 
 Package PackageQueue::pop() {
-    Package result(std::move(queue_.front()));
-    queue_.pop_front();
+    // LIFO: własny bufor zawiera paczki nowsze niż współdzielona kopia, FIFO - starsze są w kopii.
+    if (base_ && (type_ == PackageQueueType::FIFO || size_ == 0)) {
+        return pop_base();
+    }
+    Package result(std::move(buffer_[head_]));
+    buffer_[head_].~Package();
+    head_ = (head_ + 1) & (capacity_ - 1);
+    --size_;
     return result;
-
 }
 
 void PackageQueue::push(Package &&package) {
+    if (size_ == capacity_) {
+        grow();
+    }
     switch (type_) {
         case PackageQueueType::LIFO:
-            queue_.push_front(std::move(package));
+            head_ = (head_ + capacity_ - 1) & (capacity_ - 1);
+            new(buffer_ + head_) Package(std::move(package));
             break;
         case PackageQueueType::FIFO:
-            queue_.push_back(std::move(package));
+            new(buffer_ + ((head_ + size_) & (capacity_ - 1))) Package(std::move(package));
             break;
     }
+    ++size_;
 }
 
-PackageQueue::~PackageQueue() {
-    for (auto &package: queue_) {
+void PackageQueue::clear() {
+    for (std::size_t i = 0; i < size_; ++i) {
+        buffer_[(head_ + i) & (capacity_ - 1)].~Package();
+    }
+    head_ = 0;
+    size_ = 0;
+    release_base();
+}
+
+PackageSpan PackageQueue::segment(std::size_t index) const {
+    // Zawartość bufora cyklicznego to co najwyżej dwa ciągłe fragmenty: od head_ do końca bufora i od jego początku.
+    // Współdzielona kopia jest trzecim fragmentem - w FIFO przed buforem, w LIFO po nim.
+    const bool base_first = type_ == PackageQueueType::FIFO;
+    if (base_first) {
+        if (index == 0) {
+            return base_size() == 0 ? PackageSpan{} : PackageSpan{base_->packages.data() + base_offset_,
+                                                                  base_->packages.data() + base_->packages.size()};
+        }
+        --index;
+    }
+    std::size_t first_length = std::min(size_, capacity_ - head_);
+    switch (index) {
+        case 0:
+            return {buffer_ + head_, buffer_ + head_ + first_length};
+        case 1:
+            return {buffer_, buffer_ + (size_ - first_length)};
+        case 2:
+            if (!base_first && base_size() != 0) {
+                return {base_->packages.data() + base_offset_, base_->packages.data() + base_->packages.size()};
+            }
+            return {};
+        default:
+            return {};
+    }
+}
+
+const PackageIDAllocator *PackageQueue::id_domain(const Package &p) const {
+    std::size_t index = 0;
+    if (in_snapshot(base_.get(), p, index)) {
+        return base_->in_domain[index] != 0 ? base_domain_ : nullptr;
+    }
+    return p.get_domain();
+}
+
+Package PackageQueue::pop_base() {
+    Package result = package_from_snapshot(*base_, base_offset_++, base_domain_);
+    if (base_offset_ == base_->packages.size()) {
+        base_.reset();
+        base_offset_ = 0;
+    }
+    return result;
+}
+
+void PackageQueue::release_base() {
+    if (base_) {
+        // Paczki kopii z domeny właściciela są jego paczkami - ich ID wracają do domeny jak przy zniszczeniu paczki.
+        for (std::size_t i = base_offset_; i < base_->packages.size(); ++i) {
+            if (base_->in_domain[i] != 0) {
+                base_domain_->release(base_->packages[i].get_id());
+            }
+        }
+        base_.reset();
+        base_offset_ = 0;
+    }
+}
+
+std::shared_ptr<const PackageSnapshot> PackageQueue::snapshot(const PackageIDAllocator &domain) const {
+    if (size_ == 0 && base_offset_ == 0 && base_ && base_domain_ == &domain) {
+        return base_;
+    }
+    auto snapshot = std::make_shared<PackageSnapshot>();
+    snapshot->packages.reserve(size());
+    snapshot->in_domain.reserve(size());
+    for (const Package &package: *this) {
+        add_to_snapshot(*snapshot, package, id_domain(package), domain);
+    }
+    return snapshot;
+}
+
+void PackageQueue::grow() {
+    std::allocator<Package> allocator;
+    std::size_t new_capacity = capacity_ == 0 ? 8 : 2 * capacity_;
+    Package *new_buffer = allocator.allocate(new_capacity);
+    for (std::size_t i = 0; i < size_; ++i) {
+        Package &package = buffer_[(head_ + i) & (capacity_ - 1)];
+        new(new_buffer + i) Package(std::move(package));
         package.~Package();
     }
+    if (buffer_ != nullptr) {
+        allocator.deallocate(buffer_, capacity_);
+    }
+    buffer_ = new_buffer;
+    capacity_ = new_capacity;
+    head_ = 0;
+}
+
+PackageQueue::~PackageQueue() {
+    release_base();
+    for (std::size_t i = 0; i < size_; ++i) {
+        buffer_[(head_ + i) & (capacity_ - 1)].~Package();
+    }
+    if (buffer_ != nullptr) {
+        std::allocator<Package>().deallocate(buffer_, capacity_);
+    }
+}
+
+PackageLog::PackageLog(std::shared_ptr<const PackageSnapshot> base, PackageIDAllocator *domain)
+        : base_(base && !base->packages.empty() ? std::move(base) : nullptr), base_domain_(domain) {
+    if (base_) {
+        last_arrival_ = base_->arrivals.back();
+    }
+}
+
+PackageLog::~PackageLog() {
+    release_base();
+}
+
+void PackageLog::push_at(Package &&p, Time t) {
+    if (chunks_.empty() || chunks_.back().packages.size() == kChunkSize) {
+        // Zarezerwowana pojemność nie jest przekraczana, więc paczki we fragmencie nigdy nie zmieniają adresu.
+        Chunk chunk;
+        chunk.packages.reserve(kChunkSize);
+        chunk.arrivals.reserve(kChunkSize);
+        chunks_.push_back(std::move(chunk));
+    }
+    last_arrival_ = std::max(last_arrival_, t);
+    chunks_.back().packages.push_back(std::move(p));
+    chunks_.back().arrivals.push_back(last_arrival_);
+    ++size_;
+}
+
+void PackageLog::clear() {
+    chunks_.clear();
+    size_ = 0;
+    last_arrival_ = 0;
+    release_base();
+}
+
+PackageSpan PackageLog::segment(std::size_t index) const {
+    // Przy współdzielonej kopii (najstarsze paczki) jest ona fragmentem 0, a własne fragmenty następują po niej.
+    if (base_) {
+        if (index == 0) {
+            return {base_->packages.data(), base_->packages.data() + base_->packages.size()};
+        }
+        --index;
+    }
+    if (index >= chunks_.size()) {
+        return {};
+    }
+    const auto &packages = chunks_[index].packages;
+    return {packages.data(), packages.data() + packages.size()};
+}
+
+const PackageIDAllocator *PackageLog::id_domain(const Package &p) const {
+    std::size_t index = 0;
+    if (in_snapshot(base_.get(), p, index)) {
+        return base_->in_domain[index] != 0 ? base_domain_ : nullptr;
+    }
+    return p.get_domain();
+}
+
+void PackageLog::release_base() {
+    if (base_) {
+        for (std::size_t i = 0; i < base_->packages.size(); ++i) {
+            if (base_->in_domain[i] != 0) {
+                base_domain_->release(base_->packages[i].get_id());
+            }
+        }
+        base_.reset();
+    }
+}
+
+std::shared_ptr<const PackageSnapshot> PackageLog::snapshot(const PackageIDAllocator &domain) const {
+    if (size_ == 0 && base_ && base_domain_ == &domain) {
+        return base_;
+    }
+    auto snapshot = std::make_shared<PackageSnapshot>();
+    snapshot->packages.reserve(size());
+    snapshot->in_domain.reserve(size());
+    snapshot->arrivals.reserve(size());
+    std::size_t index = 0;
+    for (const Package &package: *this) {
+        add_to_snapshot(*snapshot, package, id_domain(package), domain);
+        snapshot->arrivals.push_back(arrival_time(index++));
+    }
+    return snapshot;
+}
+
+std::size_t PackageLog::first_arrival_not_before(Time t) const {
+    const std::size_t shared = base_size();
+    if (shared != 0 && base_->arrivals.back() >= t) {
+        return static_cast<std::size_t>(
+                std::lower_bound(base_->arrivals.begin(), base_->arrivals.end(), t) - base_->arrivals.begin());
+    }
+    // Najpierw fragment (po ostatniej turze we fragmencie), potem pozycja wewnątrz niego.
+    auto chunk = std::partition_point(chunks_.begin(), chunks_.end(),
+                                      [t](const Chunk &c) { return c.arrivals.back() < t; });
+    if (chunk == chunks_.end()) {
+        return shared + size_;
+    }
+    auto position = std::lower_bound(chunk->arrivals.begin(), chunk->arrivals.end(), t);
+    return shared + static_cast<std::size_t>(chunk - chunks_.begin()) * kChunkSize +
+           static_cast<std::size_t>(position - chunk->arrivals.begin());
+}
+
+PackageLog::IndexRange PackageLog::arrivals_between(Time a, Time b) const {
+    if (b < a) {
+        return {0, 0};
+    }
+    return {first_arrival_not_before(a), first_arrival_not_before(b + 1)};
+}
+
+AggregateStockpile::AggregateStockpile(TimeOffset interval, std::size_t max_buckets)
+        : interval_(std::max(interval, 1)), max_buckets_(std::max<std::size_t>(max_buckets, 2)) {}
+
+void AggregateStockpile::push_at(Package &&p, Time t) {
+    // Paczka nie jest przechowywana - jej ID wraca do domeny przy wyjściu z funkcji.
+    Package released(std::move(p));
+    ++arrival_count_;
+
+    auto bucket = static_cast<std::size_t>(std::max(t - 1, 0) / interval_);
+    while (bucket >= max_buckets_) {
+        for (std::size_t i = 0; i < histogram_.size(); i += 2) {
+            std::size_t next = i + 1 < histogram_.size() ? histogram_[i + 1] : 0;
+            histogram_[i / 2] = histogram_[i] + next;
+        }
+        histogram_.resize((histogram_.size() + 1) / 2);
+        interval_ *= 2;
+        bucket = static_cast<std::size_t>(std::max(t - 1, 0) / interval_);
+    }
+    if (bucket >= histogram_.size()) {
+        histogram_.resize(bucket + 1, 0);
+    }
+    ++histogram_[bucket];
+}
+
+void AggregateStockpile::clear() {
+    arrival_count_ = 0;
+    histogram_.clear();
+}
+
+void AggregateStockpile::set_state(TimeOffset interval, std::size_t arrival_count, std::vector<std::size_t> histogram) {
+    interval_ = std::max(interval, 1);
+    arrival_count_ = arrival_count;
+    histogram_ = std::move(histogram);
 }
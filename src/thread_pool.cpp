@@ -0,0 +1,85 @@
+#include "thread_pool.hpp"
+
+ThreadPool::ThreadPool(std::size_t threads) {
+    for (std::size_t chunk = 1; chunk < threads; ++chunk) {
+        helpers_.emplace_back(&ThreadPool::helper_loop, this, chunk);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    work_ready_.notify_all();
+    for (auto &helper: helpers_) {
+        helper.join();
+    }
+}
+
+void ThreadPool::run(const std::function<void(std::size_t)> &task) {
+    if (helpers_.empty()) {
+        task(0);
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        task_ = &task;
+        pending_ = helpers_.size();
+        error_ = nullptr;
+        ++generation_;
+    }
+    work_ready_.notify_all();
+    execute(0);
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    work_done_.wait(lock, [this] { return pending_ == 0; });
+    task_ = nullptr;
+    if (error_) {
+        std::exception_ptr error = error_;
+        error_ = nullptr;
+        std::rethrow_exception(error);
+    }
+}
+
+void ThreadPool::parallel_for(std::size_t n, const std::function<void(std::size_t, std::size_t, std::size_t)> &body) {
+    const std::size_t chunks = size();
+    run([n, chunks, &body](std::size_t chunk) {
+        std::size_t begin = chunk * n / chunks;
+        std::size_t end = (chunk + 1) * n / chunks;
+        if (begin < end) {
+            body(begin, end, chunk);
+        }
+    });
+}
+
+void ThreadPool::helper_loop(std::size_t chunk) {
+    std::size_t seen = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            work_ready_.wait(lock, [this, seen] { return stopping_ || generation_ != seen; });
+            if (stopping_) {
+                return;
+            }
+            seen = generation_;
+        }
+        execute(chunk);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            --pending_;
+        }
+        work_done_.notify_one();
+    }
+}
+
+void ThreadPool::execute(std::size_t chunk) {
+    try {
+        (*task_)(chunk);
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!error_) {
+            error_ = std::current_exception();
+        }
+    }
+}
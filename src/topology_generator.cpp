@@ -0,0 +1,189 @@
+#include "topology_generator.hpp"
+
+#include <algorithm>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+TimeOffset TimeDistribution::sample(std::mt19937_64 &rng) const {
+    switch (kind) {
+        case Kind::UNIFORM:
+            return std::uniform_int_distribution<TimeOffset>(a, b)(rng);
+        case Kind::GEOMETRIC:
+            return 1 + std::geometric_distribution<TimeOffset>(1.0 / a)(rng);
+        case Kind::CONSTANT:
+        default:
+            return a;
+    }
+}
+
+namespace {
+    TimeOffset parse_offset(const std::string &text, const std::string &spec) {
+        std::size_t used = 0;
+        TimeOffset value = 0;
+        try {
+            value = std::stoi(text, &used);
+        } catch (const std::exception &) {
+            used = 0;
+        }
+        if (used == 0 || used != text.size() || value < 1) {
+            throw std::invalid_argument("invalid time distribution " + spec);
+        }
+        return value;
+    }
+
+    /**
+     * Grupa kolejnych węzłów jednego typu (warstwa robotników, wszystkie rampy albo wszystkie magazyny)
+     */
+    struct NodeGroup {
+        const char *prefix;
+        std::size_t first_id;
+        std::size_t size;
+    };
+
+    /**
+     * @brief Indeksy (w grupie `to`) odbiorców i-tego z `from_size` nadawców.
+     * Przedziały [ceil(i * n / m), ceil((i + 1) * n / m)) dzielą odbiorców między nadawców, więc każdy odbiorca
+     * ma nadawcę; nadawca z pustym przedziałem dostaje floor(i * n / m). Resztę do fan_out dobiera losowo.
+     */
+    void choose_targets(std::size_t i, std::size_t from_size, std::size_t to_size, std::size_t fan_out,
+                        std::mt19937_64 &rng, std::vector<std::size_t> &targets) {
+        targets.clear();
+        const auto ceil_div = [](std::uint64_t x, std::uint64_t y) { return (x + y - 1) / y; };
+        const std::size_t begin = ceil_div(std::uint64_t(i) * to_size, from_size);
+        const std::size_t end = ceil_div(std::uint64_t(i + 1) * to_size, from_size);
+        for (std::size_t t = begin; t < end; ++t) {
+            targets.push_back(t);
+        }
+        if (targets.empty()) {
+            targets.push_back(std::uint64_t(i) * to_size / from_size);
+        }
+        const std::size_t wanted = std::min(fan_out, to_size);
+        if (wanted == to_size) {
+            targets.clear();
+            for (std::size_t t = 0; t < to_size; ++t) {
+                targets.push_back(t);
+            }
+            return;
+        }
+        std::uniform_int_distribution<std::size_t> pick(0, to_size - 1);
+        while (targets.size() < wanted) {
+            std::size_t t = pick(rng);
+            if (std::find(targets.begin(), targets.end(), t) == targets.end()) {
+                targets.push_back(t);
+            }
+        }
+    }
+
+    void write_links(std::ostream &os, const NodeGroup &from, std::size_t i, const NodeGroup &to,
+                     const std::vector<std::size_t> &targets) {
+        for (std::size_t t: targets) {
+            os << "LINK src=" << from.prefix << "-" << from.first_id + i << " dest=" << to.prefix << "-"
+               << to.first_id + t << "\n";
+        }
+    }
+
+    void validate(const TopologyOptions &options) {
+        if (options.ramps == 0 || options.storehouses == 0) {
+            throw std::invalid_argument("topology needs at least one ramp and one storehouse");
+        }
+        if (options.workers > 0 && (options.depth == 0 || options.depth > options.workers)) {
+            throw std::invalid_argument("depth must be between 1 and the number of workers");
+        }
+        if (options.fan_out == 0) {
+            throw std::invalid_argument("fan-out must be at least 1");
+        }
+        for (double p: {options.back_edge_probability, options.lifo_probability}) {
+            if (!(p >= 0.0 && p <= 1.0)) {
+                throw std::invalid_argument("probability must be within [0, 1]");
+            }
+        }
+        for (const TimeDistribution *d: {&options.delivery_interval, &options.processing_time}) {
+            if (d->a < 1 || (d->kind == TimeDistribution::Kind::UNIFORM && d->b < d->a)) {
+                throw std::invalid_argument("time distribution must produce times of at least 1");
+            }
+        }
+    }
+}
+
+TimeDistribution parse_time_distribution(const std::string &spec) {
+    TimeDistribution distribution;
+    const std::size_t colon = spec.find(':');
+    if (colon == std::string::npos) {
+        distribution.a = distribution.b = parse_offset(spec, spec);
+        return distribution;
+    }
+    const std::string kind = spec.substr(0, colon);
+    const std::string args = spec.substr(colon + 1);
+    if (kind == "uniform") {
+        const std::size_t dash = args.find('-');
+        if (dash == std::string::npos) {
+            throw std::invalid_argument("invalid time distribution " + spec);
+        }
+        distribution.kind = TimeDistribution::Kind::UNIFORM;
+        distribution.a = parse_offset(args.substr(0, dash), spec);
+        distribution.b = parse_offset(args.substr(dash + 1), spec);
+        if (distribution.b < distribution.a) {
+            throw std::invalid_argument("invalid time distribution " + spec);
+        }
+    } else if (kind == "geometric") {
+        distribution.kind = TimeDistribution::Kind::GEOMETRIC;
+        distribution.a = distribution.b = parse_offset(args, spec);
+    } else {
+        throw std::invalid_argument("invalid time distribution " + spec);
+    }
+    return distribution;
+}
+
+void generate_factory_structure(const TopologyOptions &options, std::ostream &os) {
+    validate(options);
+    std::mt19937_64 rng(options.seed);
+    std::bernoulli_distribution lifo(options.lifo_probability);
+    std::bernoulli_distribution back_edge(options.back_edge_probability);
+
+    for (std::size_t id = 1; id <= options.ramps; ++id) {
+        os << "LOADING_RAMP id=" << id << " delivery-interval=" << options.delivery_interval.sample(rng) << "\n";
+    }
+    for (std::size_t id = 1; id <= options.workers; ++id) {
+        os << "WORKER id=" << id << " processing-time=" << options.processing_time.sample(rng)
+           << " queue-type=" << (lifo(rng) ? "LIFO" : "FIFO") << "\n";
+    }
+    for (std::size_t id = 1; id <= options.storehouses; ++id) {
+        os << "STOREHOUSE id=" << id << "\n";
+    }
+
+    const std::size_t depth = options.workers == 0 ? 0 : options.depth;
+    auto layer = [&options, depth](std::size_t l) {
+        const std::size_t first = l * options.workers / depth;
+        return NodeGroup{"worker", first + 1, (l + 1) * options.workers / depth - first};
+    };
+    const NodeGroup ramps{"ramp", 1, options.ramps};
+    const NodeGroup storehouses{"store", 1, options.storehouses};
+
+    std::vector<std::size_t> targets;
+    const NodeGroup first_receivers = depth == 0 ? storehouses : layer(0);
+    for (std::size_t i = 0; i < ramps.size; ++i) {
+        choose_targets(i, ramps.size, first_receivers.size, options.fan_out, rng, targets);
+        write_links(os, ramps, i, first_receivers, targets);
+    }
+    for (std::size_t l = 0; l < depth; ++l) {
+        const NodeGroup senders = layer(l);
+        const NodeGroup receivers = l + 1 == depth ? storehouses : layer(l + 1);
+        for (std::size_t i = 0; i < senders.size; ++i) {
+            choose_targets(i, senders.size, receivers.size, options.fan_out, rng, targets);
+            write_links(os, senders, i, receivers, targets);
+            if (l > 0 && back_edge(rng)) {
+                // Połączenie wsteczne do robotnika z dowolnej wcześniejszej warstwy (ID 1 .. senders.first_id - 1).
+                std::uniform_int_distribution<std::size_t> earlier(1, senders.first_id - 1);
+                os << "LINK src=worker-" << senders.first_id + i << " dest=worker-" << earlier(rng) << "\n";
+            }
+        }
+    }
+}
+
+std::string generate_factory_structure(const TopologyOptions &options) {
+    std::ostringstream oss;
+    generate_factory_structure(options, oss);
+    return oss.str();
+}
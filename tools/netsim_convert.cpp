@@ -0,0 +1,63 @@
+/**
+ * netsim_convert - konwersja struktury fabryki między formatem tekstowym a binarnym.
+ *
+ * Użycie: netsim_convert (--to-binary | --to-text) <plik-wejściowy> <plik-wyjściowy>
+ *
+ * Format wejścia jest rozpoznawany po sygnaturze pliku binarnego, więc konwersja w tę samą stronę
+ * (np. tekst -> tekst) też działa - porządkuje wtedy plik tak jak save_factory_structure().
+ */
+
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include "factory.hpp"
+#include "factory_binary.hpp"
+
+namespace {
+    void print_usage(std::ostream &os) {
+        os << "usage: netsim_convert (--to-binary | --to-text) <input> <output>\n";
+    }
+}
+
+int main(int argc, char *argv[]) {
+    if (argc != 4 || (std::string(argv[1]) != "--to-binary" && std::string(argv[1]) != "--to-text")) {
+        print_usage(std::cerr);
+        return 2;
+    }
+    const bool to_binary = std::string(argv[1]) == "--to-binary";
+    const std::string input = argv[2];
+    const std::string output = argv[3];
+
+    try {
+        std::ifstream in(input, std::ios::binary);
+        if (!in) {
+            std::cerr << "netsim_convert: cannot open " << input << "\n";
+            return 1;
+        }
+        const std::string bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        in.close();
+        Factory factory = factory_binary::is_binary_structure(bytes.data(), bytes.size())
+                          ? load_factory_structure_binary(bytes.data(), bytes.size())
+                          : load_factory_structure(std::string_view(bytes));
+
+        std::ofstream out(output, to_binary ? std::ios::binary : std::ios::out);
+        if (!out) {
+            std::cerr << "netsim_convert: cannot open " << output << "\n";
+            return 1;
+        }
+        if (to_binary) {
+            save_factory_structure_binary(factory, out);
+        } else {
+            save_factory_structure(factory, out);
+        }
+        if (!out) {
+            std::cerr << "netsim_convert: cannot write " << output << "\n";
+            return 1;
+        }
+    } catch (const std::exception &e) {
+        std::cerr << "netsim_convert: " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,89 @@
+/**
+ * netsim_generate - generator syntetycznych struktur fabryki (format tekstowy load_factory_structure()).
+ *
+ * Użycie: netsim_generate [--ramps R] [--workers W] [--storehouses S] [--depth D] [--fan-out F]
+ *                         [--back-edges P] [--lifo P] [--delivery SPEC] [--processing SPEC] [--seed N] [-o plik]
+ *
+ * SPEC to rozkład czasów: "N" (stały), "uniform:A-B" albo "geometric:M" (średnia M).
+ * Wygenerowana struktura zawsze przechodzi is_consistent(); bez -o jest zapisywana na standardowe wyjście.
+ */
+
+#include <fstream>
+#include <iostream>
+#include <string>
+#include "topology_generator.hpp"
+
+namespace {
+    void print_usage(std::ostream &os) {
+        os << "usage: netsim_generate [--ramps R] [--workers W] [--storehouses S] [--depth D] [--fan-out F]"
+              " [--back-edges P] [--lifo P] [--delivery SPEC] [--processing SPEC] [--seed N] [-o output]\n"
+              "SPEC: N | uniform:A-B | geometric:MEAN\n";
+    }
+}
+
+int main(int argc, char *argv[]) {
+    TopologyOptions options;
+    std::string output;
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            auto value = [&]() -> std::string {
+                if (i + 1 >= argc) {
+                    throw std::invalid_argument("missing value for " + arg);
+                }
+                return argv[++i];
+            };
+            if (arg == "--ramps") {
+                options.ramps = std::stoul(value());
+            } else if (arg == "--workers") {
+                options.workers = std::stoul(value());
+            } else if (arg == "--storehouses") {
+                options.storehouses = std::stoul(value());
+            } else if (arg == "--depth") {
+                options.depth = std::stoul(value());
+            } else if (arg == "--fan-out") {
+                options.fan_out = std::stoul(value());
+            } else if (arg == "--back-edges") {
+                options.back_edge_probability = std::stod(value());
+            } else if (arg == "--lifo") {
+                options.lifo_probability = std::stod(value());
+            } else if (arg == "--delivery") {
+                options.delivery_interval = parse_time_distribution(value());
+            } else if (arg == "--processing") {
+                options.processing_time = parse_time_distribution(value());
+            } else if (arg == "--seed") {
+                options.seed = std::stoull(value());
+            } else if (arg == "-o") {
+                output = value();
+            } else {
+                throw std::invalid_argument("unknown option " + arg);
+            }
+        }
+    } catch (const std::exception &e) {
+        std::cerr << "netsim_generate: " << e.what() << "\n";
+        print_usage(std::cerr);
+        return 2;
+    }
+
+    try {
+        if (output.empty()) {
+            std::ios::sync_with_stdio(false);
+            generate_factory_structure(options, std::cout);
+            return std::cout ? 0 : 1;
+        }
+        std::ofstream out(output);
+        if (!out) {
+            std::cerr << "netsim_generate: cannot open " << output << "\n";
+            return 1;
+        }
+        generate_factory_structure(options, out);
+        if (!out) {
+            std::cerr << "netsim_generate: cannot write " << output << "\n";
+            return 1;
+        }
+    } catch (const std::exception &e) {
+        std::cerr << "netsim_generate: " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}